@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+#include "map/chunk.h"
+#include "map/chunk_coordinates.h"
+#include "map/game_map.h"
+
+/// <summary>
+/// Steers enemies towards a target around tiles that can't be walked on,
+/// covering the hot region of the map.
+///
+/// Rather than each enemy finding its own path, one search runs outwards
+/// from the target over the tiles, and every tile is left pointing at the
+/// neighbour that is closest to the target. An enemy only has to look up
+/// the tile it is standing on, so any number of them can follow the same
+/// field for the cost of building it once.
+///
+/// Tiles that can see the target in a straight line are flagged, and
+/// enemies on them head straight for it instead, since following tiles
+/// would only let them move in eight directions. The field is only rebuilt
+/// when the target moves onto another tile or the map is recentered.
+/// </summary>
+class FlowField
+{
+public:
+	/// <summary>
+	/// The number of tiles along each side of the field.
+	/// </summary>
+	static constexpr int WIDTH = HOT_CACHE_CHUNK_WIDTH * CHUNK_WIDTH;
+
+	FlowField();
+	FlowField(const FlowField&) = delete;
+	FlowField& operator=(const FlowField&) = delete;
+	~FlowField() = default;
+
+	/// <summary>
+	/// Fetch which way to go from a position to reach the target.
+	/// </summary>
+	/// <param name="x">The x coordinate of the position in the world.</param>
+	/// <param name="z">The z coordinate of the position in the world.</param>
+	/// <param name="straight">The normalized direction straight at the
+	/// target, which is used wherever nothing is in the way or there is no
+	/// path.</param>
+	/// <returns>The normalized direction to move in.</returns>
+	[[nodiscard]] glm::vec2 direction(const float x, const float z,
+		const glm::vec2& straight) const noexcept;
+
+	/// <summary>
+	/// Copy which tiles can be walked on from the hot chunks of the map, if
+	/// it has been recentered since the last time.
+	/// </summary>
+	/// <param name="map">The map, which the caller must stop from changing
+	/// while this runs.</param>
+	void load(const GameMap& map);
+
+	/// <summary>
+	/// Rebuild the field if the target has moved onto a different tile, or
+	/// the map has been loaded again since it was last built.
+	/// </summary>
+	/// <param name="x">The x coordinate of the target in the world.</param>
+	/// <param name="z">The z coordinate of the target in the world.</param>
+	void update(const float x, const float z);
+
+private:
+	/// <summary>
+	/// Stored for tiles that have no direction of their own, because they
+	/// are the target, can't be walked on, or can't reach the target.
+	/// </summary>
+	static constexpr uint8_t NO_DIRECTION = 8;
+
+	/// <summary>
+	/// How many buckets of tiles the search keeps, which has to be more than
+	/// the cost of the most expensive step.
+	/// </summary>
+	static constexpr size_t BUCKET_COUNT = 4;
+
+	/// <summary>
+	/// Whether tiles have been loaded from a map yet.
+	/// </summary>
+	bool loaded;
+
+	/// <summary>
+	/// Whether the tiles have changed since the field was last built.
+	/// </summary>
+	bool stale;
+
+	/// <summary>
+	/// Whether any tile in the field can't be walked on. If not, everything
+	/// can see the target and the search is skipped.
+	/// </summary>
+	bool any_blocked;
+
+	/// <summary>
+	/// The chunk that the field is centered on.
+	/// </summary>
+	ChunkCoordinates center;
+
+	/// <summary>
+	/// The global x coordinate of the first column of tiles.
+	/// </summary>
+	int origin_x;
+
+	/// <summary>
+	/// The global z coordinate of the first row of tiles.
+	/// </summary>
+	int origin_z;
+
+	/// <summary>
+	/// The global x coordinate of the tile the target was on when the field
+	/// was built.
+	/// </summary>
+	int target_x;
+
+	/// <summary>
+	/// The global z coordinate of the tile the target was on when the field
+	/// was built.
+	/// </summary>
+	int target_z;
+
+	/// <summary>
+	/// Whether the target was inside the field when it was built. If not,
+	/// everything heads straight for it.
+	/// </summary>
+	bool target_inside;
+
+	/// <summary>
+	/// Whether each tile can be walked on, indexed by x * WIDTH + z.
+	/// </summary>
+	std::vector<uint8_t> walkable;
+
+	/// <summary>
+	/// Whether each tile has a clear line to the target.
+	/// </summary>
+	std::vector<uint8_t> visible;
+
+	/// <summary>
+	/// The neighbour each tile points towards, as an index into the
+	/// neighbour offsets, or NO_DIRECTION.
+	/// </summary>
+	std::vector<uint8_t> directions;
+
+	/// <summary>
+	/// The cost of the path from each tile to the target, kept between
+	/// builds to avoid allocating.
+	/// </summary>
+	std::vector<uint16_t> costs;
+
+	/// <summary>
+	/// The tiles waiting to be searched, by path cost modulo the number of
+	/// buckets, kept between builds to avoid allocating.
+	/// </summary>
+	std::vector<uint32_t> buckets[BUCKET_COUNT];
+
+	/// <summary>
+	/// Search outwards from the target, working out the cost to reach it from
+	/// every tile and which way each tile should point.
+	/// </summary>
+	/// <param name="target">The index of the target tile.</param>
+	void build_directions(const uint32_t target);
+
+	/// <summary>
+	/// Work out which tiles have a clear line to the target.
+	/// </summary>
+	/// <param name="target">The index of the target tile.</param>
+	void build_visibility(const uint32_t target);
+
+	/// <summary>
+	/// Check if every tile a line between the centers of two tiles passes
+	/// through can be walked on.
+	/// </summary>
+	/// <param name="from_x">The x index of the first tile.</param>
+	/// <param name="from_z">The z index of the first tile.</param>
+	/// <param name="to_x">The x index of the second tile.</param>
+	/// <param name="to_z">The z index of the second tile.</param>
+	/// <returns>Whether the line is clear.</returns>
+	[[nodiscard]] bool line_clear(int from_x, int from_z, const int to_x,
+		const int to_z) const noexcept;
+};
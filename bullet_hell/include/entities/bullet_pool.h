@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+#include "entities/entity_types.h"
+
+
+/// <summary>
+/// How long bullets last before despawning, measured in seconds.
+/// </summary>
+constexpr float BULLET_LIFESPAN = 3.0f;
+
+/// <summary>
+/// The base movement speed of bullets, in world units per second, which is
+/// three times the base movement speed of the player.
+/// </summary>
+constexpr float BULLET_MOVE_SPEED_PER_SECOND = 15.0f;
+
+/// <summary>
+/// Tracks projectiles in the scene, stored as a structure of arrays so that
+/// updating every bullet walks contiguous memory.
+///
+/// Bullets are referenced by index. Releasing a bullet moves the last bullet
+/// into the released slot, so indices are only stable until the next
+/// release.
+/// </summary>
+class BulletPool
+{
+public:
+	/// <summary>
+	/// The x coordinate of each bullet, in world units.
+	/// </summary>
+	std::vector<float> position_x;
+
+	/// <summary>
+	/// The y coordinate of each bullet, in world units.
+	/// </summary>
+	std::vector<float> position_y;
+
+	/// <summary>
+	/// The z coordinate of each bullet, in world units.
+	/// </summary>
+	std::vector<float> position_z;
+
+	/// <summary>
+	/// The x component of the normalized direction each bullet is moving in.
+	/// </summary>
+	std::vector<float> direction_x;
+
+	/// <summary>
+	/// The z component of the normalized direction each bullet is moving in.
+	/// </summary>
+	std::vector<float> direction_z;
+
+	/// <summary>
+	/// The speed of each bullet, in world units per second.
+	/// </summary>
+	std::vector<float> speed;
+
+	/// <summary>
+	/// How much damage each bullet will do if it collides with something it
+	/// is hostile to.
+	/// </summary>
+	std::vector<Health> damage;
+
+	/// <summary>
+	/// How long each bullet has left before it despawns, measured in seconds.
+	/// </summary>
+	std::vector<float> lifetime;
+
+	/// <summary>
+	/// The scene entity for each bullet. Empty if nothing is displaying the
+	/// bullets.
+	/// </summary>
+	std::vector<EntityHandle> scene_entity;
+
+	/// <summary>
+	/// Set up a pool of bullets.
+	/// </summary>
+	/// <param name="add_entity">Called with each new bullet entity, or null
+	/// if bullets do not need to be displayed.</param>
+	/// <param name="model_ID">The ID of the model used for the bullets.
+	/// </param>
+	/// <param name="capacity">How many bullets to allocate space for up
+	/// front.</param>
+	BulletPool(const EntityHandler& add_entity, const std::string& model_ID,
+		const size_t capacity);
+	BulletPool(const BulletPool&) = delete;
+	BulletPool& operator=(const BulletPool&) = delete;
+	~BulletPool();
+
+	/// <summary>
+	/// Move every bullet along its direction and age it.
+	/// </summary>
+	/// <param name="delta_time">The time that has passed, in seconds.</param>
+	void advance(const float delta_time) noexcept;
+
+	/// <summary>
+	/// Release every bullet.
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Check whether there are any live bullets.
+	/// </summary>
+	/// <returns>Whether the pool is empty.</returns>
+	[[nodiscard]] bool empty() const noexcept;
+
+	/// <summary>
+	/// Release a bullet, moving the last bullet into its slot.
+	/// </summary>
+	/// <param name="index">The index of the bullet to release.</param>
+	void release(const size_t index);
+
+	/// <summary>
+	/// Release all of the bullets that have run out of lifetime.
+	/// </summary>
+	void release_expired();
+
+	/// <summary>
+	/// Release every bullet that hit something, each exactly once.
+	/// </summary>
+	/// <param name="hit_masks">Which bullets hit, as written by
+	/// CollisionKernel::find_within for every bullet in the pool.</param>
+	/// <returns>The total damage of the bullets that hit.</returns>
+	Health release_hits(const uint8_t* hit_masks);
+
+	/// <summary>
+	/// Fetch the number of live bullets.
+	/// </summary>
+	/// <returns>How many bullets are in the pool.</returns>
+	[[nodiscard]] size_t size() const noexcept;
+
+	/// <summary>
+	/// Create a new bullet.
+	/// </summary>
+	/// <param name="position">Where the bullet starts, in world units.
+	/// </param>
+	/// <param name="direction">The normalized direction the bullet travels,
+	/// as x and z components.</param>
+	/// <param name="speed">The speed of the bullet, in world units per
+	/// second.</param>
+	/// <param name="damage">How much damage the bullet does.</param>
+	void spawn(const glm::vec3& position, const glm::vec2& direction,
+		const float speed, const Health damage);
+
+	/// <summary>
+	/// Create a batch of new bullets, all at the same height and with the
+	/// same speed and damage. Each array is copied over in one go rather than
+	/// a bullet at a time.
+	/// </summary>
+	/// <param name="count">The number of bullets.</param>
+	/// <param name="x">The x coordinate each bullet starts at.</param>
+	/// <param name="y">The y coordinate every bullet starts at.</param>
+	/// <param name="z">The z coordinate each bullet starts at.</param>
+	/// <param name="direction_x">The x component of the normalized direction
+	/// each bullet travels.</param>
+	/// <param name="direction_z">The z component of the normalized direction
+	/// each bullet travels.</param>
+	/// <param name="speed">The speed of the bullets, in world units per
+	/// second.</param>
+	/// <param name="damage">How much damage each bullet does.</param>
+	void spawn_batch(const size_t count, const float* x, const float y,
+		const float* z, const float* direction_x, const float* direction_z,
+		const float speed, const Health damage);
+
+	/// <summary>
+	/// Copy bullet positions over to their scene entities and update the
+	/// model matrices.
+	/// </summary>
+	void update_scene_entities();
+
+private:
+	/// <summary>
+	/// Called with each new bullet entity, may be null.
+	/// </summary>
+	const EntityHandler add_entity;
+
+	/// <summary>
+	/// The ID of the model used for bullet entities.
+	/// </summary>
+	const std::string model_ID;
+};
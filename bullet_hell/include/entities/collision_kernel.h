@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Narrow phase collision checks that test many points against a single
+/// point at once. The points are passed as separate x and z arrays, so the
+/// same kernel can test a batch of bullets against a pawn, or a bullet
+/// against a batch of pawns.
+///
+/// The widest instruction set the processor supports is picked at startup,
+/// falling back to plain scalar code. Every version gives exactly the same
+/// results as the scalar one.
+/// </summary>
+namespace CollisionKernel
+{
+	/// <summary>
+	/// The instruction sets that the kernel can run with.
+	/// </summary>
+	enum class InstructionSet
+	{
+		SCALAR,
+		SSE2,
+		AVX2,
+	};
+
+	/// <summary>
+	/// Check if a point is within a radius of a center point, on the x/z
+	/// plane. This is the reference that all of the batched versions match.
+	/// </summary>
+	/// <param name="x">The x coordinate of the point.</param>
+	/// <param name="z">The z coordinate of the point.</param>
+	/// <param name="center_x">The x coordinate of the center.</param>
+	/// <param name="center_z">The z coordinate of the center.</param>
+	/// <param name="radius_squared">The square of the radius.</param>
+	/// <returns>Whether the point is within the radius.</returns>
+	[[nodiscard]] inline bool within(const float x, const float z,
+		const float center_x, const float center_z,
+		const float radius_squared) noexcept
+	{
+		const float dx = x - center_x;
+		const float dz = z - center_z;
+		return dx * dx + dz * dz <= radius_squared;
+	}
+
+	/// <summary>
+	/// Find the first point that is within a radius of a center point.
+	/// </summary>
+	/// <param name="x">The x coordinates of the points.</param>
+	/// <param name="z">The z coordinates of the points.</param>
+	/// <param name="count">The number of points.</param>
+	/// <param name="center_x">The x coordinate of the center.</param>
+	/// <param name="center_z">The z coordinate of the center.</param>
+	/// <param name="radius_squared">The square of the radius.</param>
+	/// <returns>The index of the first point within the radius, or count if
+	/// there are none.</returns>
+	[[nodiscard]] size_t find_first_within(const float* x, const float* z,
+		const size_t count, const float center_x, const float center_z,
+		const float radius_squared) noexcept;
+
+	/// <summary>
+	/// Find all of the points that are within a radius of a center point.
+	/// </summary>
+	/// <param name="x">The x coordinates of the points.</param>
+	/// <param name="z">The z coordinates of the points.</param>
+	/// <param name="count">The number of points.</param>
+	/// <param name="center_x">The x coordinate of the center.</param>
+	/// <param name="center_z">The z coordinate of the center.</param>
+	/// <param name="radius_squared">The square of the radius.</param>
+	/// <param name="hit_masks">Where to write the results, which needs room
+	/// for mask_count(count) entries. Bit j of entry i is set if point
+	/// i * 8 + j is within the radius.</param>
+	void find_within(const float* x, const float* z, const size_t count,
+		const float center_x, const float center_z, const float radius_squared,
+		uint8_t* hit_masks) noexcept;
+
+	/// <summary>
+	/// Fetch the instruction set that the kernel is currently using.
+	/// </summary>
+	/// <returns>The active instruction set.</returns>
+	[[nodiscard]] InstructionSet get_instruction_set() noexcept;
+
+	/// <summary>
+	/// Calculate how many hit masks are needed for a number of points.
+	/// </summary>
+	/// <param name="count">The number of points.</param>
+	/// <returns>The number of 8 bit masks needed.</returns>
+	[[nodiscard]] constexpr size_t mask_count(const size_t count) noexcept
+	{
+		return (count + 7) / 8;
+	}
+
+	/// <summary>
+	/// Switch which instruction set the kernel uses, which is mostly useful
+	/// for comparing them while debugging.
+	/// </summary>
+	/// <param name="instruction_set">The instruction set to use.</param>
+	/// <returns>Whether the processor supports the instruction set. If not,
+	/// nothing is changed.</returns>
+	bool set_instruction_set(const InstructionSet instruction_set) noexcept;
+
+	/// <summary>
+	/// Find the widest instruction set that this processor supports.
+	/// </summary>
+	/// <returns>The best supported instruction set.</returns>
+	[[nodiscard]] InstructionSet supported_instruction_set() noexcept;
+}
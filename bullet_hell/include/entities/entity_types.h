@@ -1,7 +1,16 @@
 #pragma once
 
+#include "Delegate.h"
+
+#include "graphics/scene/entity.h"
+
 /// <summary>
 /// The storage format for health and damage values.
 /// </summary>
 using Health = int;
 
+/// <summary>
+/// Called with each scene entity that gets created for a pawn or bullet, so
+/// that whatever is displaying the game can keep track of it.
+/// </summary>
+using EntityHandler = SA::delegate<void(EntityHandle)>;
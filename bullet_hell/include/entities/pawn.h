@@ -7,8 +7,6 @@
 #include "ai/ai_state.h"
 #include "entities/entity_types.h"
 
-struct Entity;
-
 /// <summary>
 /// The number of seconds between enmey attacks.
 /// </summary>
@@ -71,7 +69,7 @@ struct Pawn
 	/// The scene enitity that this pawn is tracking, so that we can move 
 	/// it around or trigger an animation.
 	/// </summary>
-	std::shared_ptr<Entity> scene_entity;
+	EntityHandle scene_entity;
 
 	/// <summary>
 	/// Indicates that the pawn wants to attack.
@@ -79,17 +77,12 @@ struct Pawn
 	bool wants_to_attack = false;
 
 	Pawn();
-	Pawn(std::shared_ptr<Entity> entity, Health health = 0);
+	Pawn(const EntityHandle entity, Health health = 0);
 	Pawn(const Pawn&) = default;
 	Pawn& operator=(const Pawn&) = default;
 	~Pawn();
 
 private:
-	/// <summary>
-	/// Whether we have made an update to the corresponding scene entity.
-	/// </summary>
-	bool needs_updating = false;
-
 	/// <summary>
 	/// What the pawn is currently doing. Only relevant for AI controlled
 	/// pawns.
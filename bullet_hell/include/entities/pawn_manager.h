@@ -1,19 +1,87 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
-#include "boost/circular_buffer.hpp"
+#include "glm/vec3.hpp"
+#include "glm/ext/quaternion_float.hpp"
 
-#include "entities/bullet.h"
+#include "ai/flow_field.h"
+#include "entities/bullet_emitter.h"
+#include "entities/bullet_pool.h"
+#include "entities/entity_types.h"
 #include "entities/pawn.h"
+#include "entities/spatial_grid.h"
 #include "graphics/graph/animation.h"
+#include "graphics/scene/frustum.h"
+#include "map/chunk_coordinates.h"
 
 /// <summary>
 /// How long the fixed timestep is for the pawn manager, in seconds.
 /// </summary>
 constexpr double SIMULATION_TIMESTEP = 1.0f / 60.0f;
 
+/// <summary>
+/// How many timesteps apart the map is recentered on the player, counting
+/// from the start of each game.
+/// </summary>
+constexpr uint64_t MAP_RECENTER_TICKS = 60;
+
+/// <summary>
+/// The models and animations used to display pawns and bullets.
+/// </summary>
+struct PawnAssets
+{
+	std::string player_model_id;
+	std::shared_ptr<Animation> player_attack_animation;
+	std::shared_ptr<Animation> player_idle_animation;
+	std::shared_ptr<Animation> player_running_animation;
+
+	std::string enemy_model_id;
+	std::shared_ptr<Animation> enemy_attack_animation;
+	std::shared_ptr<Animation> enemy_idle_animation;
+	std::shared_ptr<Animation> enemy_running_animation;
+
+	std::string enemy_bullet_model_id;
+	std::string player_bullet_model_id;
+
+	/// <summary>
+	/// What enemies fire when they attack.
+	/// </summary>
+	BulletPattern enemy_bullet_pattern{ .damage = 100 };
+
+	/// <summary>
+	/// What the player fires when they attack.
+	/// </summary>
+	BulletPattern player_bullet_pattern{ .damage = 50 };
+};
+
+/// <summary>
+/// Where the game is being watched from, so that enemies that are far away
+/// or offscreen can spend less time animating.
+/// </summary>
+struct Viewpoint
+{
+	/// <summary>
+	/// The position of the camera in world space.
+	/// </summary>
+	glm::vec3 position{ 0.0f };
+
+	/// <summary>
+	/// What the camera can see.
+	/// </summary>
+	Frustum frustum;
+
+	/// <summary>
+	/// Whether anything is watching. If not, everything animates at the
+	/// full rate.
+	/// </summary>
+	bool watching = false;
+};
+
 /// <summary>
 /// Tracks all the players, bullets, and enemies.
 /// </summary>
@@ -22,7 +90,17 @@ class PawnManager
 public:
 	friend class Brain;
 
-	PawnManager();
+	/// <summary>
+	/// Set up the pawn manager and the player.
+	/// </summary>
+	/// <param name="assets">The models and animations to use. Animations
+	/// must have at least one frame.</param>
+	/// <param name="add_entity">Called with each scene entity that gets
+	/// created. May be null if nothing is displaying the game.</param>
+	/// <param name="seed">The seed for all of the randomness in the game.
+	/// The same seed and player input always play out the same way.</param>
+	PawnManager(const PawnAssets& assets, const EntityHandler& add_entity,
+		const uint32_t seed);
 	PawnManager(const PawnManager&) = delete;
 	PawnManager& operator=(const PawnManager&) = delete;
 	~PawnManager() = default;
@@ -30,26 +108,92 @@ public:
 	/// <summary>
 	/// Resets as if we had just started a new game.
 	/// </summary>
-	void reset();
+	/// <param name="seed">The seed for all of the randomness in the new
+	/// game.</param>
+	void reset(const uint32_t seed);
 
 	/// <summary>
-	/// Update everything the pawn manager cares about.
+	/// Spawn enemies at random locations around the player, regardless of
+	/// the usual enemy limit.
 	/// </summary>
-	void tick();
+	/// <param name="count">The number of enemies to spawn.</param>
+	void spawn_enemies(const size_t count);
 
 	/// <summary>
-	/// Update the animations for things that the pawn manager cares about.
+	/// Fetch how many enemies are asleep in cold chunks. These are not part
+	/// of the enemy list.
 	/// </summary>
-	void tick_animations();
+	/// <returns>The number of sleeping enemies.</returns>
+	[[nodiscard]] size_t sleeping_enemy_count() const noexcept;
+
+	/// <summary>
+	/// Let the pawn manager know what the map has loaded. Has to be called
+	/// whenever the map is created, reset, or recentered, with nothing else
+	/// changing it at the same time.
+	///
+	/// Enemies only run while they are in the hot region. In the cold region
+	/// they sleep, and beyond that they are despawned along with the chunk
+	/// they were in. Chasing enemies find their way around the tiles of the
+	/// hot region.
+	/// </summary>
+	/// <param name="map">The map.</param>
+	void set_map(const GameMap& map);
+
+	/// <summary>
+	/// Recenter the map on the player and pass it on to set_map, if the last
+	/// tick was one that the map is recentered on. Recentering decides which
+	/// enemies sleep or despawn, so it has to happen on the same ticks every
+	/// time a game is played, and never in between ticks.
+	/// </summary>
+	/// <param name="map">The map.</param>
+	void recenter_map_when_due(GameMap& map);
 
-	boost::circular_buffer<std::shared_ptr<Bullet>> player_bullets;
-	boost::circular_buffer<std::shared_ptr<Bullet>> enemy_bullets;
+	/// <summary>
+	/// Update everything the pawn manager cares about, including advancing
+	/// animations whenever an animation frame is due.
+	/// </summary>
+	void tick();
+
+	BulletPool player_bullets;
+	BulletPool enemy_bullets;
 
 	std::shared_ptr<Pawn> player;
 	std::vector<std::shared_ptr<Pawn>> enemies;
 
+	/// <summary>
+	/// Whether to cut back on work that the game can do without, because the
+	/// simulation is falling behind. Enemies rethink what they are doing less
+	/// often and animate at a lower frame rate, but the player is unaffected.
+	/// Changes how the game plays out, so it is recorded along with the
+	/// player input for replays.
+	/// </summary>
+	bool shedding_load;
+
+	/// <summary>
+	/// Where the game is being watched from, which decides how often each
+	/// enemy animates.
+	/// </summary>
+	Viewpoint viewpoint;
+
 private:
 
+	/// <summary>
+	/// An enemy that is asleep in a cold chunk. Its scene entity is
+	/// destroyed while it sleeps, so that it costs nothing to simulate or
+	/// draw, and this is what we need to put it back.
+	/// </summary>
+	struct SleepingEnemy
+	{
+		std::shared_ptr<Pawn> pawn;
+		glm::vec3 position;
+		glm::quat rotation;
+	};
+
+	/// <summary>
+	/// Called with each scene entity that gets created.
+	/// </summary>
+	EntityHandler add_entity;
+
 	std::shared_ptr<Animation> player_attack_animation;
 	std::shared_ptr<Animation> player_idle_animation;
 	std::shared_ptr<Animation> player_running_animation;
@@ -59,21 +203,115 @@ private:
 	std::shared_ptr<Animation> enemy_idle_animation;
 	std::shared_ptr<Animation> enemy_running_animation;
 
-	std::string enemy_bullet_model_id;
-	std::string player_bullet_model_id;
+	/// <summary>
+	/// Fires enemy bullet patterns.
+	/// </summary>
+	BulletEmitter enemy_emitter;
+
+	/// <summary>
+	/// Fires player bullet patterns.
+	/// </summary>
+	BulletEmitter player_emitter;
+
+	/// <summary>
+	/// The pattern enemies fire when they attack.
+	/// </summary>
+	PatternID enemy_pattern;
+
+	/// <summary>
+	/// The pattern the player fires when they attack.
+	/// </summary>
+	PatternID player_pattern;
 
 	double seconds_since_enemy_spawn = 0;
 
 	/// <summary>
-	/// Used to generate random numbers for the manager.
+	/// The chunk the map is loaded around.
 	/// </summary>
-	std::mt19937 random;
+	ChunkCoordinates map_center;
+
+	/// <summary>
+	/// Leads chasing enemies to the player around anything in the way.
+	/// </summary>
+	FlowField flow_field;
+
+	/// <summary>
+	/// The enemies that are asleep, by the combined coordinates of the chunk
+	/// they are in. They don't move while asleep, so they stay put.
+	/// </summary>
+	std::unordered_map<uint32_t, std::vector<SleepingEnemy>> sleeping_enemies;
+
+	/// <summary>
+	/// The total number of sleeping enemies across all chunks.
+	/// </summary>
+	size_t sleeping_count;
 
 	/// <summary>
-	/// A random distribution used for calculating offsets from the player 
-	/// while spawning enemies.
+	/// The map center that the sleeping enemies were last sorted against.
 	/// </summary>
-	std::uniform_real_distribution<double> spawn_offset;
+	ChunkCoordinates sleep_center;
+
+	/// <summary>
+	/// An index of where the enemies were after the AI ran this tick, before
+	/// they moved, for collision and targeting queries.
+	/// </summary>
+	SpatialGrid enemy_grid;
+
+	/// <summary>
+	/// Which share of the enemies rethink what they are doing this tick,
+	/// while shedding load.
+	/// </summary>
+	size_t shed_ai_phase;
+
+	/// <summary>
+	/// Counts animation frames, so that enemies animating at a lower rate
+	/// know when it is their turn.
+	/// </summary>
+	size_t animation_frame_count;
+
+	/// <summary>
+	/// Simulated seconds since the last animation frame advanced.
+	/// </summary>
+	double seconds_since_animation_frame;
+
+	/// <summary>
+	/// The number of ticks since the game started.
+	/// </summary>
+	uint64_t game_ticks;
+
+	/// <summary>
+	/// The x coordinates of the enemies, gathered along with the grid.
+	/// </summary>
+	std::vector<float> enemy_x;
+
+	/// <summary>
+	/// The z coordinates of the enemies, gathered along with the grid.
+	/// </summary>
+	std::vector<float> enemy_z;
+
+	/// <summary>
+	/// The x component of how far each enemy is being pushed away from the
+	/// enemies around it this tick.
+	/// </summary>
+	std::vector<float> separation_x;
+
+	/// <summary>
+	/// The z component of how far each enemy is being pushed away from the
+	/// enemies around it this tick.
+	/// </summary>
+	std::vector<float> separation_z;
+
+	/// <summary>
+	/// Which enemy bullets hit the player this tick, as collision kernel hit
+	/// masks.
+	/// </summary>
+	std::vector<uint8_t> enemy_bullet_hits;
+
+	/// <summary>
+	/// Used to generate random numbers for the manager. All randomness that
+	/// affects the game goes through this, so a seed determines the game.
+	/// </summary>
+	std::mt19937 random;
 
 	/// <summary>
 	/// Find the direction that the player would have to face in order to
@@ -83,15 +321,74 @@ private:
 	[[nodiscard]] glm::vec2 find_enemy_nearest_player();
 	
 	/// <summary>
-	/// Fires a bullet wherever the enemy is looking.
+	/// Find the first enemy that a player bullet collides with, by checking
+	/// the bullet against every enemy. The enemy positions must have been
+	/// gathered.
+	/// </summary>
+	/// <param name="x">The x coordinate of the bullet.</param>
+	/// <param name="z">The z coordinate of the bullet.</param>
+	/// <returns>The index of the enemy that was hit, or the number of
+	/// enemies if there was none.</returns>
+	[[nodiscard]] size_t find_bullet_target(const float x, const float z)
+		const noexcept;
+
+	/// <summary>
+	/// Find the first enemy that a player bullet collides with, by checking
+	/// the bullet against nearby enemies in the grid. The grid must be up to
+	/// date.
+	/// </summary>
+	/// <param name="x">The x coordinate of the bullet.</param>
+	/// <param name="z">The z coordinate of the bullet.</param>
+	/// <returns>The index of the enemy that was hit, or the number of
+	/// enemies if there was none.</returns>
+	[[nodiscard]] size_t find_bullet_target_in_grid(const float x,
+		const float z) const noexcept;
+
+	/// <summary>
+	/// Decide how often an enemy should animate, based on where it is
+	/// compared to the viewpoint.
+	/// </summary>
+	/// <param name="position">Where the enemy is.</param>
+	/// <returns>The number of animation frames between updates, or 0 if it
+	/// should not animate at all.</returns>
+	[[nodiscard]] size_t animation_interval(const glm::vec3& position)
+		const noexcept;
+
+	/// <summary>
+	/// Fires the enemy bullet pattern wherever the enemy is looking.
 	/// </summary>
 	/// <param name="enemy">The enemy that is attacking.</param>
-	void fire_enemy_bullet(Pawn& enemy);
+	void fire_enemy_pattern(Pawn& enemy);
+
+	/// <summary>
+	/// Fires the player bullet pattern wherever the player is looking.
+	/// </summary>
+	void fire_player_pattern();
+
+	/// <summary>
+	/// Gather the enemy positions and rebuild the enemy grid from them.
+	/// </summary>
+	void index_enemies();
 
 	/// <summary>
-	/// Fires a player bullet.
+	/// Pick a random distance from the player to spawn an enemy at, along
+	/// one axis.
+	///
+	/// This uses the raw output of the engine rather than a standard
+	/// distribution, since those are implemented differently by each
+	/// standard library and would not give the same game for a seed.
 	/// </summary>
-	void fire_player_bullet();
+	/// <returns>An offset in the range [-SPAWN_RADIUS, SPAWN_RADIUS).</returns>
+	[[nodiscard]] double random_spawn_offset();
+
+	/// <summary>
+	/// Put an enemy to sleep in the chunk it is in, destroying its scene
+	/// entity. The caller takes it out of the enemy list.
+	/// </summary>
+	/// <param name="enemy">The enemy, which must be awake.</param>
+	/// <param name="chunk">The chunk that the enemy is in.</param>
+	void sleep_enemy(const std::shared_ptr<Pawn>& enemy,
+		const ChunkCoordinates& chunk);
 
 	/// <summary>
 	/// Spawn an enemy at the specified world coordiantes.
@@ -116,11 +413,29 @@ private:
 	/// </summary>
 	void inline tick_bullets();
 
+	/// <summary>
+	/// Check player bullets against the enemies and apply damage.
+	/// </summary>
+	void inline tick_player_bullet_collisions();
+
 	/// <summary>
 	/// Move the entities that want to do so.
 	/// </summary>
 	void inline tick_movement();
 
+	/// <summary>
+	/// Update the animations for things that the pawn manager cares about.
+	/// Enemies close to the viewpoint animate every frame, ones further away
+	/// less often, and ones offscreen not at all.
+	/// </summary>
+	void tick_animations();
+
+	/// <summary>
+	/// If the map has been recentered, wake the enemies in chunks that are
+	/// hot again and despawn the ones in chunks that have been unloaded.
+	/// </summary>
+	void inline tick_sleeping_enemies();
+
 	/// <summary>
 	/// Update the direction of the pawn based on the desired direction.
 	/// </summary>
@@ -128,10 +443,20 @@ private:
 	void update_direction(Pawn& pawn);
 
 	/// <summary>
-	/// Update the position of a pawn based on the desired movement.
+	/// Move an enemy the way it wants to go, pushed away from the enemies
+	/// around it and kept out of the player. The enemy must have been
+	/// indexed and have its separation calculated this tick.
 	/// </summary>
-	/// <param name="pawn">The pawn to update.</param>
-	void update_movement(Pawn& pawn, const float move_speed);
+	/// <param name="enemy">The enemy to move.</param>
+	/// <param name="index">The index of the enemy.</param>
+	void update_enemy_movement(Pawn& enemy, const size_t index);
+
+	/// <summary>
+	/// Wake a sleeping enemy, giving it a new scene entity and putting it
+	/// back at the end of the enemy list.
+	/// </summary>
+	/// <param name="sleeper">The enemy to wake.</param>
+	void wake_enemy(SleepingEnemy& sleeper);
 };
 
 /// <summary>
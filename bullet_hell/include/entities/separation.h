@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+class SpatialGrid;
+
+/// <summary>
+/// Keeps pawns from standing inside each other by pushing apart any that
+/// overlap. Each pawn only looks at the points that the grid says are
+/// nearby, so the cost grows with the number of pawns rather than the
+/// number of pairs.
+///
+/// Every push is calculated from the same positions, so pawns can be split
+/// into batches and processed in any order with the same result.
+/// </summary>
+namespace Separation
+{
+	/// <summary>
+	/// Calculate how far to push each point in a range so that it stops
+	/// overlapping the points around it. Each point is only pushed by half of
+	/// each overlap, since the point it overlaps is pushed the other half.
+	/// </summary>
+	/// <param name="grid">The grid built from the points, with cells at
+	/// least as wide as the separation distance.</param>
+	/// <param name="x">The x coordinates of all the points.</param>
+	/// <param name="z">The z coordinates of all the points.</param>
+	/// <param name="begin">The first point to calculate, inclusive.</param>
+	/// <param name="end">The last point to calculate, exclusive.</param>
+	/// <param name="distance">How close points can get before they push
+	/// each other apart.</param>
+	/// <param name="max_push">The furthest a single point can be pushed.
+	/// </param>
+	/// <param name="push_x">Where to write the x component of each push,
+	/// indexed the same as the points.</param>
+	/// <param name="push_z">Where to write the z component of each push,
+	/// indexed the same as the points.</param>
+	void find_pushes(const SpatialGrid& grid, const float* x, const float* z,
+		const size_t begin, const size_t end, const float distance,
+		const float max_push, float* push_x, float* push_z) noexcept;
+}
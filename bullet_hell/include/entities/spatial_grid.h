@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// A broad phase for finding things near a point on the x/z plane.
+///
+/// Points are sorted into square cells that are hashed into buckets, so the
+/// grid covers the whole world without needing bounds. The grid is rebuilt
+/// from scratch whenever the points move, which is a counting sort and
+/// reuses its storage, so it does not allocate once it has warmed up.
+///
+/// Nearest neighbour queries search outwards one ring of cells at a time,
+/// so they only look at the points around the answer. If the rings would
+/// cover more cells than there are points, they check every point instead,
+/// so a query never costs much more than a brute force search.
+/// </summary>
+class SpatialGrid
+{
+public:
+	/// <summary>
+	/// A point found by a nearest neighbour search.
+	/// </summary>
+	struct Neighbour
+	{
+		/// <summary>
+		/// The index of the point in the input to build().
+		/// </summary>
+		uint32_t index;
+
+		/// <summary>
+		/// The squared distance from the point to the search location.
+		/// </summary>
+		float distance_squared;
+	};
+
+	/// <summary>
+	/// Set up a grid.
+	/// </summary>
+	/// <param name="cell_size">The width of each cell, in world units. Queries
+	/// only search neighbouring cells, so this must be at least as large as
+	/// the largest distance that will be searched for.</param>
+	SpatialGrid(const float cell_size);
+	SpatialGrid(const SpatialGrid&) = delete;
+	SpatialGrid& operator=(const SpatialGrid&) = delete;
+	~SpatialGrid() = default;
+
+	/// <summary>
+	/// Replace the contents of the grid with a new set of points. Points are
+	/// identified by their index in the input.
+	/// </summary>
+	/// <param name="x">The x coordinates of the points.</param>
+	/// <param name="z">The z coordinates of the points.</param>
+	/// <param name="count">The number of points.</param>
+	void build(const float* x, const float* z, const size_t count);
+
+	/// <summary>
+	/// Remove all points from the grid.
+	/// </summary>
+	void clear() noexcept;
+
+	/// <summary>
+	/// Find the point nearest to the given coordinates. If several points
+	/// are equally close, the one with the lowest index is picked, the same
+	/// as a brute force search in index order.
+	/// </summary>
+	/// <param name="x">The x coordinate to search around.</param>
+	/// <param name="z">The z coordinate to search around.</param>
+	/// <returns>The index of the nearest point, or size() if the grid is
+	/// empty.</returns>
+	[[nodiscard]] size_t find_nearest(const float x, const float z)
+		const noexcept;
+
+	/// <summary>
+	/// Find the points nearest to the given coordinates. Ties are broken by
+	/// the lowest index, like find_nearest().
+	/// </summary>
+	/// <param name="x">The x coordinate to search around.</param>
+	/// <param name="z">The z coordinate to search around.</param>
+	/// <param name="count">The most points to find.</param>
+	/// <param name="result">Replaced with the nearest points, closest first.
+	/// This has fewer than count entries if the grid has fewer points.
+	/// </param>
+	void find_k_nearest(const float x, const float z, const size_t count,
+		std::vector<Neighbour>& result) const;
+
+	/// <summary>
+	/// Find the lowest indexed point within a radius of the given
+	/// coordinates, the same as a brute force search in index order with
+	/// CollisionKernel::find_first_within. Only the neighbouring cells are
+	/// searched, so the radius must be no larger than the cell size.
+	/// </summary>
+	/// <param name="x">The x coordinate to search around.</param>
+	/// <param name="z">The z coordinate to search around.</param>
+	/// <param name="radius_squared">The square of the radius.</param>
+	/// <returns>The index of the point, or size() if there is none.
+	/// </returns>
+	[[nodiscard]] size_t find_first_within(const float x, const float z,
+		const float radius_squared) const noexcept;
+
+	/// <summary>
+	/// Visit every point within a radius of the given coordinates, in no
+	/// particular order. Each point is visited at most once.
+	/// </summary>
+	/// <typeparam name="Visitor">Called with the index, x, and z of each
+	/// point.</typeparam>
+	/// <param name="x">The x coordinate to search around.</param>
+	/// <param name="z">The z coordinate to search around.</param>
+	/// <param name="radius">How far away points can be.</param>
+	/// <param name="visitor">Called for each point within the radius.</param>
+	template<typename Visitor>
+	void for_each_within(const float x, const float z, const float radius,
+		Visitor&& visitor) const
+	{
+		if (sorted_index.empty())
+		{
+			return;
+		}
+
+		const float radius_squared = radius * radius;
+		const auto visit_if_within = [&](const uint32_t slot)
+			{
+				const float dx = sorted_x[slot] - x;
+				const float dz = sorted_z[slot] - z;
+				if (dx * dx + dz * dz <= radius_squared)
+				{
+					visitor(sorted_index[slot], sorted_x[slot],
+						sorted_z[slot]);
+				}
+			};
+
+		const int32_t start_x = cell_coordinate(x - radius);
+		const int32_t start_z = cell_coordinate(z - radius);
+		const int32_t end_x = cell_coordinate(x + radius);
+		const int32_t end_z = cell_coordinate(z + radius);
+		const uint64_t cell_count =
+			static_cast<uint64_t>(end_x - start_x + 1) * (end_z - start_z + 1);
+
+		if (cell_count > sorted_index.size())
+		{
+			for (uint32_t slot = 0; slot < sorted_index.size(); ++slot)
+			{
+				visit_if_within(slot);
+			}
+			return;
+		}
+
+		for (int32_t cell_z = start_z; cell_z <= end_z; ++cell_z)
+		{
+			for (int32_t cell_x = start_x; cell_x <= end_x; ++cell_x)
+			{
+				for_each_in_cell(cell_x, cell_z, visit_if_within);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Visit every point in the cell containing the given coordinates and
+	/// in the 8 cells around it. This may also visit some points that are
+	/// further away, since cells can share a bucket, so the visitor should
+	/// do an exact distance check. Each point is visited at most once.
+	/// </summary>
+	/// <typeparam name="Visitor">Called with the index, x, and z of each
+	/// point.</typeparam>
+	/// <param name="x">The x coordinate to search around.</param>
+	/// <param name="z">The z coordinate to search around.</param>
+	/// <param name="visitor">Called for each point that is nearby.</param>
+	template<typename Visitor>
+	void for_each_nearby(const float x, const float z, Visitor&& visitor)
+		const
+	{
+		if (sorted_index.empty())
+		{
+			return;
+		}
+
+		const int32_t cell_x = cell_coordinate(x);
+		const int32_t cell_z = cell_coordinate(z);
+
+		// Cells next to each other along x hash to buckets next to each
+		// other, so usually each row of 3 cells is one run of the arrays
+		uint32_t row_start[3];
+		bool rows_separate = true;
+		for (int32_t row = 0; row < 3; ++row)
+		{
+			row_start[row] = bucket_of(cell_x - 1, cell_z + row - 1);
+			rows_separate &= row_start[row] + 2 <= bucket_mask;
+		}
+		rows_separate &= distance_between(row_start[0], row_start[1]) >= 3
+			&& distance_between(row_start[0], row_start[2]) >= 3
+			&& distance_between(row_start[1], row_start[2]) >= 3;
+
+		if (rows_separate)
+		{
+			for (const uint32_t bucket : row_start)
+			{
+				const uint32_t end = bucket_start[bucket + 3];
+				for (uint32_t i = bucket_start[bucket]; i < end; ++i)
+				{
+					visitor(sorted_index[i], sorted_x[i], sorted_z[i]);
+				}
+			}
+			return;
+		}
+
+		// Rows wrap around the end of the buckets, or overlap each other
+		uint32_t visited[9];
+		size_t visited_count = 0;
+
+		for (int32_t offset_z = -1; offset_z <= 1; ++offset_z)
+		{
+			for (int32_t offset_x = -1; offset_x <= 1; ++offset_x)
+			{
+				const uint32_t bucket =
+					bucket_of(cell_x + offset_x, cell_z + offset_z);
+
+				bool seen = false;
+				for (size_t i = 0; i < visited_count; ++i)
+				{
+					seen |= visited[i] == bucket;
+				}
+				if (seen)
+				{
+					continue;
+				}
+				visited[visited_count++] = bucket;
+
+				const uint32_t end = bucket_start[bucket + 1];
+				for (uint32_t i = bucket_start[bucket]; i < end; ++i)
+				{
+					visitor(sorted_index[i], sorted_x[i], sorted_z[i]);
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Fetch the number of points in the grid.
+	/// </summary>
+	/// <returns>How many points were in the last build.</returns>
+	[[nodiscard]] size_t size() const noexcept;
+
+private:
+	/// <summary>
+	/// The furthest from the origin a cell coordinate can be. Anything
+	/// further out is clamped to this, which leaves room to step a few cells
+	/// past it, or measure between opposite ends, without overflowing.
+	/// </summary>
+	static constexpr float MAX_CELL_COORDINATE = 1 << 29;
+
+	/// <summary>
+	/// The width of each cell, in world units.
+	/// </summary>
+	const float cell_size;
+
+	/// <summary>
+	/// The reciprocal of the width of each cell, to avoid dividing.
+	/// </summary>
+	const float inverse_cell_size;
+
+	/// <summary>
+	/// One less than the number of buckets, which is a power of two.
+	/// </summary>
+	uint32_t bucket_mask = 0;
+
+	/// <summary>
+	/// Where each bucket starts in the sorted arrays. There is one extra
+	/// entry at the end so that bucket i ends where bucket i + 1 starts.
+	/// </summary>
+	std::vector<uint32_t> bucket_start;
+
+	/// <summary>
+	/// The bucket for each point, in input order. Only used while building.
+	/// </summary>
+	std::vector<uint32_t> point_bucket;
+
+	/// <summary>
+	/// The input index of each point, sorted by bucket.
+	/// </summary>
+	std::vector<uint32_t> sorted_index;
+
+	/// <summary>
+	/// The x coordinate of each point, sorted by bucket.
+	/// </summary>
+	std::vector<float> sorted_x;
+
+	/// <summary>
+	/// The z coordinate of each point, sorted by bucket.
+	/// </summary>
+	std::vector<float> sorted_z;
+
+	/// <summary>
+	/// Visit the points that are in exactly the given cell, skipping any
+	/// from other cells that share its bucket.
+	/// </summary>
+	/// <typeparam name="Visitor">Called with the position of each point in
+	/// the sorted arrays.</typeparam>
+	/// <param name="cell_x">The x coordinate of the cell.</param>
+	/// <param name="cell_z">The z coordinate of the cell.</param>
+	/// <param name="visitor">Called for each point in the cell.</param>
+	template<typename Visitor>
+	void for_each_in_cell(const int32_t cell_x, const int32_t cell_z,
+		Visitor&& visitor) const
+	{
+		const uint32_t bucket = bucket_of(cell_x, cell_z);
+		const uint32_t end = bucket_start[bucket + 1];
+		for (uint32_t slot = bucket_start[bucket]; slot < end; ++slot)
+		{
+			if (cell_coordinate(sorted_x[slot]) == cell_x
+				&& cell_coordinate(sorted_z[slot]) == cell_z)
+			{
+				visitor(slot);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Visit the points in the square ring of cells a number of cells away
+	/// from a center cell.
+	/// </summary>
+	/// <typeparam name="Visitor">Called with the position of each point in
+	/// the sorted arrays.</typeparam>
+	/// <param name="cell_x">The x coordinate of the center cell.</param>
+	/// <param name="cell_z">The z coordinate of the center cell.</param>
+	/// <param name="ring">How many cells out the ring is, where 0 is just
+	/// the center cell.</param>
+	/// <param name="visitor">Called for each point in the ring.</param>
+	template<typename Visitor>
+	void for_each_in_ring(const int32_t cell_x, const int32_t cell_z,
+		const int32_t ring, Visitor&& visitor) const
+	{
+		if (ring == 0)
+		{
+			for_each_in_cell(cell_x, cell_z, visitor);
+			return;
+		}
+		for (int32_t offset = -ring; offset <= ring; ++offset)
+		{
+			for_each_in_cell(cell_x + offset, cell_z - ring, visitor);
+			for_each_in_cell(cell_x + offset, cell_z + ring, visitor);
+		}
+		for (int32_t offset = -ring + 1; offset < ring; ++offset)
+		{
+			for_each_in_cell(cell_x - ring, cell_z + offset, visitor);
+			for_each_in_cell(cell_x + ring, cell_z + offset, visitor);
+		}
+	}
+
+	/// <summary>
+	/// Calculate how far away the points in rings past the given one are at
+	/// least, so that searches know when they can stop.
+	/// </summary>
+	/// <param name="ring">The last ring that was searched.</param>
+	/// <returns>The square of the minimum distance to any point that has not
+	/// been searched yet.</returns>
+	[[nodiscard]] float unsearched_distance_squared(const int32_t ring)
+		const noexcept;
+
+	/// <summary>
+	/// Find how far apart two buckets are.
+	/// </summary>
+	/// <param name="first">The first bucket.</param>
+	/// <param name="second">The second bucket.</param>
+	/// <returns>The absolute difference between the buckets.</returns>
+	[[nodiscard]] static uint32_t distance_between(const uint32_t first,
+		const uint32_t second) noexcept
+	{
+		return first > second ? first - second : second - first;
+	}
+
+	/// <summary>
+	/// Hash the coordinates of a cell into a bucket. Rows of cells along x
+	/// are kept together so that neighbours can be found in one run.
+	/// </summary>
+	/// <param name="cell_x">The x coordinate of the cell.</param>
+	/// <param name="cell_z">The z coordinate of the cell.</param>
+	/// <returns>The bucket that the cell is stored in.</returns>
+	[[nodiscard]] uint32_t bucket_of(const int32_t cell_x,
+		const int32_t cell_z) const noexcept
+	{
+		const uint32_t hash = static_cast<uint32_t>(cell_z) * 19349663u
+			+ static_cast<uint32_t>(cell_x);
+		return hash & bucket_mask;
+	}
+
+	/// <summary>
+	/// Convert a world coordinate into a cell coordinate. Coordinates too far
+	/// out to fit are clamped, and NaN goes in cell 0, since it is never
+	/// within range of anything wherever it goes.
+	/// </summary>
+	/// <param name="value">The world coordinate.</param>
+	/// <returns>The cell coordinate along the same axis.</returns>
+	[[nodiscard]] int32_t cell_coordinate(const float value) const noexcept
+	{
+		const float cell = std::floor(value * inverse_cell_size);
+		if (std::isnan(cell))
+		{
+			return 0;
+		}
+		return static_cast<int32_t>(std::clamp(cell, -MAX_CELL_COORDINATE,
+			MAX_CELL_COORDINATE));
+	}
+};
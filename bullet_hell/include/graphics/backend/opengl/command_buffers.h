@@ -1,6 +1,11 @@
 #pragma once
 
+#include <array>
+#include <vector>
+
 #include "graphics/glad_types.h"
+#include "graphics/render_constants.h"
+#include "graphics/backend/opengl/model_matrix_ring.h"
 
 /// <summary>
 /// References to buffers for rendering entities, so buffers can be cached.
@@ -25,7 +30,7 @@ struct CommandBuffers
 	/// <summary>
 	/// Storage for model matrices for animated models.
 	/// </summary>
-	GLuint animated_model_matrices_buffer;
+	ModelMatrixRing animated_model_matrices;
 
 	/// <summary>
 	/// Command buffers for rendering only the static (non-animated) models.
@@ -45,7 +50,7 @@ struct CommandBuffers
 	/// <summary>
 	/// Storage for model matrices for static models.
 	/// </summary>
-	GLuint static_model_matrices_buffer;
+	ModelMatrixRing static_model_matrices;
 
 	/// <summary>
 	/// Delete any buffers that are set up.
@@ -57,3 +62,51 @@ struct CommandBuffers
 	CommandBuffers& operator=(const CommandBuffers&) = delete;
 	~CommandBuffers();
 };
+
+/// <summary>
+/// The culled draw commands for each shadow cascade, which only covers part
+/// of the view, so sees a different set of entities to the camera. The
+/// model matrices are shared with the camera's command buffers.
+/// </summary>
+struct CascadeCommandBuffers
+{
+	/// <summary>
+	/// The animated draw commands for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT> animated_command_buffers;
+
+	/// <summary>
+	/// The animated draw elements for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT>
+		animated_draw_element_buffers;
+
+	/// <summary>
+	/// The static draw commands for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT> static_command_buffers;
+
+	/// <summary>
+	/// The static draw elements for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT> static_draw_element_buffers;
+
+	CascadeCommandBuffers();
+	CascadeCommandBuffers(const CascadeCommandBuffers&) = delete;
+	CascadeCommandBuffers& operator=(const CascadeCommandBuffers&) = delete;
+	~CascadeCommandBuffers();
+};
+
+/// <summary>
+/// Upload indirect draw commands, and the draw elements that they refer to.
+/// </summary>
+/// <param name="command_buffer">The indirect buffer for the commands.
+/// </param>
+/// <param name="draw_element_buffer">The storage buffer for the draw
+/// elements.</param>
+/// <param name="commands">The draw commands, five ints each.</param>
+/// <param name="draw_elements">The draw elements.</param>
+/// <returns>How many draw commands were uploaded.</returns>
+unsigned int upload_draw_commands(const GLuint command_buffer,
+	const GLuint draw_element_buffer, const std::vector<int>& commands,
+	const std::vector<int>& draw_elements);
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+
+#include "graphics/glad_types.h"
+#include "graphics/graph/model.h"
+
+/// <summary>
+/// Model matrices for the shaders, written straight into a buffer that stays
+/// mapped for as long as it lives.
+///
+/// The buffer is split into a region for each frame in flight, so we write
+/// one region while the GPU is still reading the others, and wait on a
+/// fence before writing a region again. Each region is only written where
+/// the matrices have changed since that region was last written, so
+/// entities that stand still cost nothing to upload.
+/// </summary>
+class ModelMatrixRing
+{
+public:
+	/// <summary>
+	/// How many frames can be in flight, which is how many regions the
+	/// buffer is split into.
+	/// </summary>
+	static constexpr size_t FRAME_COUNT = 3;
+
+	ModelMatrixRing();
+	ModelMatrixRing(const ModelMatrixRing&) = delete;
+	ModelMatrixRing& operator=(const ModelMatrixRing&) = delete;
+	~ModelMatrixRing();
+
+	/// <summary>
+	/// Write the model matrix of every entity of a list of models into the
+	/// next region, in the order of the models and then their entities.
+	/// </summary>
+	/// <param name="models">The list of models.</param>
+	void update(const std::vector<std::shared_ptr<Model>>& models);
+
+	/// <summary>
+	/// Bind the region written by the last update as a shader storage
+	/// buffer.
+	/// </summary>
+	/// <param name="binding">The binding point to bind to.</param>
+	void bind(const GLuint binding) const;
+
+	/// <summary>
+	/// Unmap and delete the buffer, and forget what was written.
+	/// </summary>
+	void cleanup();
+
+private:
+	/// <summary>
+	/// The buffer, which is immutable, so replaced when it is outgrown.
+	/// </summary>
+	GLuint buffer;
+
+	/// <summary>
+	/// Where the whole buffer is mapped.
+	/// </summary>
+	std::byte* mapped;
+
+	/// <summary>
+	/// How many matrices fit in each region.
+	/// </summary>
+	size_t capacity;
+
+	/// <summary>
+	/// How far apart the regions are, in bytes, which is rounded up so
+	/// every region can be bound on its own.
+	/// </summary>
+	size_t region_size;
+
+	/// <summary>
+	/// The region written by the last update.
+	/// </summary>
+	size_t region;
+
+	/// <summary>
+	/// How many updates there have been, counting from 1.
+	/// </summary>
+	uint64_t frame;
+
+	/// <summary>
+	/// Signalled once the GPU is done with everything that reads each
+	/// region, or null if there is nothing to wait on.
+	/// </summary>
+	std::array<GLsync, FRAME_COUNT> fences;
+
+	/// <summary>
+	/// The update that each region was last written by, or 0 if it has not
+	/// been written since the buffer was made.
+	/// </summary>
+	std::array<uint64_t, FRAME_COUNT> region_frames;
+
+	/// <summary>
+	/// The latest matrices, to compare against so we can tell what changed.
+	/// </summary>
+	std::vector<glm::mat4> latest;
+
+	/// <summary>
+	/// The update that each matrix last changed in.
+	/// </summary>
+	std::vector<uint64_t> changed_frames;
+
+	/// <summary>
+	/// Replace the buffer with one that fits at least a number of matrices
+	/// in each region.
+	/// </summary>
+	/// <param name="count">How many matrices need to fit.</param>
+	void reserve(const size_t count);
+
+	/// <summary>
+	/// Wait until the GPU is done reading a region.
+	/// </summary>
+	/// <param name="index">The region to wait for.</param>
+	void wait_for(const size_t index);
+};
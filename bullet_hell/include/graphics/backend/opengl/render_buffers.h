@@ -98,6 +98,12 @@ public:
 	/// </summary>
 	GLuint animation_draw_parameters_ssbo = 0;
 
+	/// <summary>
+	/// Changes every time the animated buffers are reloaded, so that anything
+	/// remembering what was written to them knows to start over.
+	/// </summary>
+	unsigned int animated_buffers_generation = 0;
+
 private:
 
 	GLuint animated_index_vbo = 0;
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <vector>
+
 #include "graphics/backend/opengl/render_buffers.h"
 #include "graphics/frontend/render_stage.h"
 #include "graphics/frontend/shader.h"
+#include "graphics/graph/skinning_plan.h"
 
 class AnimationRender : public RenderStage
 {
@@ -12,7 +15,37 @@ public:
 
 	void render(Scene& scene);
 
+	/// <summary>
+	/// Fetch the draw commands for every animated entity, as of the last
+	/// render. Culled before they are drawn.
+	/// </summary>
+	/// <returns>The draw commands.</returns>
+	[[nodiscard]] const std::vector<int>& commands() const noexcept;
+
+	/// <summary>
+	/// Fetch the draw elements that the draw commands refer to.
+	/// </summary>
+	/// <returns>The draw elements, one for each instance.</returns>
+	[[nodiscard]] const std::vector<int>& draw_elements() const noexcept;
+
+	/// <summary>
+	/// Fetch a number that changes whenever the draw commands do, so that
+	/// anything built from them knows when to rebuild.
+	/// </summary>
+	/// <returns>The generation of the draw commands.</returns>
+	[[nodiscard]] unsigned int commands_generation() const noexcept;
+
 private:
 	Shader* shader;
 	StageResource<RenderBuffers>* const render_buffers;
+
+	/// <summary>
+	/// Works out which poses to skin and how to draw them.
+	/// </summary>
+	SkinningPlan skinning_plan;
+
+	/// <summary>
+	/// Counts how many times the draw commands have changed.
+	/// </summary>
+	unsigned int generation;
 };
\ No newline at end of file
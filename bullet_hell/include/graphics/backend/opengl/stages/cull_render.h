@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "graphics/glad_types.h"
+#include "graphics/backend/opengl/command_buffers.h"
+#include "graphics/backend/opengl/stages/animation_render.h"
+#include "graphics/frontend/render_stage.h"
+#include "graphics/frontend/shader.h"
+#include "graphics/graph/cascade_shadow_slice.h"
+#include "graphics/graph/gpu_cull_plan.h"
+#include "graphics/scene/frustum.h"
+
+/// <summary>
+/// Culls every instance against the camera and each shadow cascade in a
+/// compute shader, which writes the draw commands and draw elements that
+/// the scene and shadow stages draw from.
+///
+/// The inputs are only uploaded when the set of draw commands changes. From
+/// then on the shader reads where each entity is from the model matrix
+/// buffer, so entities moving around costs the CPU nothing.
+/// </summary>
+class CullRender : public RenderStage
+{
+public:
+	CullRender(StageResource<CommandBuffers>* command_buffers,
+		StageResource<CascadeCommandBuffers>* cascade_command_buffers,
+		StageResource<CascadeShadows>* cascade_shadows,
+		const AnimationRender* animation_render);
+	CullRender(const CullRender&) = delete;
+	CullRender& operator=(const CullRender&) = delete;
+	virtual ~CullRender();
+
+	virtual void render(Scene& scene);
+
+private:
+	/// <summary>
+	/// The buffers holding the inputs of one plan on the GPU.
+	/// </summary>
+	struct PlanBuffers
+	{
+		/// <summary>
+		/// The draw commands with no instances, copied over the output
+		/// before each cull.
+		/// </summary>
+		GLuint commands = 0;
+
+		/// <summary>
+		/// The draw for each command.
+		/// </summary>
+		GLuint draws = 0;
+
+		/// <summary>
+		/// Every instance of every command.
+		/// </summary>
+		GLuint instances = 0;
+	};
+
+	/// <summary>
+	/// How many models and entities a static model had when the static
+	/// commands were last built, so that we can tell when to rebuild them.
+	/// </summary>
+	struct StaticModelShape
+	{
+		const Model* model;
+		size_t entity_count;
+		size_t draw_count;
+
+		bool operator==(const StaticModelShape&) const = default;
+	};
+
+	Shader* shader;
+	StageResource<CommandBuffers>* const command_buffers;
+	StageResource<CascadeCommandBuffers>* const cascade_command_buffers;
+	StageResource<CascadeShadows>* const cascade_shadows;
+	const AnimationRender* const animation_render;
+
+	/// <summary>
+	/// The inputs for culling static models.
+	/// </summary>
+	GpuCullPlan static_plan;
+
+	/// <summary>
+	/// The inputs for culling animated models.
+	/// </summary>
+	GpuCullPlan animated_plan;
+
+	PlanBuffers static_buffers;
+	PlanBuffers animated_buffers;
+
+	/// <summary>
+	/// The static models as of the last time the static plan was built.
+	/// </summary>
+	std::vector<StaticModelShape> static_shapes;
+
+	/// <summary>
+	/// The static models as they are now. Kept between frames to avoid
+	/// allocating.
+	/// </summary>
+	std::vector<StaticModelShape> current_static_shapes;
+
+	/// <summary>
+	/// The generation of the animated draw commands the animated plan was
+	/// built from.
+	/// </summary>
+	unsigned int animated_generation;
+
+	/// <summary>
+	/// Whether the animated plan has been built yet.
+	/// </summary>
+	bool animated_plan_built;
+
+	/// <summary>
+	/// The draw commands for every static entity, before culling.
+	/// </summary>
+	std::vector<int> static_commands;
+
+	/// <summary>
+	/// The draw elements the static draw commands refer to, before culling.
+	/// </summary>
+	std::vector<int> static_draw_elements;
+
+	/// <summary>
+	/// Rebuild the static plan if any static model has changed, and the
+	/// animated plan if the animated draw commands have.
+	/// </summary>
+	/// <param name="scene">The scene we are rendering.</param>
+	void update_plans(const Scene& scene);
+
+	/// <summary>
+	/// Upload the inputs of a plan, and make room for its outputs.
+	/// </summary>
+	/// <param name="plan">The plan to upload.</param>
+	/// <param name="buffers">Where the inputs go.</param>
+	/// <param name="command_buffer">Where the camera's commands go.</param>
+	/// <param name="draw_element_buffer">Where the camera's draw elements
+	/// go.</param>
+	/// <param name="cascade_command_buffers">Where each cascade's commands
+	/// go.</param>
+	/// <param name="cascade_draw_element_buffers">Where each cascade's draw
+	/// elements go.</param>
+	void upload_plan(const GpuCullPlan& plan, const PlanBuffers& buffers,
+		const GLuint command_buffer, const GLuint draw_element_buffer,
+		const std::array<GLuint, SHADOW_MAP_CASCADE_COUNT>&
+			cascade_command_buffers,
+		const std::array<GLuint, SHADOW_MAP_CASCADE_COUNT>&
+			cascade_draw_element_buffers);
+
+	/// <summary>
+	/// Cull every instance of a plan against a frustum on the GPU.
+	/// </summary>
+	/// <param name="plan">The plan to cull.</param>
+	/// <param name="buffers">The inputs of the plan.</param>
+	/// <param name="model_matrices">The model matrices of the entities.
+	/// </param>
+	/// <param name="frustum">The volume to keep instances in.</param>
+	/// <param name="command_buffer">Where the commands go.</param>
+	/// <param name="draw_element_buffer">Where the draw elements go.</param>
+	void cull(const GpuCullPlan& plan, const PlanBuffers& buffers,
+		const ModelMatrixRing& model_matrices, const Frustum& frustum,
+		const GLuint command_buffer, const GLuint draw_element_buffer);
+};
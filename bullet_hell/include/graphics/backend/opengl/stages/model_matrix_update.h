@@ -18,15 +18,6 @@ public:
 
 	virtual void render(Scene& scene);
 
-	/// <summary>
-	/// Take a list of models, and upload the model matrices to the specified 
-	/// buffer.
-	/// </summary>
-	/// <param name="models">The list of models.</param>
-	/// <param name="buffer_id">The buffer we want to send data to.</param>
-	void update_model_buffer(const std::vector<std::shared_ptr<Model>> models,
-		GLuint buffer_id);
-
 private:
 	StageResource<CommandBuffers>* const command_buffers;
 };
\ No newline at end of file
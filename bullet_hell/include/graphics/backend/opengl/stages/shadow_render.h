@@ -13,7 +13,8 @@ public:
 	ShadowRender(StageResource<RenderBuffers>* render_buffers,
 		StageResource<CascadeShadows>* cascade_shadows,
 		StageResource<Framebuffer>* depth_map,
-		StageResource<CommandBuffers>* command_buffers);
+		StageResource<CommandBuffers>* command_buffers,
+		StageResource<CascadeCommandBuffers>* cascade_command_buffers);
 	virtual ~ShadowRender() = default;
 
 	virtual void render(Scene& scene);
@@ -24,4 +25,5 @@ private:
 	StageResource<CascadeShadows>* const cascade_shadows;
 	StageResource<Framebuffer>* const depth_map;
 	StageResource<CommandBuffers>* const command_buffers;
+	StageResource<CascadeCommandBuffers>* const cascade_command_buffers;
 };
\ No newline at end of file
@@ -19,6 +19,7 @@ public:
 enum class RenderStage::Type : uint8_t
 {
     ANIMATION,
+    CULL,
     DEBUG_INFO,
     FILTER,
     GUI,
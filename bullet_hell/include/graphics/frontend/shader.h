@@ -17,6 +17,12 @@ struct Shader
 	{
 		std::string_view file_name;
 		Type type;
+
+		/// <summary>
+		/// The source code, for shaders that are built in rather than loaded
+		/// from a file. Left empty to load the file.
+		/// </summary>
+		std::string_view source = {};
 	};
 
 	/// <summary>
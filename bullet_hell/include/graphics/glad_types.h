@@ -12,3 +12,4 @@
 
 typedef unsigned int GLuint;
 typedef int GLint;
+typedef struct __GLsync* GLsync;
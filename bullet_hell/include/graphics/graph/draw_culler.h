@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+#include "graphics/graph/model.h"
+#include "graphics/scene/frustum.h"
+
+/// <summary>
+/// Trims indirect draw commands down to the instances that a frustum can
+/// see, without touching the graphics API, so that every backend and every
+/// pass can share it.
+///
+/// The bounds of every entity are worked out once a frame, along with a box
+/// around all the entities of each model. Each chunk of the map is baked
+/// into a model of its own, so testing the boxes first throws out whole
+/// chunks, along with models whose entities are all offscreen, before any
+/// entity is tested on its own. Everything that is left is tested as a
+/// sphere, four at a time.
+/// </summary>
+class DrawCuller
+{
+public:
+	/// <summary>
+	/// How many ints make up each indirect draw command.
+	/// </summary>
+	static constexpr size_t COMMAND_SIZE = 5;
+
+	/// <summary>
+	/// How many ints the shaders take for each instance that is drawn, which
+	/// are the model matrix index and the material.
+	/// </summary>
+	static constexpr size_t DRAW_ELEMENT_SIZE = 2;
+
+	DrawCuller();
+	DrawCuller(const DrawCuller&) = delete;
+	DrawCuller& operator=(const DrawCuller&) = delete;
+	~DrawCuller() = default;
+
+	/// <summary>
+	/// Work out the bounds of every entity where it is now, and take note of
+	/// the draw commands to trim. Entities are numbered in the same order as
+	/// their model matrices, which is every entity of every model in turn.
+	/// </summary>
+	/// <param name="models">The models whose entities are drawn.</param>
+	/// <param name="commands">The draw commands for every entity, which must
+	/// stay alive and unchanged while culling.</param>
+	/// <param name="draw_elements">The draw elements that the commands
+	/// refer to, one for each instance, which must stay alive and unchanged
+	/// while culling.</param>
+	void gather(const std::vector<std::shared_ptr<Model>>& models,
+		const std::vector<int>& commands,
+		const std::vector<int>& draw_elements);
+
+	/// <summary>
+	/// Copy the draw commands, keeping only the instances of entities that
+	/// might be visible. Commands left with no instances are dropped.
+	/// </summary>
+	/// <param name="frustum">The volume to keep entities in.</param>
+	/// <param name="visible_commands">Set to the commands that are left.
+	/// </param>
+	/// <param name="visible_draw_elements">Set to the draw elements that the
+	/// commands that are left refer to.</param>
+	void cull(const Frustum& frustum, std::vector<int>& visible_commands,
+		std::vector<int>& visible_draw_elements);
+
+private:
+	/// <summary>
+	/// A box around every entity of one model.
+	/// </summary>
+	struct ModelBounds
+	{
+		/// <summary>
+		/// The corner with the smallest coordinates, in world space.
+		/// </summary>
+		glm::vec3 min;
+
+		/// <summary>
+		/// The corner with the largest coordinates, in world space.
+		/// </summary>
+		glm::vec3 max;
+
+		/// <summary>
+		/// The number of the first entity of the model.
+		/// </summary>
+		size_t first_entity;
+
+		/// <summary>
+		/// How many entities the model has.
+		/// </summary>
+		size_t entity_count;
+	};
+
+	/// <summary>
+	/// The draw commands to trim.
+	/// </summary>
+	const std::vector<int>* source_commands;
+
+	/// <summary>
+	/// The draw elements that the draw commands to trim refer to.
+	/// </summary>
+	const std::vector<int>* source_draw_elements;
+
+	/// <summary>
+	/// The bounds of each model with any entities.
+	/// </summary>
+	std::vector<ModelBounds> model_bounds;
+
+	/// <summary>
+	/// The x coordinate of the center of each entity's bounding sphere.
+	/// </summary>
+	std::vector<float> center_x;
+
+	/// <summary>
+	/// The y coordinate of the center of each entity's bounding sphere.
+	/// </summary>
+	std::vector<float> center_y;
+
+	/// <summary>
+	/// The z coordinate of the center of each entity's bounding sphere.
+	/// </summary>
+	std::vector<float> center_z;
+
+	/// <summary>
+	/// The radius of each entity's bounding sphere.
+	/// </summary>
+	std::vector<float> radius;
+
+	/// <summary>
+	/// Whether each entity passed the last cull.
+	/// </summary>
+	std::vector<uint8_t> visible;
+};
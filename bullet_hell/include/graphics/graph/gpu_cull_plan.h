@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+
+#include "graphics/graph/model.h"
+#include "graphics/scene/frustum.h"
+
+/// <summary>
+/// Sets up the inputs for culling draw commands on the GPU, without touching
+/// the graphics API, and culls them the same way on the CPU for reference.
+///
+/// Each command becomes a draw, with the bounding sphere of its model and
+/// the material of its mesh, and each of its instances becomes one item for
+/// the compute shader. The shader reads the model matrix of an instance
+/// straight from the model matrix buffer, so nothing here changes when
+/// entities move, only when the commands themselves do.
+///
+/// Commands keep their place in the output, with only the visible instances
+/// packed into the front of the range of draw elements they started with.
+/// Commands with nothing visible are left with an instance count of 0,
+/// which draws nothing.
+/// </summary>
+class GpuCullPlan
+{
+public:
+	/// <summary>
+	/// How many ints make up each indirect draw command.
+	/// </summary>
+	static constexpr size_t COMMAND_SIZE = 5;
+
+	/// <summary>
+	/// How many ints the shaders take for each instance that is drawn, which
+	/// are the model matrix index and the material.
+	/// </summary>
+	static constexpr size_t DRAW_ELEMENT_SIZE = 2;
+
+	/// <summary>
+	/// What the compute shader needs to know about each command. Laid out
+	/// to match std430.
+	/// </summary>
+	struct Draw
+	{
+		/// <summary>
+		/// The bounding sphere of the model, with the center in the model's
+		/// own space in the first three, and the radius last.
+		/// </summary>
+		float sphere[4];
+
+		/// <summary>
+		/// The material of the mesh.
+		/// </summary>
+		int material;
+
+		/// <summary>
+		/// Where the draw elements of the command start.
+		/// </summary>
+		int first_element;
+
+		/// <summary>
+		/// Pads the draw out to a multiple of 16 bytes, as std430 does.
+		/// </summary>
+		int padding[2];
+	};
+
+	/// <summary>
+	/// One instance of a command, for one thread of the compute shader.
+	/// </summary>
+	struct Instance
+	{
+		/// <summary>
+		/// The index of the instance's model matrix.
+		/// </summary>
+		int matrix_index;
+
+		/// <summary>
+		/// The index of the draw, which is also the index of the command.
+		/// </summary>
+		int draw;
+	};
+
+	GpuCullPlan();
+	GpuCullPlan(const GpuCullPlan&) = delete;
+	GpuCullPlan& operator=(const GpuCullPlan&) = delete;
+	~GpuCullPlan() = default;
+
+	/// <summary>
+	/// Set up the draws and instances for a set of draw commands.
+	/// </summary>
+	/// <param name="models">The models that the commands draw, in the same
+	/// order as their model matrices.</param>
+	/// <param name="source_commands">The draw commands for every entity.
+	/// </param>
+	/// <param name="source_draw_elements">The draw elements that the
+	/// commands refer to, one for each instance.</param>
+	void build(const std::vector<std::shared_ptr<Model>>& models,
+		const std::vector<int>& source_commands,
+		const std::vector<int>& source_draw_elements);
+
+	/// <summary>
+	/// Cull on the CPU, doing exactly what the compute shader does. The
+	/// shader hands out places in each command's range of draw elements to
+	/// whichever thread gets there first, so the instances of a command
+	/// should be compared without regard to order.
+	/// </summary>
+	/// <param name="frustum">The volume to keep instances in.</param>
+	/// <param name="model_matrices">The model matrices, as they are in the
+	/// model matrix buffer.</param>
+	/// <param name="culled_commands">Set to the commands, with instance
+	/// counts for only the visible instances.</param>
+	/// <param name="culled_draw_elements">Set to the draw elements, with the
+	/// visible instances at the front of each command's range and the rest
+	/// left as 0.</param>
+	void cull(const Frustum& frustum,
+		const std::vector<glm::mat4>& model_matrices,
+		std::vector<int>& culled_commands,
+		std::vector<int>& culled_draw_elements) const;
+
+	/// <summary>
+	/// The draw commands, with every instance count set to 0. Copied over
+	/// the output before each cull, so that instances can be counted up.
+	/// </summary>
+	std::vector<int> commands;
+
+	/// <summary>
+	/// One draw for each command.
+	/// </summary>
+	std::vector<Draw> draws;
+
+	/// <summary>
+	/// Every instance of every command.
+	/// </summary>
+	std::vector<Instance> instances;
+
+private:
+	/// <summary>
+	/// The bounding sphere for each model matrix, while building. Kept
+	/// between builds to avoid allocating.
+	/// </summary>
+	std::vector<glm::vec4> matrix_spheres;
+};
@@ -1,19 +1,10 @@
 #pragma once
 
-#include <memory>
-
-struct Entity;
-
 /// <summary>
-/// Data used for drawing animated meshes.
+/// Data used for skinning animated meshes.
 /// </summary>
 struct AnimMeshDrawData
 {
-	/// <summary>
-	/// The entity associated with the animation.
-	/// </summary>
-	const std::shared_ptr<Entity> entity;
-
 	/// <summary>
 	/// The offset to the binding pose within the data.
 	/// </summary>
@@ -27,13 +18,11 @@ struct AnimMeshDrawData
 	/// <summary>
 	/// Set up new draw data.
 	/// </summary>
-	/// <param name="entity">The entity associated with the animation.</param>
 	/// <param name="binding_pose_offset">The offset to the binding pose
 	/// within the data.</param>
 	/// <param name="weights_offset">The offset to the weight within the data.
 	/// </param>
-	AnimMeshDrawData(std::shared_ptr<Entity> entity, int binding_pose_offset,
-		int weights_offset);
+	AnimMeshDrawData(int binding_pose_offset, int weights_offset);
 
 	AnimMeshDrawData(const AnimMeshDrawData&) = default;
 	AnimMeshDrawData& operator=(const AnimMeshDrawData&) = default;
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
 
 #include "graphics/graph/animation.h"
 #include "graphics/graph/mesh_data.h"
@@ -12,9 +13,9 @@
 #include "graphics/scene/entity.h"
 
 /// <summary>
-/// A list of pointers to entities.
+/// A list of handles to entities.
 /// </summary>
-using EntityList = std::vector<std::shared_ptr<Entity>>;
+using EntityList = std::vector<EntityHandle>;
 
 /// <summary>
 /// A 3D model that can be rendered.
@@ -53,6 +54,14 @@ struct Model
 	/// <returns></returns>
 	bool is_animated();
 
+	/// <summary>
+	/// Find a sphere around the bounding boxes of every mesh.
+	/// </summary>
+	/// <returns>The center in the model's own space in xyz, and the radius
+	/// in w. A model without meshes gets an empty sphere at the origin.
+	/// </returns>
+	[[nodiscard]] glm::vec4 bounding_sphere() const noexcept;
+
 	/// <summary>
 	/// Construct a new model.
 	/// </summary>
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Tracks which skinned poses are sitting in the animation output buffer,
+/// so that entities showing the same frame of the same animation can share
+/// one skinned copy of their model instead of each skinning their own.
+///
+/// Each animated model has a fixed number of slots in the buffer, enough for
+/// every frame it could be showing. A frame is identified by the offset of
+/// its bone matrices, which is unique to the animation and frame. The bone
+/// matrices never change, so a pose stays good until its slot is needed for
+/// another one, and usually only a handful of new poses need skinning each
+/// frame.
+/// </summary>
+class PoseCache
+{
+public:
+	/// <summary>
+	/// Used for slots that have no pose in them.
+	/// </summary>
+	static constexpr int EMPTY = -1;
+
+	PoseCache();
+	PoseCache(const PoseCache&) = delete;
+	PoseCache& operator=(const PoseCache&) = delete;
+	~PoseCache() = default;
+
+	/// <summary>
+	/// Decide which slot each entity of a model draws from this frame,
+	/// keeping poses that are already skinned where they are.
+	/// </summary>
+	/// <param name="model">Which animated model this is, counting from 0 in
+	/// the order they are stored in the buffer.</param>
+	/// <param name="slot_count">How many slots the model has, which must be
+	/// at least the number of different frames.</param>
+	/// <param name="frames">The frame each entity is showing.</param>
+	/// <param name="entity_slots">Set to the slot that each entity should
+	/// draw from.</param>
+	/// <param name="skin_slots">Any slots that need a new pose skinned into
+	/// them are added to this.</param>
+	void assign(const size_t model, const size_t slot_count,
+		const std::vector<int>& frames,
+		std::vector<uint32_t>& entity_slots,
+		std::vector<uint32_t>& skin_slots);
+
+	/// <summary>
+	/// Forget every pose, because the buffer they were skinned into has been
+	/// reloaded.
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Fetch which frame is posed in a slot.
+	/// </summary>
+	/// <param name="model">Which animated model the slot belongs to.</param>
+	/// <param name="slot">The slot to check.</param>
+	/// <returns>The frame, or EMPTY if nothing has been put there.</returns>
+	[[nodiscard]] int slot_frame(const size_t model, const uint32_t slot)
+		const noexcept;
+
+private:
+	/// <summary>
+	/// The frame posed in each slot, for each model.
+	/// </summary>
+	std::vector<std::vector<int>> slot_frames;
+
+	/// <summary>
+	/// Which slot each posed frame is in, for the model being assigned. Kept
+	/// between frames to avoid allocating.
+	/// </summary>
+	std::unordered_map<int, uint32_t> frame_slots;
+
+	/// <summary>
+	/// Whether an entity is drawing from each slot, for the model being
+	/// assigned. Kept between frames to avoid allocating.
+	/// </summary>
+	std::vector<uint8_t> slot_used;
+};
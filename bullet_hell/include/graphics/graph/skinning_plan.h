@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "graphics/graph/model.h"
+#include "graphics/graph/pose_cache.h"
+
+/// <summary>
+/// Works out the skinning and draw commands for animated models each frame,
+/// without touching the graphics API, so that every backend can share it.
+///
+/// Each animated model has a handful of pose slots in the animation output
+/// buffer rather than a copy of its vertices for every entity. Entities are
+/// grouped by the pose they are showing, and each group is drawn with one
+/// instanced command per mesh, so the number of commands depends on how many
+/// different frames are on screen instead of how many entities there are.
+/// </summary>
+class SkinningPlan
+{
+public:
+	/// <summary>
+	/// How many ints of draw parameters the compute shader takes for each
+	/// pose and mesh.
+	/// </summary>
+	static constexpr size_t PARAMETERS_PER_DRAW = 5;
+
+	/// <summary>
+	/// How many ints make up each indirect draw command.
+	/// </summary>
+	static constexpr size_t COMMAND_SIZE = 5;
+
+	/// <summary>
+	/// How many ints the shaders take for each instance that is drawn, which
+	/// are the model matrix index and the material.
+	/// </summary>
+	static constexpr size_t DRAW_ELEMENT_SIZE = 2;
+
+	/// <summary>
+	/// One dispatch of the animation compute shader, covering the poses of
+	/// a single model that need skinning.
+	/// </summary>
+	struct Dispatch
+	{
+		/// <summary>
+		/// How many vertices are in all the meshes of the model.
+		/// </summary>
+		int model_vertex_count;
+
+		/// <summary>
+		/// How many sets of draw parameters the dispatch covers.
+		/// </summary>
+		int draw_count;
+	};
+
+	SkinningPlan();
+	SkinningPlan(const SkinningPlan&) = delete;
+	SkinningPlan& operator=(const SkinningPlan&) = delete;
+	~SkinningPlan() = default;
+
+	/// <summary>
+	/// Work out which poses need skinning this frame, and rebuild the draw
+	/// commands if any entity moved to a different pose.
+	/// </summary>
+	/// <param name="models">The animated models, with their draw data
+	/// already loaded into the buffers.</param>
+	/// <param name="buffers_generation">The generation of the animated
+	/// buffers, so that we can tell when they have been reloaded.</param>
+	/// <returns>Whether the draw commands and draw elements changed.
+	/// </returns>
+	bool update(const std::vector<std::shared_ptr<Model>>& models,
+		const unsigned int buffers_generation);
+
+	/// <summary>
+	/// The draw parameters for the compute shader, for every pose that needs
+	/// skinning this frame.
+	/// </summary>
+	std::vector<int> parameters;
+
+	/// <summary>
+	/// The compute dispatches that use the parameters, in order.
+	/// </summary>
+	std::vector<Dispatch> dispatches;
+
+	/// <summary>
+	/// The indirect draw commands for every animated model.
+	/// </summary>
+	std::vector<int> commands;
+
+	/// <summary>
+	/// The draw elements that the draw commands refer to, one for each
+	/// instance drawn.
+	/// </summary>
+	std::vector<int> draw_elements;
+
+private:
+	/// <summary>
+	/// Which poses are already skinned, and where.
+	/// </summary>
+	PoseCache pose_cache;
+
+	/// <summary>
+	/// Which generation of the render buffers the poses were skinned into.
+	/// </summary>
+	unsigned int generation;
+
+	/// <summary>
+	/// The pose slot that each animated entity is drawn from, for every
+	/// model in order.
+	/// </summary>
+	std::vector<uint32_t> drawn_slots;
+
+	/// <summary>
+	/// The frame of each entity in the model being set up. Kept between
+	/// frames to avoid allocating.
+	/// </summary>
+	std::vector<int> frames;
+
+	/// <summary>
+	/// The pose slot of each entity in the model being set up. Kept between
+	/// frames to avoid allocating.
+	/// </summary>
+	std::vector<uint32_t> entity_slots;
+
+	/// <summary>
+	/// The pose slots that need skinning in the model being set up. Kept
+	/// between frames to avoid allocating.
+	/// </summary>
+	std::vector<uint32_t> skin_slots;
+
+	/// <summary>
+	/// Where each pose slot starts in the sorted entities, while building
+	/// commands. Kept between frames to avoid allocating.
+	/// </summary>
+	std::vector<uint32_t> slot_starts;
+
+	/// <summary>
+	/// The entities of a model sorted by pose slot, while building commands.
+	/// Kept between frames to avoid allocating.
+	/// </summary>
+	std::vector<uint32_t> sorted_entities;
+
+	/// <summary>
+	/// Build the draw commands and draw elements from the pose slot of each
+	/// entity.
+	/// </summary>
+	/// <param name="models">The animated models.</param>
+	void build_commands(const std::vector<std::shared_ptr<Model>>& models);
+};
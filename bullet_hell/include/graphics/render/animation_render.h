@@ -1,10 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "graphics/backend/opengl/quad_mesh.h"
 #include "graphics/frontend/uniforms_map.h"
 #include "graphics/graph/shader_program.h"
+#include "graphics/graph/skinning_plan.h"
 
 class RenderBuffers;
 class Scene;
@@ -19,6 +21,11 @@ private:
 	std::unique_ptr<UniformsMap> uniforms_map;
 	std::unique_ptr<QuadMesh> quad_mesh;
 
+	/// <summary>
+	/// Works out which poses to skin and how to draw them.
+	/// </summary>
+	SkinningPlan skinning_plan;
+
 public:
 	AnimationRender();
 	AnimationRender(const AnimationRender&) = delete;
@@ -26,9 +33,26 @@ public:
 	~AnimationRender() = default;
 
 	/// <summary>
-	/// Send over information for the compute shaders for animations.
+	/// Send over information for the compute shaders for animations. Each
+	/// pose is only skinned once, and every entity showing that frame of the
+	/// animation is drawn from it, so only poses that nobody was showing
+	/// last frame need skinning. Also works out the animated draw commands,
+	/// which change whenever an entity moves to a different pose.
 	/// </summary>
 	/// <param name="scene"></param>
 	/// <param name="render_buffer"></param>
 	void render(const Scene& scene, const RenderBuffers& render_buffer);
+
+	/// <summary>
+	/// Fetch the draw commands for every animated entity, as of the last
+	/// render. Culled before they are uploaded.
+	/// </summary>
+	/// <returns>The draw commands.</returns>
+	[[nodiscard]] const std::vector<int>& commands() const noexcept;
+
+	/// <summary>
+	/// Fetch the draw elements that the draw commands refer to.
+	/// </summary>
+	/// <returns>The draw elements, one for each instance.</returns>
+	[[nodiscard]] const std::vector<int>& draw_elements() const noexcept;
 };
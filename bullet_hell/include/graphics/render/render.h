@@ -1,6 +1,9 @@
 #pragma once
 
+#include <vector>
+
 #include "graphics/glad_types.h"
+#include "graphics/graph/draw_culler.h"
 #include "graphics/graph/gbuffer.h"
 #include "graphics/backend/opengl/command_buffers.h"
 #include "graphics/backend/opengl/render_buffers.h"
@@ -112,6 +115,41 @@ private:
 	/// The post-processing filter stage.
 	/// </summary>
 	FilterRender filter_render;
+
+	/// <summary>
+	/// The draw commands for every static entity, before culling.
+	/// </summary>
+	std::vector<int> static_commands;
+
+	/// <summary>
+	/// The draw elements that the static draw commands refer to, before
+	/// culling.
+	/// </summary>
+	std::vector<int> static_draw_elements;
+
+	/// <summary>
+	/// Culls the static draw commands for the camera and each shadow
+	/// cascade.
+	/// </summary>
+	DrawCuller static_culler;
+
+	/// <summary>
+	/// Culls the animated draw commands for the camera and each shadow
+	/// cascade.
+	/// </summary>
+	DrawCuller animated_culler;
+
+	/// <summary>
+	/// The draw commands left after culling for the camera. Kept between
+	/// frames to avoid allocating.
+	/// </summary>
+	std::vector<int> visible_commands;
+
+	/// <summary>
+	/// The draw elements left after culling for the camera. Kept between
+	/// frames to avoid allocating.
+	/// </summary>
+	std::vector<int> visible_draw_elements;
 	
 	/// <summary>
 	/// The Frame Buffer Object for the pre-filter render target.
@@ -128,6 +166,13 @@ private:
 	/// </summary>
 	GLuint screen_texture;
 
+	/// <summary>
+	/// Work out the bounds of every entity, and upload the draw commands
+	/// for only the entities that the camera can see.
+	/// </summary>
+	/// <param name="scene">The scene we are rendering.</param>
+	void cull_draw_commands(const Scene& scene);
+
 	/// <summary>
 	/// Restore the blending and frame buffer setup after we are done with 
 	/// rendering lights.
@@ -149,27 +194,21 @@ private:
 	void recalculate_materials(const Scene& scene);
 
 	/// <summary>
-	/// Set up the command buffers to render animated models, which should be
-	/// deleted before calling this if they are currently filled.
+	/// Set up the buffers to render animated models, which should be
+	/// deleted before calling this if they are currently filled. The draw
+	/// commands are left to the animation render, since they depend on which
+	/// poses have been skinned.
 	/// </summary>
 	/// <param name="scene">The scene we are rendering.</param>
 	void setup_animated_command_buffer(const Scene& scene);
 
 	/// <summary>
-	/// Set up the command buffers to render static models, which should be
-	/// deleted before calling this if they are currently filled.
+	/// Set up the draw commands to render static models, which should be
+	/// deleted before calling this if they are currently filled. The draw
+	/// commands are uploaded once they have been culled.
 	/// </summary>
 	/// <param name="scene">The scene we are rendering.</param>
 	void setup_static_command_buffer(const Scene& scene);
 
-	/// <summary>
-	/// Take a list of models, and upload the model matrices to the specified 
-	/// buffer.
-	/// </summary>
-	/// <param name="models">The list of models.</param>
-	/// <param name="buffer_id">The buffer we want to send data to.</param>
-	void update_model_buffer(const std::vector<std::shared_ptr<Model>> models,
-		GLuint buffer_id);
-
 	void update_model_matrices(const Scene& scene);
 };
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 
+#include "graphics/glad_types.h"
 #include "graphics/frontend/uniforms_map.h"
 #include "graphics/graph/cascade_shadow_slice.h"
+#include "graphics/graph/draw_culler.h"
 #include "graphics/graph/shader_program.h"
 #include "graphics/graph/shadow_buffer.h"
 
@@ -30,18 +33,67 @@ public:
 	ShadowRender();
 	ShadowRender(const ShadowRender&) = delete;
 	ShadowRender& operator=(const ShadowRender&) = delete;
-	~ShadowRender() = default;
+	~ShadowRender();
 
 	/// <summary>
-	/// Render the shadows for a scene.
+	/// Render the shadows for a scene. Each cascade only covers part of the
+	/// view, so the draw commands are culled against each one separately.
 	/// </summary>
 	/// <param name="scene">The scene to render.</param>
 	/// <param name="render_buffers">Bufferse for indirect drawing of models.
 	/// </param>
 	/// <param name="command_buffers">The rendering command buffers.</param>
+	/// <param name="static_culler">Culls the static draw commands, with
+	/// the bounds already gathered for this frame.</param>
+	/// <param name="animated_culler">Culls the animated draw commands, with
+	/// the bounds already gathered for this frame.</param>
 	void render(const Scene& scene, const RenderBuffers& render_buffers,
-		const CommandBuffers& command_buffers);
+		const CommandBuffers& command_buffers, DrawCuller& static_culler,
+		DrawCuller& animated_culler);
 private:
 	std::unique_ptr<ShaderProgram> shader_program;
 	std::unique_ptr<UniformsMap> uniforms_map;
+
+	/// <summary>
+	/// The static draw commands for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT> static_command_buffers;
+
+	/// <summary>
+	/// The static draw elements for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT> static_draw_element_buffers;
+
+	/// <summary>
+	/// How many static draw commands each cascade has.
+	/// </summary>
+	std::array<unsigned int, SHADOW_MAP_CASCADE_COUNT> static_draw_counts;
+
+	/// <summary>
+	/// The animated draw commands for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT> animated_command_buffers;
+
+	/// <summary>
+	/// The animated draw elements for each cascade.
+	/// </summary>
+	std::array<GLuint, SHADOW_MAP_CASCADE_COUNT>
+		animated_draw_element_buffers;
+
+	/// <summary>
+	/// How many animated draw commands each cascade has.
+	/// </summary>
+	std::array<unsigned int, SHADOW_MAP_CASCADE_COUNT> animated_draw_counts;
+
+	/// <summary>
+	/// The draw commands left after culling. Kept between frames to avoid
+	/// allocating.
+	/// </summary>
+	std::vector<int> visible_commands;
+
+	/// <summary>
+	/// The draw elements left after culling. Kept between frames to avoid
+	/// allocating.
+	/// </summary>
+	std::vector<int> visible_draw_elements;
 };
@@ -29,6 +29,8 @@ public:
 
 	AnimationData(const AnimationData&) = delete;
 	AnimationData& operator=(const AnimationData&) = delete;
+	AnimationData(AnimationData&&) = default;
+	AnimationData& operator=(AnimationData&&) = default;
 	~AnimationData() = default;
 
 	/// <summary>
@@ -51,7 +53,14 @@ public:
 	/// first interrupted.
 	/// </summary>
 	/// <param name="animation">The animation to run.</param>
-	void run_immediate_once(std::shared_ptr<Animation> animation);
+	void run_immediate_once(const std::shared_ptr<Animation>& animation);
+
+	/// <summary>
+	/// Start over from the first frame of an animation, dropping any
+	/// immediate animation that is running.
+	/// </summary>
+	/// <param name="animation">The animation to use.</param>
+	void reset(const std::shared_ptr<Animation>& animation);
 
 	/// <summary>
 	/// Swap to a different animation and start at the beginning. If we are
@@ -59,7 +68,8 @@ public:
 	/// to return to once that is done.
 	/// </summary>
 	/// <param name="animation">The new animation to use.</param>
-	void set_current_animation(std::shared_ptr<Animation> animation);
+	void set_current_animation(
+		const std::shared_ptr<Animation>& animation);
 
 private:
 	/// <summary>
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+
+#include "graphics/graph/material.h"
+#include "graphics/graph/mesh_data.h"
+#include "graphics/graph/model.h"
+
+/// <summary>
+/// Bakes the tiles of a chunk into a single model, so that the whole chunk
+/// can be drawn as one entity rather than one for every tile.
+///
+/// Each tile's meshes are transformed into place and appended to a mesh for
+/// their material, so the result has one mesh per material no matter how
+/// many tiles use it. Tiles never move, so nothing is lost by baking them.
+/// </summary>
+class ChunkMeshBuilder
+{
+public:
+	ChunkMeshBuilder();
+	ChunkMeshBuilder(const ChunkMeshBuilder&) = delete;
+	ChunkMeshBuilder& operator=(const ChunkMeshBuilder&) = delete;
+	~ChunkMeshBuilder() = default;
+
+	/// <summary>
+	/// Add a copy of every mesh in a model, moved into place.
+	/// </summary>
+	/// <param name="model">The model to copy, which must not be animated.
+	/// </param>
+	/// <param name="transform">Moves the model from its own space into the
+	/// space of the chunk.</param>
+	void add(const Model& model, const glm::mat4& transform);
+
+	/// <summary>
+	/// Check if anything has been added since the last build.
+	/// </summary>
+	/// <returns>Whether there are no meshes to build.</returns>
+	[[nodiscard]] bool empty() const noexcept;
+
+	/// <summary>
+	/// Create a model from everything that has been added, and start over.
+	/// </summary>
+	/// <param name="id">The globally unique ID of the new model.</param>
+	/// <returns>The model, with one mesh per material.</returns>
+	[[nodiscard]] std::shared_ptr<Model> build(const std::string& id);
+
+private:
+	/// <summary>
+	/// The merged meshes, one per material.
+	/// </summary>
+	std::vector<MeshData> meshes;
+
+	/// <summary>
+	/// Where in the merged meshes each material is.
+	/// </summary>
+	std::unordered_map<Material, size_t, MaterialHash> mesh_indices;
+};
@@ -1,111 +1,44 @@
 #pragma once
 
-#include <string>
-
-#include "glm/mat4x4.hpp"
-#include "glm/vec3.hpp"
-#include "glm/ext/quaternion_float.hpp"
-#include "glm/gtx/quaternion.hpp"
-
-#include "graphics/scene/animation_data.h"
+#include <cstdint>
+#include <limits>
 
 /// <summary>
-/// Something that is part of the 3D scene.
+/// Refers to something that is part of the 3D scene. The entity itself lives
+/// in the entity registry, and this is just a way to look it up.
+///
+/// Handles are cheap to copy and compare. Once an entity is destroyed the
+/// generation of its slot changes, so any handles that are left over stop
+/// being alive rather than pointing at whatever reuses the slot.
 /// </summary>
-struct Entity
+struct EntityHandle
 {
 	/// <summary>
-	/// A globally unique ID for this entity. If there are multiple 
-	/// quintillion different entities, we have larger problems than 
-	/// ID collisions.
-	/// </summary>
-	const uint64_t entity_ID;
-
-	/// <summary>
-	/// The next valid ID to use for an entity.
-	/// </summary>
-	static std::atomic<uint64_t> next_ID;
-
-	/// <summary>
-	/// The ID of the model associated to this entity.
-	/// </summary>
-	const std::string model_ID;
-
-	/// <summary>
-	/// Animation data associated with this entity.
-	/// </summary>
-	AnimationData animation_data;
-
-	/// <summary>
-	/// The combined translation, rotation, and scale transformations.
-	/// </summary>
-	glm::mat4 model_matrix;
-
-	/// <summary>
-	/// The transformation matrix.
-	/// </summary>
-	glm::vec3 position;
-
-	/// <summary>
-	/// The rotation, as a quaternion to prevent gimbal lock.
-	/// </summary>
-	glm::quat rotation;
-	
-	/// <summary>
-	/// The scale factor.
-	/// </summary>
-	float scale;
-
-	/// <summary>
-	/// Whether the scene entity should be removed.
-	/// </summary>
-	bool dead = false;
-
-	/// <summary>
-	/// Construct an entity.
+	/// Used for handles that do not refer to any entity.
 	/// </summary>
-	/// <param name="model_ID">The ID of the modal associated with this
-	/// entity.</param>
-	Entity(const std::string model_ID);
-
-	Entity(const Entity&) = delete;
-	Entity& operator=(const Entity&) = delete;
-	~Entity() = default;
+	static constexpr uint32_t INVALID_INDEX =
+		std::numeric_limits<uint32_t>::max();
 
 	/// <summary>
-	/// Add to the current rotation. The result will be as if the current
-	/// rotation was applied, then the new one was applied on top of it.
+	/// The slot in the registry that the entity was created in.
 	/// </summary>
-	/// <param name="x">The x component of the rotation axis.</param>
-	/// <param name="y">The Y component of the rotation axis.</param>
-	/// <param name="z">The z component of the rotation axis.</param>
-	/// <param name="angle">The angle in degrees.</param>
-	void add_rotation(const float x, const float y, const float z,
-		const float angle);
+	uint32_t index = INVALID_INDEX;
 
 	/// <summary>
-	/// Set the position.
+	/// How many times the slot had been reused when the entity was created.
 	/// </summary>
-	/// <param name="x">The new x position.</param>
-	/// <param name="y">The new y position.</param>
-	/// <param name="z">The new z position.</param>
-	void set_position(const float x, const float y, const float z);
+	uint32_t generation = 0;
 
 	/// <summary>
-	/// Set the rotation.
+	/// Check whether this handle was ever given an entity. It might have
+	/// been destroyed since, which only the registry can tell.
 	/// </summary>
-	/// <param name="x">The x component of the rotation axis.</param>
-	/// <param name="y">The Y component of the rotation axis.</param>
-	/// <param name="z">The z component of the rotation axis.</param>
-	/// <param name="angle">The angle in degrees.</param>
-	void set_rotation(const float x, const float y, const float z, 
-		const float angle);
-
-	void set_rotation(const glm::quat& new_rotation);
+	/// <returns>Whether the handle refers to an entity.</returns>
+	[[nodiscard]] constexpr bool valid() const noexcept
+	{
+		return index != INVALID_INDEX;
+	}
 
-	/// <summary>
-	/// Update the model matrix based on the current position, rotation, and 
-	/// scale. To be called after making updates, after all updates are done.
-	/// </summary>
-	void update_model_matrix();
-};
\ No newline at end of file
+	[[nodiscard]] constexpr bool operator==(const EntityHandle&) const noexcept
+		= default;
+};
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/ext/quaternion_float.hpp"
+
+#include "graphics/scene/animation_data.h"
+#include "graphics/scene/entity.h"
+
+/// <summary>
+/// Owns every entity in the scene, and hands out handles to them.
+///
+/// Each component is kept in its own array, packed with no gaps, so loops
+/// over every entity walk straight through memory. Handles go through a
+/// table of slots to find where an entity currently is in the arrays, since
+/// destroying an entity moves the last one into its place.
+///
+/// Entities can't be created or destroyed while anything else is using the
+/// registry, but separate entities can be updated from different threads.
+/// </summary>
+class EntityRegistry
+{
+	friend struct EntitySnapshot;
+
+public:
+	EntityRegistry();
+	EntityRegistry(const EntityRegistry&) = delete;
+	EntityRegistry& operator=(const EntityRegistry&) = delete;
+	~EntityRegistry() = default;
+
+	/// <summary>
+	/// Check whether a handle still refers to an entity.
+	/// </summary>
+	/// <param name="entity">The handle to check.</param>
+	/// <returns>Whether the entity exists and has not been destroyed.
+	/// </returns>
+	[[nodiscard]] bool alive(const EntityHandle entity) const noexcept;
+
+	/// <summary>
+	/// Create a new entity at the origin, with no rotation, a scale of 1, and
+	/// no animation.
+	/// </summary>
+	/// <param name="model_ID">The ID of the model associated with this
+	/// entity.</param>
+	/// <returns>The handle for the new entity.</returns>
+	EntityHandle create(const std::string& model_ID);
+
+	/// <summary>
+	/// Destroy an entity, and any handles to it stop being alive. Does
+	/// nothing if the entity was already destroyed.
+	/// </summary>
+	/// <param name="entity">The entity to destroy.</param>
+	void destroy(const EntityHandle entity);
+
+	/// <summary>
+	/// Fetch how many entities have been created in total, including ones
+	/// that have since been destroyed. Useful for noticing that something
+	/// was created.
+	/// </summary>
+	/// <returns>The number of entities ever created.</returns>
+	[[nodiscard]] uint64_t created_count() const noexcept;
+
+	/// <summary>
+	/// Fetch the ID of a model by its index.
+	/// </summary>
+	/// <param name="model_index">The model index, which must have been given
+	/// to an entity.</param>
+	/// <returns>The model ID.</returns>
+	[[nodiscard]] const std::string& model_ID_at(const uint32_t model_index)
+		const;
+
+	/// <summary>
+	/// Fetch the number of entities that are alive.
+	/// </summary>
+	/// <returns>How many entities there are.</returns>
+	[[nodiscard]] size_t size() const noexcept;
+
+	/// <summary>
+	/// Hand over the index of every model that has had an entity destroyed
+	/// since the last time this was called, so that only their entity lists
+	/// need to be pruned.
+	/// </summary>
+	/// <param name="model_indices">Where to add the model indices, each of
+	/// which is only added once.</param>
+	void take_models_losing_entities(std::vector<uint32_t>& model_indices);
+
+	/// <summary>
+	/// Fetch the animation data of an entity.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The animation data.</returns>
+	[[nodiscard]] AnimationData& animation_data(const EntityHandle entity);
+
+	/// <summary>
+	/// Fetch the combined translation, rotation, and scale transformations
+	/// of an entity, as of the last time model matrices were updated.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The model matrix.</returns>
+	[[nodiscard]] glm::mat4& model_matrix(const EntityHandle entity);
+
+	/// <summary>
+	/// Fetch the ID of the model associated with an entity.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The model ID.</returns>
+	[[nodiscard]] const std::string& model_ID(const EntityHandle entity) const;
+
+	/// <summary>
+	/// Fetch the index of the model associated with an entity. Every entity
+	/// with the same model ID has the same model index.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The model index.</returns>
+	[[nodiscard]] uint32_t model_index(const EntityHandle entity) const;
+
+	/// <summary>
+	/// Fetch the position of an entity. Call mark_dirty after changing it.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The position.</returns>
+	[[nodiscard]] glm::vec3& position(const EntityHandle entity);
+
+	/// <summary>
+	/// Fetch the rotation of an entity, as a quaternion to prevent gimbal
+	/// lock. Call mark_dirty after changing it.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The rotation.</returns>
+	[[nodiscard]] glm::quat& rotation(const EntityHandle entity);
+
+	/// <summary>
+	/// Fetch the scale factor of an entity. Call mark_dirty after changing
+	/// it.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The scale.</returns>
+	[[nodiscard]] float& scale(const EntityHandle entity);
+
+	/// <summary>
+	/// Add to the current rotation of an entity. The result will be as if
+	/// the current rotation was applied, then the new one was applied on top
+	/// of it.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <param name="x">The x component of the rotation axis.</param>
+	/// <param name="y">The Y component of the rotation axis.</param>
+	/// <param name="z">The z component of the rotation axis.</param>
+	/// <param name="angle">The angle in degrees.</param>
+	void add_rotation(const EntityHandle entity, const float x, const float y,
+		const float z, const float angle);
+
+	/// <summary>
+	/// Set the position of an entity.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <param name="x">The new x position.</param>
+	/// <param name="y">The new y position.</param>
+	/// <param name="z">The new z position.</param>
+	void set_position(const EntityHandle entity, const float x, const float y,
+		const float z);
+
+	/// <summary>
+	/// Set the rotation of an entity.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <param name="x">The x component of the rotation axis.</param>
+	/// <param name="y">The Y component of the rotation axis.</param>
+	/// <param name="z">The z component of the rotation axis.</param>
+	/// <param name="angle">The angle in degrees.</param>
+	void set_rotation(const EntityHandle entity, const float x, const float y,
+		const float z, const float angle);
+
+	/// <summary>
+	/// Flag the model matrix of an entity as out of date, so that it is
+	/// rebuilt the next time model matrices are updated. The setters do this
+	/// automatically, but changes made through the references that the
+	/// accessors return need to call this afterward. Different entities can be
+	/// marked from different threads at the same time.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	void mark_dirty(const EntityHandle entity);
+
+	/// <summary>
+	/// Rebuild the model matrix of every entity that has been marked dirty
+	/// since the last update, from its current position, rotation, and scale.
+	/// Entities that have not moved, such as map tiles, are skipped. Meant to
+	/// be called once per frame, after all updates are done and before
+	/// anything reads the model matrices.
+	/// </summary>
+	void update_model_matrices();
+
+private:
+	/// <summary>
+	/// The current generation of each slot, which changes every time the
+	/// entity in the slot is destroyed.
+	/// </summary>
+	std::vector<uint32_t> slot_generation;
+
+	/// <summary>
+	/// Where the entity in each slot is stored in the component arrays.
+	/// </summary>
+	std::vector<uint32_t> slot_dense_index;
+
+	/// <summary>
+	/// Slots that do not have an entity in them, ready to be reused.
+	/// </summary>
+	std::vector<uint32_t> free_slots;
+
+	/// <summary>
+	/// Which slot each entity in the component arrays belongs to.
+	/// </summary>
+	std::vector<uint32_t> dense_slot;
+
+	/// <summary>
+	/// The position of each entity.
+	/// </summary>
+	std::vector<glm::vec3> positions;
+
+	/// <summary>
+	/// The rotation of each entity.
+	/// </summary>
+	std::vector<glm::quat> rotations;
+
+	/// <summary>
+	/// The scale of each entity.
+	/// </summary>
+	std::vector<float> scales;
+
+	/// <summary>
+	/// The model matrix of each entity.
+	/// </summary>
+	std::vector<glm::mat4> model_matrices;
+
+	/// <summary>
+	/// Whether the model matrix of each entity is out of date. Kept as bytes
+	/// rather than bits so that threads marking different entities don't
+	/// share a write.
+	/// </summary>
+	std::vector<uint8_t> matrix_dirty;
+
+	/// <summary>
+	/// The animation data of each entity.
+	/// </summary>
+	std::vector<AnimationData> animations;
+
+	/// <summary>
+	/// The model index of each entity.
+	/// </summary>
+	std::vector<uint32_t> model_indices;
+
+	/// <summary>
+	/// The model ID for each model index.
+	/// </summary>
+	std::vector<std::string> model_IDs;
+
+	/// <summary>
+	/// The model index for each model ID that has been seen.
+	/// </summary>
+	std::unordered_map<std::string, uint32_t> model_ID_indices;
+
+	/// <summary>
+	/// Whether each model index has had an entity destroyed since the models
+	/// losing entities were last taken.
+	/// </summary>
+	std::vector<uint8_t> model_lost_entities;
+
+	/// <summary>
+	/// The model indices that have had an entity destroyed since they were
+	/// last taken, which is never longer than the number of models.
+	/// </summary>
+	std::vector<uint32_t> models_losing_entities;
+
+	/// <summary>
+	/// Which entities are being rebuilt during an update, kept between
+	/// updates to avoid allocating every frame.
+	/// </summary>
+	std::vector<uint32_t> dirty_indices;
+
+	/// <summary>
+	/// The number of entities ever created.
+	/// </summary>
+	uint64_t total_created;
+
+	/// <summary>
+	/// Find where an entity is stored in the component arrays.
+	/// </summary>
+	/// <param name="entity">The entity, which must be alive.</param>
+	/// <returns>The index into the component arrays.</returns>
+	[[nodiscard]] uint32_t dense_index(const EntityHandle entity) const;
+};
+
+/// <summary>
+/// A global reference to the entity registry.
+/// </summary>
+extern EntityRegistry* g_entity_registry;
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/ext/quaternion_float.hpp"
+
+#include "graphics/scene/entity.h"
+
+struct Animation;
+class EntityRegistry;
+
+/// <summary>
+/// A copy of everything in the entity registry that rendering needs, as of
+/// one simulation tick. Once captured it is never changed, so it can be read
+/// from another thread while the registry keeps being updated.
+///
+/// The arrays are laid out exactly as they were in the registry, so handles
+/// are looked up the same way.
+/// </summary>
+struct EntitySnapshot
+{
+	/// <summary>
+	/// Returned by find for handles that are not in the snapshot.
+	/// </summary>
+	static constexpr uint32_t NOT_FOUND =
+		std::numeric_limits<uint32_t>::max();
+
+	/// <summary>
+	/// The generation of each slot when the snapshot was taken.
+	/// </summary>
+	std::vector<uint32_t> slot_generation;
+
+	/// <summary>
+	/// Where the entity in each slot is stored in the other arrays.
+	/// </summary>
+	std::vector<uint32_t> slot_dense_index;
+
+	/// <summary>
+	/// Which slot each entity belongs to.
+	/// </summary>
+	std::vector<uint32_t> dense_slot;
+
+	/// <summary>
+	/// The position of each entity.
+	/// </summary>
+	std::vector<glm::vec3> positions;
+
+	/// <summary>
+	/// The rotation of each entity.
+	/// </summary>
+	std::vector<glm::quat> rotations;
+
+	/// <summary>
+	/// The scale of each entity.
+	/// </summary>
+	std::vector<float> scales;
+
+	/// <summary>
+	/// The model matrix of each entity, built from the position, rotation,
+	/// and scale above.
+	/// </summary>
+	std::vector<glm::mat4> model_matrices;
+
+	/// <summary>
+	/// The animation each entity is playing, or null if it has none. The
+	/// animations themselves are owned by whoever loaded them, and outlive
+	/// the entities that use them.
+	/// </summary>
+	std::vector<const Animation*> animations;
+
+	/// <summary>
+	/// The frame of the animation that each entity is on.
+	/// </summary>
+	std::vector<int> animation_frames;
+
+	/// <summary>
+	/// Copy the current state of the registry, reusing the memory from the
+	/// last time this snapshot was captured. The model matrices need to be
+	/// up to date first.
+	/// </summary>
+	/// <param name="registry">The registry to copy.</param>
+	void capture(const EntityRegistry& registry);
+
+	/// <summary>
+	/// Find where an entity is stored in the arrays.
+	/// </summary>
+	/// <param name="entity">The entity to look for.</param>
+	/// <returns>The index into the arrays, or NOT_FOUND if the entity did not
+	/// exist when the snapshot was taken.</returns>
+	[[nodiscard]] uint32_t find(const EntityHandle entity) const noexcept;
+
+	/// <summary>
+	/// Fetch the number of entities in the snapshot.
+	/// </summary>
+	/// <returns>How many entities there are.</returns>
+	[[nodiscard]] size_t size() const noexcept;
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/ext/quaternion_float.hpp"
+
+#include "graphics/scene/entity.h"
+#include "graphics/scene/entity_snapshot.h"
+
+struct Animation;
+struct AnimatedFrame;
+
+/// <summary>
+/// What rendering sees of the entities, blended between the last two
+/// simulation ticks so that movement stays smooth when frames and ticks
+/// don't line up.
+///
+/// The simulation runs on its own thread, so rendering never reads the
+/// entity registry directly. Instead it reads the snapshots published after
+/// each tick through this view, which is only touched by the render thread.
+/// </summary>
+class EntityView
+{
+public:
+	EntityView();
+	EntityView(const EntityView&) = delete;
+	EntityView& operator=(const EntityView&) = delete;
+	~EntityView() = default;
+
+	/// <summary>
+	/// Blend between two snapshots. Entities that did not move between them
+	/// use the model matrix from the latest snapshot as is, so only moving
+	/// entities cost anything.
+	/// </summary>
+	/// <param name="previous">The snapshot from the tick before the latest
+	/// one. May be the same as the latest one.</param>
+	/// <param name="latest">The most recently published snapshot.</param>
+	/// <param name="alpha">How far to blend from the previous snapshot to
+	/// the latest one, from 0 to 1.</param>
+	void update(std::shared_ptr<const EntitySnapshot> previous,
+		std::shared_ptr<const EntitySnapshot> latest, const float alpha);
+
+	/// <summary>
+	/// Check whether an entity is in the latest snapshot. Entities created
+	/// after it was published are not.
+	/// </summary>
+	/// <param name="entity">The entity to check.</param>
+	/// <returns>Whether the entity can be looked up.</returns>
+	[[nodiscard]] bool contains(const EntityHandle entity) const noexcept;
+
+	/// <summary>
+	/// Fetch the animation an entity is playing.
+	/// </summary>
+	/// <param name="entity">The entity.</param>
+	/// <returns>The animation, or null if the entity has none or is not in
+	/// the view.</returns>
+	[[nodiscard]] const Animation* animation(const EntityHandle entity)
+		const noexcept;
+
+	/// <summary>
+	/// Fetch the frame of animation an entity is currently on.
+	/// </summary>
+	/// <param name="entity">The entity.</param>
+	/// <returns>The frame, or null if the entity has no animation or is not
+	/// in the view.</returns>
+	[[nodiscard]] const AnimatedFrame* animation_frame(
+		const EntityHandle entity) const noexcept;
+
+	/// <summary>
+	/// Fetch the index of the frame of animation an entity is currently on.
+	/// </summary>
+	/// <param name="entity">The entity.</param>
+	/// <returns>The frame index, or 0 if the entity is not in the view.
+	/// </returns>
+	[[nodiscard]] int animation_frame_index(const EntityHandle entity)
+		const noexcept;
+
+	/// <summary>
+	/// Fetch the blended model matrix of an entity.
+	/// </summary>
+	/// <param name="entity">The entity.</param>
+	/// <returns>The model matrix. Entities that are not in the view get a
+	/// matrix of zeroes, which collapses them so that nothing is drawn.
+	/// </returns>
+	[[nodiscard]] const glm::mat4& model_matrix(const EntityHandle entity)
+		const noexcept;
+
+	/// <summary>
+	/// Fetch the blended position of an entity.
+	/// </summary>
+	/// <param name="entity">The entity.</param>
+	/// <returns>The position, or the origin if the entity is not in the view.
+	/// </returns>
+	[[nodiscard]] glm::vec3 position(const EntityHandle entity) const noexcept;
+
+	/// <summary>
+	/// Fetch the blended rotation of an entity.
+	/// </summary>
+	/// <param name="entity">The entity.</param>
+	/// <returns>The rotation, or no rotation if the entity is not in the
+	/// view.</returns>
+	[[nodiscard]] glm::quat rotation(const EntityHandle entity) const noexcept;
+
+private:
+	/// <summary>
+	/// The snapshot from the tick before the latest one.
+	/// </summary>
+	std::shared_ptr<const EntitySnapshot> previous;
+
+	/// <summary>
+	/// The most recent snapshot, which decides which entities exist and how
+	/// they are indexed.
+	/// </summary>
+	std::shared_ptr<const EntitySnapshot> latest;
+
+	/// <summary>
+	/// Whether each entity moved between the snapshots, and so uses the
+	/// blended values below instead of the ones in the latest snapshot.
+	/// </summary>
+	std::vector<uint8_t> blended;
+
+	/// <summary>
+	/// The blended position of each entity that moved.
+	/// </summary>
+	std::vector<glm::vec3> positions;
+
+	/// <summary>
+	/// The blended rotation of each entity that moved.
+	/// </summary>
+	std::vector<glm::quat> rotations;
+
+	/// <summary>
+	/// The blended scale of each entity that moved.
+	/// </summary>
+	std::vector<float> scales;
+
+	/// <summary>
+	/// The model matrix of each entity that moved.
+	/// </summary>
+	std::vector<glm::mat4> model_matrices;
+
+	/// <summary>
+	/// Which entities moved, kept between updates to avoid allocating every
+	/// frame.
+	/// </summary>
+	std::vector<uint32_t> moved_indices;
+};
+
+/// <summary>
+/// A global reference to the entity view used for rendering.
+/// </summary>
+extern EntityView* g_entity_view;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
+/// <summary>
+/// The volume that a camera can see, as six planes facing inward. Used to
+/// skip work for things that are offscreen.
+/// </summary>
+class Frustum
+{
+public:
+	/// <summary>
+	/// Create a frustum that contains everything.
+	/// </summary>
+	Frustum();
+
+	/// <summary>
+	/// Find the planes of the volume that a camera can see.
+	/// </summary>
+	/// <param name="view_projection">The projection matrix multiplied by
+	/// the view matrix.</param>
+	explicit Frustum(const glm::mat4& view_projection);
+
+	Frustum(const Frustum&) = default;
+	Frustum& operator=(const Frustum&) = default;
+	~Frustum() = default;
+
+	/// <summary>
+	/// Check if any part of a sphere might be visible.
+	/// </summary>
+	/// <param name="center">The center of the sphere in world space.</param>
+	/// <param name="radius">The radius of the sphere in world units.</param>
+	/// <returns>Whether the sphere is at least partly inside the frustum.
+	/// </returns>
+	[[nodiscard]] bool intersects_sphere(const glm::vec3& center,
+		const float radius) const noexcept;
+
+	/// <summary>
+	/// Check if any part of an axis aligned box might be visible, by testing
+	/// the corner that is furthest inside each plane.
+	/// </summary>
+	/// <param name="min">The corner of the box with the smallest coordinates,
+	/// in world space.</param>
+	/// <param name="max">The corner of the box with the largest coordinates,
+	/// in world space.</param>
+	/// <returns>Whether the box is at least partly inside the frustum.
+	/// </returns>
+	[[nodiscard]] bool intersects_box(const glm::vec3& min,
+		const glm::vec3& max) const noexcept;
+
+	/// <summary>
+	/// Check a batch of spheres at once, four at a time where SSE2 is
+	/// available. Gives the same answers as intersects_sphere.
+	/// </summary>
+	/// <param name="x">The x coordinate of each center.</param>
+	/// <param name="y">The y coordinate of each center.</param>
+	/// <param name="z">The z coordinate of each center.</param>
+	/// <param name="radius">The radius of each sphere.</param>
+	/// <param name="count">How many spheres there are.</param>
+	/// <param name="visible">Set to 1 for each sphere that is at least partly
+	/// inside the frustum, and 0 otherwise.</param>
+	void intersects_spheres(const float* x, const float* y, const float* z,
+		const float* radius, const size_t count, uint8_t* visible)
+		const noexcept;
+
+	/// <summary>
+	/// Fetch the planes, for testing against them somewhere else, such as
+	/// on the GPU.
+	/// </summary>
+	/// <returns>The left, right, bottom, top, near, and far planes, as
+	/// described for the planes themselves.</returns>
+	[[nodiscard]] const std::array<glm::vec4, 6>& get_planes() const noexcept;
+
+private:
+	/// <summary>
+	/// The left, right, bottom, top, near, and far planes. The xyz part is
+	/// the normal pointing inside, and w is the distance from the origin, so
+	/// the dot product with a point gives how far inside it is.
+	/// </summary>
+	std::array<glm::vec4, 6> planes;
+};
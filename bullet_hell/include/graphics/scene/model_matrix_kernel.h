@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/ext/quaternion_float.hpp"
+
+/// <summary>
+/// Builds model matrices from separate arrays of positions, rotations, and
+/// scales, equivalent to translate * toMat4(rotation) * scale. Each element
+/// is written directly rather than multiplying full matrices together, and
+/// 4 matrices are built at once where SSE2 is available.
+/// </summary>
+namespace ModelMatrixKernel
+{
+	/// <summary>
+	/// Build the model matrices for a list of entries. Every array is indexed
+	/// the same way, and only the listed entries are read or written.
+	/// </summary>
+	/// <param name="indices">Which entries to build.</param>
+	/// <param name="count">The number of indices.</param>
+	/// <param name="positions">The translation of each entry.</param>
+	/// <param name="rotations">The rotation of each entry, which must be
+	/// normalized.</param>
+	/// <param name="scales">The uniform scale factor of each entry.</param>
+	/// <param name="model_matrices">Where to write the matrix for each entry.
+	/// </param>
+	void build(const uint32_t* indices, const size_t count,
+		const glm::vec3* positions, const glm::quat* rotations,
+		const float* scales, glm::mat4* model_matrices) noexcept;
+}
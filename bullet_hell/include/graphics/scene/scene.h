@@ -1,10 +1,12 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "event/event.h"
@@ -16,7 +18,7 @@
 #include "graphics/scene/lights/scene_lights.h"
 #include "map/chunk_coordinates.h"
 
-struct Entity;
+class ChunkMeshBuilder;
 struct Model;
 struct Tile;
 
@@ -74,7 +76,7 @@ public:
 	/// try to draw anything in the scene.
 	/// </summary>
 	/// <param name="entity">The entity we want to add.</param>
-	void add_entity(std::shared_ptr<Entity> entity);
+	void add_entity(const EntityHandle entity);
 
 	/// <summary>
 	/// Add a model to the model map. If there are any entities that use this
@@ -84,7 +86,9 @@ public:
 	void add_model(std::shared_ptr<Model> model);
 
 	/// <summary>
-	/// Go through and remove models that are pending removal.
+	/// Remove entities that have been destroyed from the models that use
+	/// them, only looking at models that have lost entities since the last
+	/// time.
 	/// </summary>
 	void prune_models();
 
@@ -171,13 +175,25 @@ private:
 	/// A list of entities that we have added, but which we did not yet have
 	/// models for.
 	/// </summary>
-	std::vector<std::shared_ptr<Entity>> entities_pending_models;
+	std::vector<EntityHandle> entities_pending_models;
 
 	/// <summary>
 	/// A map of IDs to the corresponding model.
 	/// </summary>
 	std::map<const std::string, std::shared_ptr<Model>> model_map;
 
+	/// <summary>
+	/// The models for each type of tile, which are baked into chunk models
+	/// rather than drawn themselves.
+	/// </summary>
+	std::unordered_map<std::string, std::shared_ptr<Model>> tile_models;
+
+	/// <summary>
+	/// The model indices being pruned, kept between frames to avoid
+	/// allocating.
+	/// </summary>
+	std::vector<uint32_t> pruned_models;
+
 	/// <summary>
 	/// Used to synchronize access to the list of entities that are awaiting
 	/// models.
@@ -188,12 +204,13 @@ private:
 	void handle_chunk_unloading(EventPointer event);
 
 	/// <summary>
-	/// Given a tile and coordinates, load the appropriate model.
+	/// Given a tile and coordinates, add the appropriate model to the chunk
+	/// model.
 	/// </summary>
-	/// <param name="x">The global x coordinate of the tile.</param>
-	/// <param name="z">The global x coordinate of the tile.</param>
+	/// <param name="x">The x coordinate of the tile within the chunk.</param>
+	/// <param name="z">The z coordinate of the tile within the chunk.</param>
 	/// <param name="tile">The tile we are loading.</param>
-	/// <param name="cluster">The cluster we are loading into.</param>
+	/// <param name="builder">Builds the model for the chunk.</param>
 	void load_tile(const int& x, const int& z, const Tile& tile,
-		SceneCluster& cluster);
+		ChunkMeshBuilder& builder);
 };
\ No newline at end of file
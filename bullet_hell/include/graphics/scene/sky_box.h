@@ -3,8 +3,8 @@
 #include <memory>
 
 #include "graphics/glad_types.h"
+#include "graphics/scene/entity.h"
 
-struct Entity;
 struct MeshData;
 struct Model;
 
@@ -42,6 +42,6 @@ public:
 	/// </summary>
 	GLuint vbo_list[SKYBOX_VBO_COUNT];
 
-	std::shared_ptr<Entity> entity;
+	EntityHandle entity;
 	std::shared_ptr<Model> model;
 };
\ No newline at end of file
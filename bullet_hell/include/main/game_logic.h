@@ -3,8 +3,13 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <vector>
+
+#include "glm/vec3.hpp"
 
 #include "main/game_options.h"
+#include "main/input_recording.h"
+#include "main/simulation_thread.h"
 #include "map/game_map.h"
 #include "graphics/frontend/backend_type.h"
 #if BACKEND_CURRENT == BACKEND_OPENGL_DEPRECATED
@@ -55,8 +60,6 @@ enum class GameState
 	QUITTING
 };
 
-using Instant = std::chrono::steady_clock::time_point;
-
 /// <summary>
 /// Handles the lifecycle for the game.
 /// </summary>
@@ -151,6 +154,17 @@ public:
 	std::shared_ptr<Scene> current_scene;
 	std::shared_ptr<GameMap> current_map;
 
+	/// <summary>
+	/// Runs the game logic alongside rendering.
+	/// </summary>
+	std::unique_ptr<SimulationThread> simulation;
+
+	/// <summary>
+	/// The latest simulation snapshot as of the start of this frame, which
+	/// the UI reads from instead of the pawns themselves.
+	/// </summary>
+	std::shared_ptr<const SimulationSnapshot> frame_snapshot;
+
 	/// <summary>
 	/// The number of seconds that the current round has been going on. Counts
 	/// up from 0.
@@ -171,7 +185,6 @@ private:
 
 	Instant last_frame;
 	double seconds_since_last_frame = 0;
-	double simulation_accumulator = 0;
 
 	/// <summary>
 	/// How many frames since we last checked FPS.
@@ -180,16 +193,29 @@ private:
 	double seconds_since_last_FPS_calcualation = 0;
 	int last_FPS = 0;
 
-	Instant last_animation_tick;
-	double seconds_since_last_animation_tick = 0;
-	Instant last_map_recenter;
+	/// <summary>
+	/// Where the camera last saw the player, so it can follow them around.
+	/// </summary>
+	glm::vec3 camera_follow_position;
+
+	/// <summary>
+	/// The snapshot from the tick before frame_snapshot.
+	/// </summary>
+	std::shared_ptr<const SimulationSnapshot> previous_frame_snapshot;
+
+	/// <summary>
+	/// Entities the simulation created, on their way into the scene. Kept
+	/// between frames to avoid allocating.
+	/// </summary>
+	std::vector<EntityHandle> new_scene_entities;
 
 	[[nodiscard]] bool action_desired(const Action& action) const noexcept;
 
 	/// <summary>
-	/// Check if we need to recenter the map, and do so if required.
+	/// Fetch all of the actions the player is currently trying to do.
 	/// </summary>
-	void attempt_map_recenter();
+	/// <returns>A bit for each action that is held down.</returns>
+	[[nodiscard]] ActionBits held_actions() const noexcept;
 
 	/// <summary>
 	/// Calculate ellapsed time since last frame and update our internal
@@ -207,6 +233,29 @@ private:
 	/// </summary>
 	void process_input();
 
+	/// <summary>
+	/// Write the input recorded so far out to a file, if we are recording
+	/// input.
+	/// </summary>
+	void save_input_recording();
+
+	/// <summary>
+	/// Catch the scene up with the simulation, while holding the state lock
+	/// so that no tick runs in the middle. Adds any new entities to the
+	/// scene, drops destroyed ones, and fetches the latest snapshots.
+	/// </summary>
+	/// <param name="update_world">Whether to also process events, such as
+	/// the chunks that ticks loaded, which is only done while the game is
+	/// running.</param>
+	void sync_with_simulation(const bool update_world);
+
+	/// <summary>
+	/// Blend the entities between the snapshots fetched during the last sync
+	/// for rendering, move the camera along with the player, and upload any
+	/// changes to the scene.
+	/// </summary>
+	void update_render_state();
+
 	/// <summary>
 	/// Called to handle anything we have to do in order to put the game on
 	/// hold.
@@ -50,4 +50,17 @@ struct GameOptions
 	/// Binding from GLFW keys to which action to take when they are pressed.
 	/// </summary>
 	std::unordered_map<int, Action> key_bindings;
+
+	/// <summary>
+	/// The most ticks the simulation runs back to back to catch up after it
+	/// falls behind, like after a long load. Any more are skipped, and the
+	/// game runs in slow motion rather than getting further behind.
+	/// </summary>
+	unsigned int max_catch_up_ticks;
+
+	/// <summary>
+	/// Whether the simulation cuts back on work it can do without, like
+	/// enemy AI and animations, while it is struggling to keep up.
+	/// </summary>
+	bool shed_load_when_behind;
 };
\ No newline at end of file
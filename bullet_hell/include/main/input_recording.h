@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "main/game_options.h"
+
+struct Pawn;
+
+/// <summary>
+/// The actions that are held down during a timestep, with one bit for each
+/// action.
+/// </summary>
+using ActionBits = uint16_t;
+
+/// <summary>
+/// Fetch the bit that represents an action.
+/// </summary>
+/// <param name="action">The action.</param>
+/// <returns>The bit for the action.</returns>
+[[nodiscard]] constexpr ActionBits action_bit(const Action action) noexcept
+{
+	return static_cast<ActionBits>(1u << static_cast<unsigned int>(action));
+}
+
+static_assert(static_cast<unsigned int>(Action::PAUSE_OR_UNPAUSE_GAME)
+	< sizeof(ActionBits) * 8, "ActionBits is too small for every action");
+
+/// <summary>
+/// Tell the player what to do based on the actions that are held down. This
+/// is the only way input affects the game, so that recorded input plays out
+/// exactly the same way.
+/// </summary>
+/// <param name="player">The player pawn.</param>
+/// <param name="actions">The actions that are held down.</param>
+void apply_player_actions(Pawn& player, const ActionBits actions);
+
+/// <summary>
+/// The input for every timestep of a game, along with the seed it was
+/// played with, so that the game can be played back exactly. Whether the
+/// simulation was shedding load is recorded too, since that changes how
+/// the game plays out.
+///
+/// Input rarely changes between timesteps, so it is stored as runs of
+/// identical timesteps. Files start with the characters "BHIR", followed by
+/// the format version, seed, number of timesteps, and number of runs as
+/// little endian 32 bit integers. Each run is a 32 bit length followed by
+/// 16 bits of actions and 8 bits of flags, where the lowest bit is whether
+/// load was being shed. Version 1 files have no flags.
+/// </summary>
+class InputRecording
+{
+public:
+	InputRecording();
+	InputRecording(const InputRecording&) = delete;
+	InputRecording& operator=(const InputRecording&) = delete;
+	~InputRecording() = default;
+
+	/// <summary>
+	/// What happened during one timestep.
+	/// </summary>
+	struct Tick
+	{
+		/// <summary>
+		/// The actions held down during the timestep.
+		/// </summary>
+		ActionBits actions;
+
+		/// <summary>
+		/// Whether the simulation was shedding load during the timestep.
+		/// </summary>
+		bool shedding_load;
+	};
+
+	/// <summary>
+	/// The seed that the game was started with.
+	/// </summary>
+	uint32_t seed;
+
+	/// <summary>
+	/// Throw away everything that was recorded and start a new game.
+	/// </summary>
+	/// <param name="seed">The seed that the new game uses.</param>
+	void clear(const uint32_t seed);
+
+	/// <summary>
+	/// Expand the runs into each timestep.
+	/// </summary>
+	/// <param name="destination">Where to put the timesteps, which are added
+	/// to the end.</param>
+	void expand(std::vector<Tick>& destination) const;
+
+	/// <summary>
+	/// Read a recording from a file, replacing what is currently recorded.
+	/// </summary>
+	/// <param name="path">The file to read.</param>
+	/// <returns>Whether the file was read successfully. If not, the
+	/// recording is left empty.</returns>
+	bool load(const std::string& path);
+
+	/// <summary>
+	/// Add the next timestep.
+	/// </summary>
+	/// <param name="actions">The actions held down during the timestep.
+	/// </param>
+	/// <param name="shedding_load">Whether the simulation is shedding load
+	/// during the timestep.</param>
+	void record(const ActionBits actions, const bool shedding_load);
+
+	/// <summary>
+	/// Write the recording out to a file.
+	/// </summary>
+	/// <param name="path">The file to write.</param>
+	/// <returns>Whether the file was written successfully.</returns>
+	bool save(const std::string& path) const;
+
+	/// <summary>
+	/// Fetch the number of timesteps that have been recorded.
+	/// </summary>
+	/// <returns>The number of timesteps.</returns>
+	[[nodiscard]] uint32_t tick_count() const noexcept;
+
+private:
+	/// <summary>
+	/// A number of identical timesteps in a row.
+	/// </summary>
+	struct Run
+	{
+		uint32_t length;
+		Tick tick;
+	};
+
+	/// <summary>
+	/// The runs of timesteps, in order.
+	/// </summary>
+	std::vector<Run> runs;
+
+	/// <summary>
+	/// The total length of all the runs.
+	/// </summary>
+	uint32_t ticks;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "main/input_recording.h"
+
+class GameMap;
+
+/// <summary>
+/// Runs the game logic without a window, renderer, or any assets, so that
+/// it can be profiled and benchmarked on machines without a GPU.
+///
+/// The player is driven by input passed in for each timestep instead of a
+/// keyboard, which is either scripted or replayed from a recording. With the
+/// same seed and input, the game plays out exactly the same way each run.
+/// </summary>
+class Simulation
+{
+public:
+	/// <summary>
+	/// Set up the globals that the game logic needs, and start a new game.
+	/// </summary>
+	/// <param name="seed">The seed for each game.</param>
+	/// <param name="enemy_count">How many enemies to spawn at the start of
+	/// each game, in addition to the ones that spawn over time.</param>
+	Simulation(const uint32_t seed, const size_t enemy_count);
+	Simulation(const Simulation&) = delete;
+	Simulation& operator=(const Simulation&) = delete;
+
+	/// <summary>
+	/// Tear down the globals that were set up for the simulation.
+	/// </summary>
+	~Simulation();
+
+	/// <summary>
+	/// The number of timesteps that have been simulated, across every game.
+	/// </summary>
+	uint64_t ticks;
+
+	/// <summary>
+	/// Check if the player died during the last timestep.
+	/// </summary>
+	/// <returns>Whether the player is dead.</returns>
+	[[nodiscard]] bool player_dead() const noexcept;
+
+	/// <summary>
+	/// Start a new game with the same seed.
+	/// </summary>
+	void reset();
+
+	/// <summary>
+	/// Simulate a single timestep.
+	/// </summary>
+	/// <param name="actions">What the player is doing during the timestep.
+	/// </param>
+	/// <param name="shedding_load">Whether to shed load during the
+	/// timestep, which only replays of games that did so should.</param>
+	void tick(const ActionBits actions, const bool shedding_load);
+
+private:
+	/// <summary>
+	/// How many enemies to spawn at the start of each game.
+	/// </summary>
+	const size_t enemy_count;
+
+	/// <summary>
+	/// The seed for each game.
+	/// </summary>
+	const uint32_t seed;
+
+	/// <summary>
+	/// The map that the player is running around on.
+	/// </summary>
+	std::shared_ptr<GameMap> map;
+};
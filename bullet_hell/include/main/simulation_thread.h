@@ -0,0 +1,404 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+#include "entities/entity_types.h"
+#include "graphics/scene/entity.h"
+#include "graphics/scene/entity_snapshot.h"
+#include "main/input_recording.h"
+
+class GameMap;
+
+/// <summary>
+/// Set to 1 to write the player input for each game to a file when it ends,
+/// so that BulletHellSim can replay it as a benchmark.
+/// </summary>
+#define RECORD_INPUT 0
+
+using Instant = std::chrono::steady_clock::time_point;
+
+/// <summary>
+/// How well the simulation is keeping up with the clock. The counters add
+/// up from when the program started.
+/// </summary>
+struct SimulationLoad
+{
+	/// <summary>
+	/// How many seconds were simulated for each real second, measured over
+	/// the last second or so. Below 1 means the game is in slow motion
+	/// because ticks are being skipped.
+	/// </summary>
+	float time_dilation = 1.0f;
+
+	/// <summary>
+	/// Whether optional work is being skipped to catch up.
+	/// </summary>
+	bool shedding = false;
+
+	/// <summary>
+	/// The number of ticks that took longer to run than the time they
+	/// simulate.
+	/// </summary>
+	uint64_t overrun_ticks = 0;
+
+	/// <summary>
+	/// The number of times more ticks were due than we are allowed to run
+	/// back to back.
+	/// </summary>
+	uint64_t capped_catch_ups = 0;
+
+	/// <summary>
+	/// The number of ticks that were skipped rather than run.
+	/// </summary>
+	uint64_t dropped_ticks = 0;
+};
+
+/// <summary>
+/// Everything the render thread needs to know about one simulation tick.
+/// Never changed after it is published.
+/// </summary>
+struct SimulationSnapshot
+{
+	/// <summary>
+	/// Which tick this is, counting up from the start of the program.
+	/// </summary>
+	uint64_t tick = 0;
+
+	/// <summary>
+	/// When the tick was due, which is what rendering blends against.
+	/// </summary>
+	Instant time;
+
+	/// <summary>
+	/// The transforms and animation state of every entity.
+	/// </summary>
+	EntitySnapshot entities;
+
+	/// <summary>
+	/// The scene entity for the player.
+	/// </summary>
+	EntityHandle player_entity;
+
+	/// <summary>
+	/// The current health of the player.
+	/// </summary>
+	Health player_health = 0;
+
+	/// <summary>
+	/// The maximum health of the player.
+	/// </summary>
+	Health player_max_health = 0;
+
+	/// <summary>
+	/// The direction the player wants to face.
+	/// </summary>
+	glm::vec2 player_desired_facing;
+
+	/// <summary>
+	/// The number of enemies that are alive.
+	/// </summary>
+	size_t enemy_count = 0;
+
+	/// <summary>
+	/// The number of bullets fired by enemies.
+	/// </summary>
+	size_t enemy_bullet_count = 0;
+
+	/// <summary>
+	/// The number of bullets fired by the player.
+	/// </summary>
+	size_t player_bullet_count = 0;
+
+	/// <summary>
+	/// How well the simulation is keeping up, as of this tick.
+	/// </summary>
+	SimulationLoad load;
+};
+
+/// <summary>
+/// Runs the fixed timestep game logic on its own thread, so that a slow
+/// frame doesn't hold up the simulation and a slow tick doesn't hold up
+/// rendering.
+///
+/// After every tick a snapshot of the game state is published. The render
+/// thread takes the last two and blends between them, rather than reading
+/// anything the simulation is busy changing.
+///
+/// Anything else that changes the game state, like the map loading chunks,
+/// has to hold the state lock while it does so. Ticks hold the same lock.
+///
+/// After a stall, only a limited number of overdue ticks are run back to
+/// back and the rest are skipped, so one slow moment can't snowball into
+/// every tick after it being late. While ticks are running slow, optional
+/// work can be shed to give the simulation room to catch up.
+/// </summary>
+class SimulationThread
+{
+public:
+	/// <summary>
+	/// Start the thread, paused until resume is called.
+	/// </summary>
+	/// <param name="max_catch_up_ticks">The most overdue ticks to run back
+	/// to back before skipping the rest. Must be at least 1.</param>
+	/// <param name="shed_load_when_behind">Whether to skip optional work
+	/// while ticks are running slow.</param>
+	SimulationThread(const unsigned int max_catch_up_ticks,
+		const bool shed_load_when_behind);
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	/// <summary>
+	/// Stop the thread, waiting for the current tick to finish.
+	/// </summary>
+	~SimulationThread();
+
+	/// <summary>
+	/// Fetch the two most recently published snapshots.
+	/// </summary>
+	/// <param name="previous">Set to the snapshot from the tick before the
+	/// latest one, which is the same as the latest one right after a reset.
+	/// </param>
+	/// <param name="latest">Set to the most recent snapshot.</param>
+	void get_snapshots(std::shared_ptr<const SimulationSnapshot>& previous,
+		std::shared_ptr<const SimulationSnapshot>& latest);
+
+	/// <summary>
+	/// Lock the game state, so that it can be changed without a tick running
+	/// at the same time.
+	/// </summary>
+	/// <returns>The lock, which is held until it goes out of scope.</returns>
+	[[nodiscard]] std::unique_lock<std::mutex> lock_state();
+
+	/// <summary>
+	/// Stop running ticks until resume is called.
+	/// </summary>
+	void pause();
+
+	/// <summary>
+	/// Publish a snapshot of the current state, without waiting for a tick.
+	/// The state lock must be held.
+	/// </summary>
+	/// <param name="blend">Whether to keep blending from the previous
+	/// snapshot. If not, the new snapshot replaces both, which is what we
+	/// want after a reset. If so, the new snapshot replaces the latest one
+	/// for the same tick, which is how changes made outside of ticks are
+	/// picked up.</param>
+	void publish_now(const bool blend);
+
+	/// <summary>
+	/// Queue up an entity that was created during a tick, to be added to the
+	/// scene by the render thread. The state lock must be held, which it is
+	/// during ticks.
+	/// </summary>
+	/// <param name="entity">The new entity.</param>
+	void queue_scene_entity(const EntityHandle entity);
+
+	/// <summary>
+	/// Start running ticks, counting time from now.
+	/// </summary>
+	void resume();
+
+	/// <summary>
+	/// Set the map that ticks recenter on the player. The state lock must be
+	/// held.
+	/// </summary>
+	/// <param name="map">The map.</param>
+	void set_map(std::shared_ptr<GameMap> map);
+
+	/// <summary>
+	/// Set what the player is doing, which takes effect on the next tick.
+	/// </summary>
+	/// <param name="actions">The actions that are held down.</param>
+	void set_actions(const ActionBits actions) noexcept;
+
+	/// <summary>
+	/// Check if the player died, clearing the flag. The simulation pauses
+	/// itself when the player dies.
+	/// </summary>
+	/// <returns>Whether the player died since the last check.</returns>
+	[[nodiscard]] bool take_player_died() noexcept;
+
+	/// <summary>
+	/// Move the entities created during ticks into a list, to be added to
+	/// the scene. The state lock must be held.
+	/// </summary>
+	/// <param name="entities">The list to add to.</param>
+	void take_scene_entities(std::vector<EntityHandle>& entities);
+
+	/// <summary>
+	/// The player input for every tick of the current game. The state lock
+	/// must be held to use it.
+	/// </summary>
+	InputRecording input_recording;
+
+private:
+	/// <summary>
+	/// The most overdue ticks to run back to back.
+	/// </summary>
+	const unsigned int max_catch_up_ticks;
+
+	/// <summary>
+	/// Whether to skip optional work while ticks are running slow.
+	/// </summary>
+	const bool shed_load_when_behind;
+
+	/// <summary>
+	/// Held while changing the game state, including during ticks.
+	/// </summary>
+	std::mutex state_mutex;
+
+	/// <summary>
+	/// Guards whether we are running or stopping.
+	/// </summary>
+	std::mutex control_mutex;
+
+	/// <summary>
+	/// Signalled when we resume or start stopping.
+	/// </summary>
+	std::condition_variable control_changed;
+
+	/// <summary>
+	/// Whether ticks should be running. Guarded by the control mutex.
+	/// </summary>
+	bool running;
+
+	/// <summary>
+	/// Set when resuming, so that time spent paused isn't simulated. Guarded
+	/// by the control mutex.
+	/// </summary>
+	bool restart_clock;
+
+	/// <summary>
+	/// Set when the thread should exit. Guarded by the control mutex.
+	/// </summary>
+	bool stopping;
+
+	/// <summary>
+	/// The actions the player is holding down.
+	/// </summary>
+	std::atomic<ActionBits> actions;
+
+	/// <summary>
+	/// Set when the player dies, until the render thread notices.
+	/// </summary>
+	std::atomic<bool> player_died;
+
+	/// <summary>
+	/// The number of ticks simulated since the program started.
+	/// </summary>
+	uint64_t ticks;
+
+	/// <summary>
+	/// How well we are keeping up. Guarded by the state mutex.
+	/// </summary>
+	SimulationLoad load;
+
+	/// <summary>
+	/// A moving average of how long ticks take to run, in seconds. Guarded
+	/// by the state mutex.
+	/// </summary>
+	double average_tick_seconds;
+
+	/// <summary>
+	/// Entities created during ticks that have not been added to the scene
+	/// yet. Guarded by the state mutex.
+	/// </summary>
+	std::vector<EntityHandle> new_scene_entities;
+
+	/// <summary>
+	/// The map that ticks recenter on the player, or null until it is set.
+	/// Guarded by the state mutex.
+	/// </summary>
+	std::shared_ptr<GameMap> map;
+
+	/// <summary>
+	/// Guards the published snapshots and the pool.
+	/// </summary>
+	std::mutex snapshot_mutex;
+
+	/// <summary>
+	/// Every snapshot that has been allocated. Any that nothing else refers
+	/// to are reused, so after the first few ticks we stop allocating.
+	/// </summary>
+	std::vector<std::shared_ptr<SimulationSnapshot>> snapshot_pool;
+
+	/// <summary>
+	/// The snapshot from the tick before the latest one.
+	/// </summary>
+	std::shared_ptr<const SimulationSnapshot> previous_snapshot;
+
+	/// <summary>
+	/// The most recently published snapshot.
+	/// </summary>
+	std::shared_ptr<const SimulationSnapshot> latest_snapshot;
+
+	/// <summary>
+	/// The thread that runs ticks. Declared last so that everything it uses
+	/// is set up before it starts.
+	/// </summary>
+	std::thread thread;
+
+	/// <summary>
+	/// Find a snapshot in the pool that nothing else refers to, or allocate
+	/// a new one.
+	/// </summary>
+	/// <returns>A snapshot that is safe to overwrite.</returns>
+	[[nodiscard]] std::shared_ptr<SimulationSnapshot> acquire_snapshot();
+
+	/// <summary>
+	/// Which published snapshots a new one replaces.
+	/// </summary>
+	enum class Replace
+	{
+		/// <summary>
+		/// The result of a new tick, so the latest snapshot becomes the
+		/// previous one.
+		/// </summary>
+		PREVIOUS,
+		/// <summary>
+		/// A change to the latest tick, so only the latest is replaced.
+		/// </summary>
+		LATEST,
+		/// <summary>
+		/// There is nothing to blend from, so both are replaced.
+		/// </summary>
+		BOTH,
+	};
+
+	/// <summary>
+	/// Capture the current state and publish it. The state lock must be
+	/// held.
+	/// </summary>
+	/// <param name="time">When the state is from.</param>
+	/// <param name="replace">Which snapshots to replace.</param>
+	void publish(const Instant time, const Replace replace);
+
+	/// <summary>
+	/// The loop that the thread runs.
+	/// </summary>
+	void run();
+
+	/// <summary>
+	/// Simulate a single timestep and publish the result.
+	/// </summary>
+	/// <param name="time">When the timestep was due.</param>
+	/// <returns>Whether the player survived the timestep.</returns>
+	bool step(const Instant time);
+
+	/// <summary>
+	/// Decide whether to shed optional work, based on how long ticks have
+	/// been taking. The state lock must be held.
+	/// </summary>
+	/// <param name="fell_behind">Whether ticks were just skipped, which
+	/// always starts shedding.</param>
+	void update_shedding(const bool fell_behind);
+};
@@ -3,6 +3,7 @@
 #include <list>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "map/chunk_coordinates.h"
 
@@ -51,6 +52,26 @@ struct GameMap
 	GameMap& operator=(const GameMap&) = default;
 	~GameMap();
 
+	/// <summary>
+	/// Find the chunk that contains a world position.
+	/// </summary>
+	/// <param name="x">The x coordinate of the position in the world.</param>
+	/// <param name="z">The z coordinate of the position in the world.</param>
+	/// <returns>The coordinates of the chunk.</returns>
+	[[nodiscard]] static ChunkCoordinates chunk_at(const float x,
+		const float z) noexcept;
+
+	/// <summary>
+	/// Find how many chunks apart two chunks are, counting diagonals as one
+	/// step, which is how far out the hot and cold regions reach.
+	/// </summary>
+	/// <param name="first">One of the chunks.</param>
+	/// <param name="second">The other chunk.</param>
+	/// <returns>The distance between the chunks, measured in chunks.
+	/// </returns>
+	[[nodiscard]] static int chunk_distance(const ChunkCoordinates& first,
+		const ChunkCoordinates& second) noexcept;
+
 	/// <summary>
 	/// Fetch the chunk for the given coordinates, generating it if required.
 	/// </summary>
@@ -58,6 +79,15 @@ struct GameMap
 	/// <returns>The chunk in that location.</returns>
 	Chunk* get_cached(const ChunkCoordinates& coordinates);
 
+	/// <summary>
+	/// Fetch a chunk if it is in the hot cache, without loading anything.
+	/// </summary>
+	/// <param name="coordinates">The coordinates to look for.</param>
+	/// <returns>The chunk in that location, or null if it is not hot.
+	/// </returns>
+	[[nodiscard]] const Chunk* get_hot(const ChunkCoordinates& coordinates)
+		const;
+
 	/// <summary>
 	/// Ensure chunks are properly loaded after a player has moved to a new 
 	/// chunk.
@@ -69,6 +99,14 @@ struct GameMap
 	void recenter(const ChunkCoordinates& old_center,
 		const ChunkCoordinates& new_center);
 
+	/// <summary>
+	/// Recenter the map on the chunk containing a world position, if that is
+	/// not already the center.
+	/// </summary>
+	/// <param name="x">The x coordinate of the position in the world.</param>
+	/// <param name="z">The z coordinate of the position in the world.</param>
+	void recenter_on(const float x, const float z);
+
 	/// <summary>
 	/// Resets the map as if we had just started a new game.
 	/// </summary>
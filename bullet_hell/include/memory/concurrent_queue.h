@@ -1,9 +1,9 @@
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
 #include <queue>
 
-#include "memory/critical_section.h"
-
 /// <summary>
 /// A concurrent queue. Written by Anthony Williams, found at
 /// http://www.justsoftwaresolutions.co.uk/threading/implementing-a-thread-safe-queue-using-condition-variables.html
@@ -14,15 +14,10 @@ class ConcurrentQueue
 {
 private:
 	std::queue<T> queue;
-	CriticalSection critical_section;
-	HANDLE data_pushed;
+	std::mutex mutex;
+	std::condition_variable data_pushed;
 public:
-	ConcurrentQueue()
-	{
-		const BOOL manual_reset = TRUE;
-		const BOOL initial_state = FALSE;
-		data_pushed = CreateEvent(nullptr, manual_reset, initial_state, nullptr);
-	}
+	ConcurrentQueue() = default;
 
 	/// <summary>
 	/// Push to the queue.
@@ -31,10 +26,10 @@ public:
 	void push(T const& data)
 	{
 		{
-			ScopedCriticalSection lock(critical_section);
+			std::scoped_lock<std::mutex> lock(mutex);
 			queue.push(data);
 		}
-		PulseEvent(data_pushed);
+		data_pushed.notify_one();
 	}
 
 	/// <summary>
@@ -43,7 +38,7 @@ public:
 	/// <returns>Whether the queue is empty.</returns>
 	bool empty()
 	{
-		ScopedCriticalSection lock(critical_section);
+		std::scoped_lock<std::mutex> lock(mutex);
 		return queue.empty();
 	}
 
@@ -54,7 +49,7 @@ public:
 	/// <returns>Whether we were able to pop from the queue.</returns>
 	bool try_pop(T& result)
 	{
-		ScopedCriticalSection lock(critical_section);
+		std::scoped_lock<std::mutex> lock(mutex);
 		if (queue.empty())
 		{
 			return false;
@@ -72,11 +67,8 @@ public:
 	/// <param name="result">Where to store the result.</param>
 	void wait_and_pop(T& result)
 	{
-		ScopedCriticalSection lock(critical_section);
-		while (queue.empty())
-		{
-			WaitForSingleObject(data_pushed, 20);
-		}
+		std::unique_lock<std::mutex> lock(mutex);
+		data_pushed.wait(lock, [this]() { return !queue.empty(); });
 		result = queue.front();
 		queue.pop();
 	}
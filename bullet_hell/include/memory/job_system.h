@@ -0,0 +1,383 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "memory/work_stealing_queue.h"
+
+class JobCounter;
+
+/// <summary>
+/// Calls a user provided function for a range of items, without knowing its
+/// type.
+/// </summary>
+using JobInvoker = void(*)(void*, size_t, size_t);
+
+/// <summary>
+/// A piece of work waiting in a queue. Only used inside the job system.
+/// Each job gets a cache line to itself, since whichever thread runs it
+/// marks it as free again.
+/// </summary>
+struct alignas(64) Job
+{
+	/// <summary>
+	/// Calls the function.
+	/// </summary>
+	JobInvoker invoker = nullptr;
+
+	/// <summary>
+	/// The function to call, which belongs to whoever submitted the job.
+	/// </summary>
+	void* function = nullptr;
+
+	/// <summary>
+	/// The start of the range of items, inclusive.
+	/// </summary>
+	size_t begin = 0;
+
+	/// <summary>
+	/// The end of the range of items, exclusive.
+	/// </summary>
+	size_t end = 0;
+
+	/// <summary>
+	/// Ranges bigger than this are split in half before running, with the
+	/// second half left for other threads to steal.
+	/// </summary>
+	size_t chunk_size = 0;
+
+	/// <summary>
+	/// Counted down once the job is finished.
+	/// </summary>
+	JobCounter* counter = nullptr;
+
+	/// <summary>
+	/// Whether the job is queued or running, so that its slot can't be
+	/// handed out again yet.
+	/// </summary>
+	std::atomic<bool> in_use{ false };
+};
+
+/// <summary>
+/// Counts the jobs that have been submitted against it and not finished yet,
+/// so that they can be waited on or other jobs can be held back until they
+/// are all done. Must outlive its jobs, which waiting on it guarantees.
+/// </summary>
+class JobCounter
+{
+	friend class JobSystem;
+
+public:
+	JobCounter();
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+	~JobCounter() = default;
+
+	/// <summary>
+	/// Check if every job submitted against the counter is finished.
+	/// </summary>
+	/// <returns>Whether there is nothing left to wait for.</returns>
+	[[nodiscard]] bool done() const noexcept;
+
+private:
+	/// <summary>
+	/// The number of unfinished jobs in the low 32 bits, and the number of
+	/// threads still wrapping up the last job in the high 32 bits. The
+	/// counter is only done once both are 0, so nobody can destroy it while
+	/// a thread is still using it.
+	/// </summary>
+	std::atomic<uint64_t> state;
+
+	/// <summary>
+	/// Guards the dependents.
+	/// </summary>
+	std::mutex mutex;
+
+	/// <summary>
+	/// Jobs that are waiting for this counter to be done before they are
+	/// queued.
+	/// </summary>
+	std::vector<Job*> dependents;
+};
+
+/// <summary>
+/// Runs work across a fixed set of worker threads, along with whichever
+/// thread is waiting for it.
+///
+/// Each thread has its own queue of jobs, which it works through newest
+/// first so that the data it just touched is still in cache. Threads that
+/// run out steal the oldest jobs from the others, which tend to be the
+/// biggest, since ranges are split in half and the second half is left to
+/// be stolen. Nothing is locked along the way, apart from jobs that depend
+/// on others.
+///
+/// Waiting on a counter runs other jobs until it is done, so jobs can wait
+/// on jobs of their own without tying up a thread. Work can be submitted
+/// from the workers, and from one other thread at a time.
+///
+/// Functions are referred to rather than copied, so they have to stay alive
+/// until their counter has been waited on.
+/// </summary>
+class JobSystem
+{
+public:
+	/// <summary>
+	/// Start up the worker threads.
+	/// </summary>
+	/// <param name="worker_count">The number of threads to start, in addition
+	/// to the thread that submits work.</param>
+	JobSystem(const size_t worker_count);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/// <summary>
+	/// Stop and join all of the worker threads. Every counter must have been
+	/// waited on.
+	/// </summary>
+	~JobSystem();
+
+	/// <summary>
+	/// Process the range [0, count) in chunks spread across the workers and
+	/// the calling thread, returning once every chunk is finished. If the
+	/// whole range fits in one chunk, it is run on the calling thread.
+	/// </summary>
+	/// <typeparam name="Function">Called with the start (inclusive) and end
+	/// (exclusive) of each chunk.</typeparam>
+	/// <param name="count">The number of items to process.</param>
+	/// <param name="chunk_size">How many items to process at once. This
+	/// should be large enough that the work in each chunk outweighs the cost
+	/// of handing it out.</param>
+	/// <param name="function">The work to do for each chunk.</param>
+	template<typename Function>
+	void parallel_for(const size_t count, const size_t chunk_size,
+		Function&& function)
+	{
+		if (count <= chunk_size || workers.empty())
+		{
+			if (count > 0)
+			{
+				function(size_t{ 0 }, count);
+			}
+			return;
+		}
+		JobCounter counter;
+		submit(nullptr, counter, &function,
+			&invoke_range<std::remove_reference_t<Function>>, count,
+			chunk_size);
+		wait(counter);
+	}
+
+	/// <summary>
+	/// Queue up a function to run on any thread, without waiting for it.
+	/// </summary>
+	/// <typeparam name="Function">Called with no arguments.</typeparam>
+	/// <param name="counter">Counted up now, and down once the function has
+	/// run.</param>
+	/// <param name="function">The function, which must stay alive until the
+	/// counter has been waited on.</param>
+	template<typename Function>
+	void run(JobCounter& counter, Function& function)
+	{
+		submit(nullptr, counter, &function, &invoke_task<Function>, 1, 1);
+	}
+
+	/// <summary>
+	/// Queue up a function to run once every job submitted against another
+	/// counter is finished, without waiting for it. Both counters have to
+	/// be waited on.
+	/// </summary>
+	/// <typeparam name="Function">Called with no arguments.</typeparam>
+	/// <param name="dependency">The counter to wait for.</param>
+	/// <param name="counter">Counted up now, and down once the function has
+	/// run.</param>
+	/// <param name="function">The function, which must stay alive until the
+	/// counter has been waited on.</param>
+	template<typename Function>
+	void run_after(JobCounter& dependency, JobCounter& counter,
+		Function& function)
+	{
+		submit(&dependency, counter, &function, &invoke_task<Function>, 1, 1);
+	}
+
+	/// <summary>
+	/// Run jobs until every job submitted against a counter is finished.
+	/// </summary>
+	/// <param name="counter">The counter to wait for.</param>
+	void wait(JobCounter& counter);
+
+	/// <summary>
+	/// Fetch how many threads work is split across, including the thread
+	/// that submits it.
+	/// </summary>
+	/// <returns>The number of threads that process work.</returns>
+	[[nodiscard]] size_t thread_count() const noexcept;
+
+	/// <summary>
+	/// Fetch how many jobs have been taken from another thread's queue,
+	/// which shows how well work is being shared out.
+	/// </summary>
+	/// <returns>The number of jobs stolen since the system started.
+	/// </returns>
+	[[nodiscard]] uint64_t steal_count() const noexcept;
+
+private:
+	/// <summary>
+	/// The jobs belonging to one thread.
+	/// </summary>
+	struct ThreadQueue
+	{
+		/// <summary>
+		/// The jobs waiting to run.
+		/// </summary>
+		WorkStealingQueue<Job> queue;
+
+		/// <summary>
+		/// The jobs this thread hands out, reused in a ring once they
+		/// finish, so that submitting never allocates.
+		/// </summary>
+		std::vector<Job> jobs;
+
+		/// <summary>
+		/// Where in the ring to look for a free job next.
+		/// </summary>
+		size_t next_job;
+
+		/// <summary>
+		/// Picks which thread to steal from first.
+		/// </summary>
+		uint32_t random;
+
+		ThreadQueue(const size_t capacity, const uint32_t seed);
+	};
+
+	/// <summary>
+	/// Call a range function for a range of items.
+	/// </summary>
+	/// <typeparam name="Function">The type of the function.</typeparam>
+	/// <param name="function">A pointer to the function.</param>
+	/// <param name="begin">The start of the range, inclusive.</param>
+	/// <param name="end">The end of the range, exclusive.</param>
+	template<typename Function>
+	static void invoke_range(void* function, size_t begin, size_t end)
+	{
+		(*static_cast<Function*>(function))(begin, end);
+	}
+
+	/// <summary>
+	/// Call a function that takes no arguments.
+	/// </summary>
+	/// <typeparam name="Function">The type of the function.</typeparam>
+	/// <param name="function">A pointer to the function.</param>
+	template<typename Function>
+	static void invoke_task(void* function, size_t, size_t)
+	{
+		(*static_cast<Function*>(function))();
+	}
+
+	/// <summary>
+	/// One queue per thread, with the thread that submits work first and
+	/// then each worker.
+	/// </summary>
+	std::vector<std::unique_ptr<ThreadQueue>> queues;
+
+	/// <summary>
+	/// The worker threads.
+	/// </summary>
+	std::vector<std::thread> workers;
+
+	/// <summary>
+	/// How many workers are asleep, or about to be.
+	/// </summary>
+	std::atomic<uint32_t> sleeping_workers;
+
+	/// <summary>
+	/// Changed to wake up sleeping workers, which wait for it to change.
+	/// </summary>
+	std::atomic<uint32_t> wake_signal;
+
+	/// <summary>
+	/// The number of jobs stolen so far.
+	/// </summary>
+	std::atomic<uint64_t> steals;
+
+	/// <summary>
+	/// Set when the system is shutting down.
+	/// </summary>
+	std::atomic<bool> stopping;
+
+	/// <summary>
+	/// Find a free job in the ring of the calling thread, running other
+	/// jobs if they are all still busy.
+	/// </summary>
+	/// <param name="queue">The index of the calling thread's queue.</param>
+	/// <returns>The job, which is marked as in use.</returns>
+	[[nodiscard]] Job* allocate(const size_t queue);
+
+	/// <summary>
+	/// Find the index of the queue that belongs to the calling thread.
+	/// </summary>
+	/// <returns>The index of the queue.</returns>
+	[[nodiscard]] size_t current_queue() const noexcept;
+
+	/// <summary>
+	/// Run a job, splitting it first if it covers too many items, then
+	/// count down its counter.
+	/// </summary>
+	/// <param name="queue">The index of the calling thread's queue.</param>
+	/// <param name="job">The job to run.</param>
+	void execute(const size_t queue, Job* job);
+
+	/// <summary>
+	/// Take a job from the calling thread's queue, or steal one from another
+	/// thread if it is empty.
+	/// </summary>
+	/// <param name="queue">The index of the calling thread's queue.</param>
+	/// <returns>The job, or null if there was nothing to take.</returns>
+	[[nodiscard]] Job* find_job(const size_t queue);
+
+	/// <summary>
+	/// Count down a counter for a finished job, and queue up any jobs that
+	/// were waiting for it if it is now done.
+	/// </summary>
+	/// <param name="queue">The index of the calling thread's queue.</param>
+	/// <param name="counter">The counter.</param>
+	void finish(const size_t queue, JobCounter& counter);
+
+	/// <summary>
+	/// Put a job in the calling thread's queue and wake a worker for it, or
+	/// run it straight away if the queue is full.
+	/// </summary>
+	/// <param name="queue">The index of the calling thread's queue.</param>
+	/// <param name="job">The job.</param>
+	void push(const size_t queue, Job* job);
+
+	/// <summary>
+	/// Create a job and queue it up, once its dependency is done if it has
+	/// one.
+	/// </summary>
+	/// <param name="dependency">A counter to wait for before queueing the
+	/// job, or null to queue it now.</param>
+	/// <param name="counter">The counter for the job.</param>
+	/// <param name="function">A pointer to the function to call.</param>
+	/// <param name="invoker">Calls the function for a range.</param>
+	/// <param name="count">The number of items to process.</param>
+	/// <param name="chunk_size">How many items to process at once.</param>
+	void submit(JobCounter* dependency, JobCounter& counter, void* function,
+		JobInvoker invoker, const size_t count, const size_t chunk_size);
+
+	/// <summary>
+	/// The loop that each worker thread runs.
+	/// </summary>
+	/// <param name="queue">The index of the worker's queue.</param>
+	void worker_loop(const size_t queue);
+};
+
+/// <summary>
+/// A global reference to the job system.
+/// </summary>
+extern JobSystem* g_job_system;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "debugging/logger.h"
+
+/// <summary>
+/// A fixed size double ended queue of pointers, where one thread owns the
+/// bottom end and any other thread can take from the top. The owner pushes
+/// and pops like a stack without any locks, and only has to compete with
+/// thieves over the last item. This is the Chase-Lev deque, with the memory
+/// ordering worked out by Lê, Pop, Cohen, and Zappa Nardelli.
+/// </summary>
+/// <typeparam name="T">The type of items, which are stored as pointers.
+/// </typeparam>
+template<typename T>
+class WorkStealingQueue
+{
+public:
+	/// <summary>
+	/// Set up an empty queue.
+	/// </summary>
+	/// <param name="capacity">The most items the queue can hold, which must
+	/// be a power of 2.</param>
+	WorkStealingQueue(const size_t capacity)
+		: mask{ static_cast<int64_t>(capacity) - 1 }
+		, items(capacity)
+		, top{ 0 }
+		, bottom{ 0 }
+	{
+		LOG_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0
+			&& "Queue capacity must be a power of 2");
+	}
+	WorkStealingQueue(const WorkStealingQueue&) = delete;
+	WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+	~WorkStealingQueue() = default;
+
+	/// <summary>
+	/// Add an item to the bottom. Only the owner can push.
+	/// </summary>
+	/// <param name="item">The item to add.</param>
+	/// <returns>Whether there was room for the item.</returns>
+	bool push(T* item) noexcept
+	{
+		const int64_t b = bottom.load(std::memory_order_relaxed);
+		const int64_t t = top.load(std::memory_order_acquire);
+		if (b - t > mask)
+		{
+			return false;
+		}
+		items[b & mask].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/// <summary>
+	/// Take the most recently pushed item. Only the owner can pop.
+	/// </summary>
+	/// <returns>The item, or null if the queue is empty.</returns>
+	[[nodiscard]] T* pop() noexcept
+	{
+		const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+		if (t > b)
+		{
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T* item = items[b & mask].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// The last item, which a thief might be after as well
+			if (!top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				item = nullptr;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return item;
+	}
+
+	/// <summary>
+	/// Take the oldest item. Any thread can steal.
+	/// </summary>
+	/// <returns>The item, or null if the queue is empty or another thread
+	/// got to it first.</returns>
+	[[nodiscard]] T* steal() noexcept
+	{
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t b = bottom.load(std::memory_order_acquire);
+		if (t >= b)
+		{
+			return nullptr;
+		}
+
+		T* item = items[t & mask].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return item;
+	}
+
+private:
+	/// <summary>
+	/// Turns a position into an index in the items.
+	/// </summary>
+	const int64_t mask;
+
+	/// <summary>
+	/// The ring of items, indexed by position modulo the capacity.
+	/// </summary>
+	std::vector<std::atomic<T*>> items;
+
+	/// <summary>
+	/// The position of the oldest item, which thieves take from. Kept on its
+	/// own cache line so that thieves don't slow down the owner.
+	/// </summary>
+	alignas(64) std::atomic<int64_t> top;
+
+	/// <summary>
+	/// The position after the newest item, which only the owner changes.
+	/// </summary>
+	alignas(64) std::atomic<int64_t> bottom;
+};
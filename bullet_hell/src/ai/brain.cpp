@@ -1,11 +1,12 @@
 #include "ai/brain.h"
 
 #include "glm/glm.hpp"
+#include "glm/gtx/norm.hpp"
 
 #include "ai/ai_state.h"
 #include "entities/pawn.h"
 #include "entities/pawn_manager.h"
-#include "graphics/scene/entity.h"
+#include "graphics/scene/entity_registry.h"
 #include "utilities/math_util.h"
 
 /// <summary>
@@ -23,8 +24,10 @@ constexpr double chase_radius_squared = chase_radius * chase_radius;
 
 void Brain::update(Pawn& enemy, const Pawn& player)
 {
+	EntityRegistry& registry = *g_entity_registry;
 	const glm::vec3 player_direction_3d =
-		player.scene_entity->position - enemy.scene_entity->position;
+		registry.position(player.scene_entity)
+		- registry.position(enemy.scene_entity);
 	const glm::vec2 player_direction{
 		player_direction_3d.x, player_direction_3d.z
 	};
@@ -50,12 +53,24 @@ void Brain::update(Pawn& enemy, const Pawn& player)
 		}
 	}
 
+	// Chasing enemies follow the flow field around anything in the way, which
+	// leads straight at the player wherever nothing is
+	glm::vec2 chase_direction{ 0.0f };
+	if (enemy.state == AIState::CHASING)
+	{
+		const glm::vec3& position = registry.position(enemy.scene_entity);
+		chase_direction = g_pawn_manager->flow_field.direction(position.x,
+			position.z, glm::normalize(player_direction));
+	}
+
 	switch (enemy.state)
 	{
 	case AIState::ATTACKING:
-	case AIState::CHASING:
 		enemy.desired_facing = glm::normalize(player_direction);
 		break;
+	case AIState::CHASING:
+		enemy.desired_facing = chase_direction;
+		break;
 	case AIState::IDLE:
 	default:
 		break;
@@ -70,22 +85,22 @@ void Brain::update(Pawn& enemy, const Pawn& player)
 		enemy.wants_to_attack = true;
 		break;
 	case AIState::CHASING:
-		enemy.desired_movement = glm::normalize(player_direction);
+		enemy.desired_movement = chase_direction;
 		enemy.wants_to_attack = false;
-		enemy.scene_entity->animation_data.
+		registry.animation_data(enemy.scene_entity).
 			set_current_animation(g_pawn_manager->enemy_running_animation);
 		break;
 	case AIState::FLEEING:
 		enemy.desired_movement = -glm::normalize(player_direction);
 		enemy.wants_to_attack = false;
-		enemy.scene_entity->animation_data.
+		registry.animation_data(enemy.scene_entity).
 			set_current_animation(g_pawn_manager->enemy_running_animation);
 		break;
 	case AIState::IDLE:
 	default:
 		enemy.desired_movement = glm::vec2(0, 0);
 		enemy.wants_to_attack = false;
-		enemy.scene_entity->animation_data.
+		registry.animation_data(enemy.scene_entity).
 			set_current_animation(g_pawn_manager->enemy_idle_animation);
 		break;
 	}
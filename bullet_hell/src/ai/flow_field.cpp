@@ -0,0 +1,366 @@
+#include "ai/flow_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+
+#include "glm/geometric.hpp"
+
+#include "map/tile.h"
+
+/// <summary>
+/// The width of a tile, in world units.
+/// </summary>
+constexpr float TILE_WORLD_WIDTH = TILE_SCALE * 2;
+
+/// <summary>
+/// The total number of tiles in the field.
+/// </summary>
+constexpr uint32_t TILE_COUNT = FlowField::WIDTH * FlowField::WIDTH;
+
+/// <summary>
+/// The path cost of stepping to a tile beside the current one. Along with
+/// the diagonal cost, this is about the ratio of 1 to the square root of 2.
+/// </summary>
+constexpr uint16_t STRAIGHT_COST = 2;
+
+/// <summary>
+/// The path cost of stepping to a tile diagonally.
+/// </summary>
+constexpr uint16_t DIAGONAL_COST = 3;
+
+/// <summary>
+/// Stored as the cost of tiles that have not been reached.
+/// </summary>
+constexpr uint16_t UNREACHED = std::numeric_limits<uint16_t>::max();
+
+static_assert(static_cast<uint32_t>(TILE_COUNT) * DIAGONAL_COST < UNREACHED,
+	"Path costs could overflow");
+
+/// <summary>
+/// One of the eight tiles around a tile.
+/// </summary>
+struct Neighbour
+{
+	/// <summary>
+	/// How far over the neighbour is on the x axis.
+	/// </summary>
+	int x;
+
+	/// <summary>
+	/// How far over the neighbour is on the z axis.
+	/// </summary>
+	int z;
+
+	/// <summary>
+	/// The cost of stepping to the neighbour.
+	/// </summary>
+	uint16_t cost;
+
+	/// <summary>
+	/// The normalized direction towards the neighbour.
+	/// </summary>
+	glm::vec2 direction;
+};
+
+/// <summary>
+/// The neighbours of a tile, sides first so that they win ties.
+/// </summary>
+static const Neighbour NEIGHBOURS[] = {
+	{ 1, 0, STRAIGHT_COST, glm::vec2(1.0f, 0.0f) },
+	{ -1, 0, STRAIGHT_COST, glm::vec2(-1.0f, 0.0f) },
+	{ 0, 1, STRAIGHT_COST, glm::vec2(0.0f, 1.0f) },
+	{ 0, -1, STRAIGHT_COST, glm::vec2(0.0f, -1.0f) },
+	{ 1, 1, DIAGONAL_COST, glm::normalize(glm::vec2(1.0f, 1.0f)) },
+	{ 1, -1, DIAGONAL_COST, glm::normalize(glm::vec2(1.0f, -1.0f)) },
+	{ -1, 1, DIAGONAL_COST, glm::normalize(glm::vec2(-1.0f, 1.0f)) },
+	{ -1, -1, DIAGONAL_COST, glm::normalize(glm::vec2(-1.0f, -1.0f)) },
+};
+
+/// <summary>
+/// Find the global coordinate of the tile that a world coordinate is in.
+/// </summary>
+/// <param name="world">The coordinate in the world.</param>
+/// <returns>The tile coordinate.</returns>
+[[nodiscard]] static inline int tile_at(const float world) noexcept
+{
+	return static_cast<int>(std::floor(world / TILE_WORLD_WIDTH));
+}
+
+FlowField::FlowField()
+	: loaded{ false }
+	, stale{ false }
+	, any_blocked{ false }
+	, center{}
+	, origin_x{ 0 }
+	, origin_z{ 0 }
+	, target_x{ 0 }
+	, target_z{ 0 }
+	, target_inside{ false }
+	, walkable(TILE_COUNT, 0)
+	, visible(TILE_COUNT, 0)
+	, directions(TILE_COUNT, NO_DIRECTION)
+	, costs(TILE_COUNT, UNREACHED)
+	, buckets{}
+{}
+
+[[nodiscard]] glm::vec2 FlowField::direction(const float x, const float z,
+	const glm::vec2& straight) const noexcept
+{
+	if (!any_blocked || !target_inside)
+	{
+		return straight;
+	}
+
+	const int local_x = tile_at(x) - origin_x;
+	const int local_z = tile_at(z) - origin_z;
+	if (local_x < 0 || local_x >= WIDTH || local_z < 0 || local_z >= WIDTH)
+	{
+		return straight;
+	}
+
+	const uint32_t tile = local_x * WIDTH + local_z;
+	if (visible[tile] || directions[tile] == NO_DIRECTION)
+	{
+		return straight;
+	}
+	return NEIGHBOURS[directions[tile]].direction;
+}
+
+void FlowField::load(const GameMap& map)
+{
+	if (loaded && center == map.center)
+	{
+		return;
+	}
+	loaded = true;
+	stale = true;
+	center = map.center;
+	origin_x = (center.x - HOT_CACHE_RADIUS) * CHUNK_WIDTH;
+	origin_z = (center.z - HOT_CACHE_RADIUS) * CHUNK_WIDTH;
+
+	any_blocked = false;
+	for (int chunk_x = 0; chunk_x < HOT_CACHE_CHUNK_WIDTH; ++chunk_x)
+	{
+		for (int chunk_z = 0; chunk_z < HOT_CACHE_CHUNK_WIDTH; ++chunk_z)
+		{
+			// Anything that isn't hot has nothing loaded to stand on
+			const Chunk* chunk = map.get_hot(ChunkCoordinates{
+				center.x - HOT_CACHE_RADIUS + chunk_x,
+				center.z - HOT_CACHE_RADIUS + chunk_z });
+			for (int x = 0; x < CHUNK_WIDTH; ++x)
+			{
+				uint8_t* column = walkable.data()
+					+ (chunk_x * CHUNK_WIDTH + x) * WIDTH
+					+ chunk_z * CHUNK_WIDTH;
+				for (int z = 0; z < CHUNK_WIDTH; ++z)
+				{
+					const bool can_walk = chunk != nullptr
+						&& chunk->tiles[x][z].id != TILE_VOID;
+					column[z] = can_walk ? 1 : 0;
+					any_blocked = any_blocked || !can_walk;
+				}
+			}
+		}
+	}
+}
+
+void FlowField::update(const float x, const float z)
+{
+	if (!loaded)
+	{
+		return;
+	}
+
+	const int tile_x = tile_at(x);
+	const int tile_z = tile_at(z);
+	if (!stale && tile_x == target_x && tile_z == target_z)
+	{
+		return;
+	}
+	stale = false;
+	target_x = tile_x;
+	target_z = tile_z;
+
+	const int local_x = tile_x - origin_x;
+	const int local_z = tile_z - origin_z;
+	target_inside = local_x >= 0 && local_x < WIDTH
+		&& local_z >= 0 && local_z < WIDTH
+		&& walkable[local_x * WIDTH + local_z];
+
+	// With nothing in the way, every tile can see the target
+	if (!target_inside || !any_blocked)
+	{
+		return;
+	}
+
+	const uint32_t target = local_x * WIDTH + local_z;
+	build_directions(target);
+	build_visibility(target);
+}
+
+void FlowField::build_directions(const uint32_t target)
+{
+	std::fill(costs.begin(), costs.end(), UNREACHED);
+	std::fill(directions.begin(), directions.end(), NO_DIRECTION);
+
+	// Steps only cost a few different amounts, so rather than a priority
+	// queue the tiles are kept in a small ring of buckets by cost, and each
+	// tile is only ever looked at once it is done
+	static_assert(BUCKET_COUNT > DIAGONAL_COST,
+		"Buckets must cover the most expensive step");
+
+	costs[target] = 0;
+	buckets[0].push_back(target);
+	size_t pending = 1;
+	for (uint32_t cost = 0; pending > 0; ++cost)
+	{
+		std::vector<uint32_t>& bucket = buckets[cost % BUCKET_COUNT];
+		for (size_t i = 0; i < bucket.size(); ++i)
+		{
+			const uint32_t tile = bucket[i];
+			--pending;
+			if (costs[tile] != cost)
+			{
+				// Reached more cheaply since it was queued
+				continue;
+			}
+
+			const int x = static_cast<int>(tile) / WIDTH;
+			const int z = static_cast<int>(tile) % WIDTH;
+			for (const Neighbour& neighbour : NEIGHBOURS)
+			{
+				const int next_x = x + neighbour.x;
+				const int next_z = z + neighbour.z;
+				if (next_x < 0 || next_x >= WIDTH
+					|| next_z < 0 || next_z >= WIDTH)
+				{
+					continue;
+				}
+
+				// Paths can't cut the corners of tiles that are in the way
+				if (!walkable[next_x * WIDTH + next_z]
+					|| !walkable[next_x * WIDTH + z]
+					|| !walkable[x * WIDTH + next_z])
+				{
+					continue;
+				}
+
+				const uint32_t next = next_x * WIDTH + next_z;
+				const uint16_t next_cost =
+					static_cast<uint16_t>(cost + neighbour.cost);
+				if (next_cost < costs[next])
+				{
+					costs[next] = next_cost;
+					buckets[next_cost % BUCKET_COUNT].push_back(next);
+					++pending;
+				}
+			}
+		}
+		bucket.clear();
+	}
+
+	// Each tile points at whichever neighbour its cheapest path goes through
+	for (uint32_t tile = 0; tile < TILE_COUNT; ++tile)
+	{
+		if (tile == target || costs[tile] == UNREACHED)
+		{
+			continue;
+		}
+
+		const int x = static_cast<int>(tile) / WIDTH;
+		const int z = static_cast<int>(tile) % WIDTH;
+		uint32_t best_cost = UNREACHED;
+		for (uint8_t i = 0; i < std::size(NEIGHBOURS); ++i)
+		{
+			const Neighbour& neighbour = NEIGHBOURS[i];
+			const int next_x = x + neighbour.x;
+			const int next_z = z + neighbour.z;
+			if (next_x < 0 || next_x >= WIDTH || next_z < 0 || next_z >= WIDTH
+				|| !walkable[next_x * WIDTH + z]
+				|| !walkable[x * WIDTH + next_z])
+			{
+				continue;
+			}
+
+			const uint16_t next_cost = costs[next_x * WIDTH + next_z];
+			if (next_cost == UNREACHED)
+			{
+				continue;
+			}
+			const uint32_t through = next_cost + neighbour.cost;
+			if (through < best_cost)
+			{
+				best_cost = through;
+				directions[tile] = i;
+			}
+		}
+	}
+}
+
+void FlowField::build_visibility(const uint32_t target)
+{
+	const int to_x = static_cast<int>(target) / WIDTH;
+	const int to_z = static_cast<int>(target) % WIDTH;
+	for (uint32_t tile = 0; tile < TILE_COUNT; ++tile)
+	{
+		// Only tiles that have somewhere to go need to know
+		if (directions[tile] == NO_DIRECTION)
+		{
+			visible[tile] = 0;
+			continue;
+		}
+		const int x = static_cast<int>(tile) / WIDTH;
+		const int z = static_cast<int>(tile) % WIDTH;
+		visible[tile] = line_clear(x, z, to_x, to_z) ? 1 : 0;
+	}
+}
+
+[[nodiscard]] bool FlowField::line_clear(int from_x, int from_z,
+	const int to_x, const int to_z) const noexcept
+{
+	const int distance_x = std::abs(to_x - from_x);
+	const int distance_z = std::abs(to_z - from_z);
+	const int step_x = to_x > from_x ? 1 : -1;
+	const int step_z = to_z > from_z ? 1 : -1;
+
+	// Walk every tile the line touches, crossing whichever edge comes first
+	int steps_x = 0;
+	int steps_z = 0;
+	while (steps_x < distance_x || steps_z < distance_z)
+	{
+		const int decision = (1 + 2 * steps_x) * distance_z
+			- (1 + 2 * steps_z) * distance_x;
+		if (decision == 0)
+		{
+			// Passing exactly through a corner touches both tiles beside it
+			if (!walkable[(from_x + step_x) * WIDTH + from_z]
+				|| !walkable[from_x * WIDTH + from_z + step_z])
+			{
+				return false;
+			}
+			from_x += step_x;
+			from_z += step_z;
+			++steps_x;
+			++steps_z;
+		}
+		else if (decision < 0)
+		{
+			from_x += step_x;
+			++steps_x;
+		}
+		else
+		{
+			from_z += step_z;
+			++steps_z;
+		}
+
+		if (!walkable[from_x * WIDTH + from_z])
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -1,14 +0,0 @@
-#include "entities/bullet.h"
-
-Bullet::Bullet(const Health damage, const glm::vec2& direction, 
-	const float speed, std::shared_ptr<Entity> scene_entity)
-	: damage{ damage }
-	, direction{ direction }
-	, speed{ speed }
-	, scene_entity{ scene_entity }
-{}
-
-Bullet::~Bullet()
-{
-	scene_entity->dead = true;
-}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "entities/bullet_emitter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "glm/geometric.hpp"
+#include "glm/trigonometric.hpp"
+
+#include "debugging/logger.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) \
+	|| defined(__i386__)
+#define BULLET_EMITTER_SSE2 1
+#include <emmintrin.h>
+#else
+#define BULLET_EMITTER_SSE2 0
+#endif
+
+/// <summary>
+/// How far above the position a pattern is fired from that bullets start,
+/// in world units.
+/// </summary>
+constexpr float BULLET_SPAWN_HEIGHT = 3.0f;
+
+/// <summary>
+/// Rotate a bullet direction from the table by the aim, and work out where
+/// the bullet starts. This is the reference that the SSE2 version matches.
+/// </summary>
+static inline void aim_bullet(const float table_x, const float table_z,
+	const float aim_x, const float aim_z, const float origin_x,
+	const float origin_z, float& direction_x, float& direction_z, float& x,
+	float& z) noexcept
+{
+	direction_x = table_x * aim_x - table_z * aim_z;
+	direction_z = table_x * aim_z + table_z * aim_x;
+	x = origin_x + direction_x;
+	z = origin_z + direction_z;
+}
+
+/// <summary>
+/// Rotate every bullet direction of a volley by the aim, and work out where
+/// each bullet starts.
+/// </summary>
+static void aim_volley(const float* table_x, const float* table_z,
+	const size_t count, const float aim_x, const float aim_z,
+	const float origin_x, const float origin_z, float* direction_x,
+	float* direction_z, float* x, float* z) noexcept
+{
+	size_t i = 0;
+#if BULLET_EMITTER_SSE2
+	const __m128 wide_aim_x = _mm_set1_ps(aim_x);
+	const __m128 wide_aim_z = _mm_set1_ps(aim_z);
+	const __m128 wide_origin_x = _mm_set1_ps(origin_x);
+	const __m128 wide_origin_z = _mm_set1_ps(origin_z);
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 tx = _mm_loadu_ps(table_x + i);
+		const __m128 tz = _mm_loadu_ps(table_z + i);
+		const __m128 dx = _mm_sub_ps(_mm_mul_ps(tx, wide_aim_x),
+			_mm_mul_ps(tz, wide_aim_z));
+		const __m128 dz = _mm_add_ps(_mm_mul_ps(tx, wide_aim_z),
+			_mm_mul_ps(tz, wide_aim_x));
+		_mm_storeu_ps(direction_x + i, dx);
+		_mm_storeu_ps(direction_z + i, dz);
+		_mm_storeu_ps(x + i, _mm_add_ps(wide_origin_x, dx));
+		_mm_storeu_ps(z + i, _mm_add_ps(wide_origin_z, dz));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		aim_bullet(table_x[i], table_z[i], aim_x, aim_z, origin_x, origin_z,
+			direction_x[i], direction_z[i], x[i], z[i]);
+	}
+}
+
+BulletEmitter::BulletEmitter(BulletPool& pool)
+	: pool{ pool }
+	, patterns{}
+	, table_x{}
+	, table_z{}
+	, emissions{}
+	, volley_x{}
+	, volley_z{}
+	, volley_direction_x{}
+	, volley_direction_z{}
+{}
+
+[[nodiscard]] size_t BulletEmitter::active_count() const noexcept
+{
+	return emissions.size();
+}
+
+PatternID BulletEmitter::add_pattern(const BulletPattern& pattern)
+{
+	LOG_ASSERT(pattern.bullets_per_volley > 0 && "Patterns need bullets");
+
+	const size_t count = pattern.bullets_per_volley;
+	const PatternID id = static_cast<PatternID>(patterns.size());
+	patterns.push_back(CompiledPattern{ pattern, table_x.size() });
+
+	const bool all_around = pattern.shape == PatternShape::RING
+		|| pattern.shape == PatternShape::SPIRAL;
+	const double arc = glm::radians(static_cast<double>(
+		all_around ? 360.0f : pattern.arc_degrees));
+	// A full circle would put the last bullet on top of the first
+	const double step = all_around ? arc / count
+		: count > 1 ? arc / (count - 1) : 0.0;
+	const double start = all_around ? 0.0 : -arc / 2;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double angle = start + step * i;
+		table_x.push_back(static_cast<float>(std::cos(angle)));
+		table_z.push_back(static_cast<float>(std::sin(angle)));
+	}
+
+	if (volley_x.size() < count)
+	{
+		volley_x.resize(count);
+		volley_z.resize(count);
+		volley_direction_x.resize(count);
+		volley_direction_z.resize(count);
+	}
+	return id;
+}
+
+void BulletEmitter::clear()
+{
+	emissions.clear();
+}
+
+void BulletEmitter::fire(const PatternID pattern, const glm::vec3& position,
+	const glm::vec2& aim)
+{
+	LOG_ASSERT(pattern < patterns.size() && "Firing an unknown pattern");
+	const CompiledPattern& compiled = patterns[pattern];
+	fire_volley(compiled, position, aim, 0.0f, 0);
+	if (compiled.pattern.volleys > 1)
+	{
+		emissions.push_back(Emission{ pattern, position, aim, 0.0f, 1 });
+	}
+}
+
+void BulletEmitter::update(const float delta_time, const glm::vec2& target)
+{
+	for (Emission& emission : emissions)
+	{
+		const CompiledPattern& compiled = patterns[emission.pattern];
+		const BulletPattern& pattern = compiled.pattern;
+		emission.elapsed += delta_time;
+		while (emission.volleys_fired < pattern.volleys
+			&& emission.elapsed
+				>= pattern.volley_interval * emission.volleys_fired)
+		{
+			glm::vec2 aim = emission.aim;
+			if (pattern.shape == PatternShape::AIMED_BURST)
+			{
+				const glm::vec2 offset = target
+					- glm::vec2(emission.position.x, emission.position.z);
+				const float length = glm::length(offset);
+				if (length > 0.0f)
+				{
+					aim = offset / length;
+				}
+			}
+			fire_volley(compiled, emission.position, aim, emission.elapsed,
+				emission.volleys_fired);
+			++emission.volleys_fired;
+		}
+	}
+	std::erase_if(emissions, [this](const Emission& emission)
+		{
+			return emission.volleys_fired
+				>= patterns[emission.pattern].pattern.volleys;
+		});
+}
+
+void BulletEmitter::fire_volley(const CompiledPattern& compiled,
+	const glm::vec3& position, const glm::vec2& aim, const float elapsed,
+	const unsigned int volley)
+{
+	const BulletPattern& pattern = compiled.pattern;
+
+	glm::vec2 turned_aim = aim;
+	if (pattern.angular_velocity != 0.0f)
+	{
+		const float turn = glm::radians(pattern.angular_velocity * elapsed);
+		const float cos_turn = std::cos(turn);
+		const float sin_turn = std::sin(turn);
+		turned_aim = glm::vec2(aim.x * cos_turn - aim.y * sin_turn,
+			aim.x * sin_turn + aim.y * cos_turn);
+	}
+
+	const size_t count = pattern.bullets_per_volley;
+	aim_volley(table_x.data() + compiled.first_direction,
+		table_z.data() + compiled.first_direction, count, turned_aim.x,
+		turned_aim.y, position.x, position.z, volley_direction_x.data(),
+		volley_direction_z.data(), volley_x.data(), volley_z.data());
+
+	pool.spawn_batch(count, volley_x.data(), position.y + BULLET_SPAWN_HEIGHT,
+		volley_z.data(), volley_direction_x.data(),
+		volley_direction_z.data(),
+		pattern.speed + pattern.speed_step * volley, pattern.damage);
+}
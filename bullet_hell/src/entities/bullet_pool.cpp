@@ -0,0 +1,198 @@
+#include "entities/bullet_pool.h"
+
+#include "graphics/scene/entity_registry.h"
+
+BulletPool::BulletPool(const EntityHandler& add_entity,
+	const std::string& model_ID, const size_t capacity)
+	: add_entity{ add_entity }
+	, model_ID{ model_ID }
+{
+	position_x.reserve(capacity);
+	position_y.reserve(capacity);
+	position_z.reserve(capacity);
+	direction_x.reserve(capacity);
+	direction_z.reserve(capacity);
+	speed.reserve(capacity);
+	damage.reserve(capacity);
+	lifetime.reserve(capacity);
+	if (!add_entity.isNull())
+	{
+		scene_entity.reserve(capacity);
+	}
+}
+
+BulletPool::~BulletPool()
+{
+	clear();
+}
+
+void BulletPool::advance(const float delta_time) noexcept
+{
+	const size_t count = size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float distance = speed[i] * delta_time;
+		position_x[i] += direction_x[i] * distance;
+		position_z[i] += direction_z[i] * distance;
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		lifetime[i] -= delta_time;
+	}
+}
+
+void BulletPool::clear()
+{
+	for (const EntityHandle entity : scene_entity)
+	{
+		g_entity_registry->destroy(entity);
+	}
+	position_x.clear();
+	position_y.clear();
+	position_z.clear();
+	direction_x.clear();
+	direction_z.clear();
+	speed.clear();
+	damage.clear();
+	lifetime.clear();
+	scene_entity.clear();
+}
+
+[[nodiscard]] bool BulletPool::empty() const noexcept
+{
+	return position_x.empty();
+}
+
+void BulletPool::release(const size_t index)
+{
+	const size_t last = size() - 1;
+
+	if (!add_entity.isNull())
+	{
+		g_entity_registry->destroy(scene_entity[index]);
+		scene_entity[index] = scene_entity[last];
+		scene_entity.pop_back();
+	}
+
+	position_x[index] = position_x[last];
+	position_y[index] = position_y[last];
+	position_z[index] = position_z[last];
+	direction_x[index] = direction_x[last];
+	direction_z[index] = direction_z[last];
+	speed[index] = speed[last];
+	damage[index] = damage[last];
+	lifetime[index] = lifetime[last];
+
+	position_x.pop_back();
+	position_y.pop_back();
+	position_z.pop_back();
+	direction_x.pop_back();
+	direction_z.pop_back();
+	speed.pop_back();
+	damage.pop_back();
+	lifetime.pop_back();
+}
+
+void BulletPool::release_expired()
+{
+	size_t i = 0;
+	while (i < size())
+	{
+		if (lifetime[i] <= 0)
+		{
+			// The last bullet is moved into this slot, so check it again
+			release(i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+Health BulletPool::release_hits(const uint8_t* hit_masks)
+{
+	// Walk backwards so that the bullet moved into a released slot has
+	// already been checked
+	Health total = 0;
+	for (size_t i = size(); i-- > 0;)
+	{
+		if ((hit_masks[i / 8] & (1u << (i % 8))) != 0)
+		{
+			total += damage[i];
+			release(i);
+		}
+	}
+	return total;
+}
+
+[[nodiscard]] size_t BulletPool::size() const noexcept
+{
+	return position_x.size();
+}
+
+void BulletPool::spawn(const glm::vec3& position, const glm::vec2& direction,
+	const float speed, const Health damage)
+{
+	position_x.push_back(position.x);
+	position_y.push_back(position.y);
+	position_z.push_back(position.z);
+	direction_x.push_back(direction.x);
+	direction_z.push_back(direction.y);
+	this->speed.push_back(speed);
+	this->damage.push_back(damage);
+	lifetime.push_back(BULLET_LIFESPAN);
+
+	if (!add_entity.isNull())
+	{
+		const EntityHandle entity = g_entity_registry->create(model_ID);
+		g_entity_registry->set_position(entity, position.x, position.y,
+			position.z);
+		add_entity(entity);
+		scene_entity.push_back(entity);
+	}
+}
+
+void BulletPool::spawn_batch(const size_t count, const float* x,
+	const float y, const float* z, const float* direction_x,
+	const float* direction_z, const float speed, const Health damage)
+{
+	position_x.insert(position_x.end(), x, x + count);
+	position_y.insert(position_y.end(), count, y);
+	position_z.insert(position_z.end(), z, z + count);
+	this->direction_x.insert(this->direction_x.end(), direction_x,
+		direction_x + count);
+	this->direction_z.insert(this->direction_z.end(), direction_z,
+		direction_z + count);
+	this->speed.insert(this->speed.end(), count, speed);
+	this->damage.insert(this->damage.end(), count, damage);
+	lifetime.insert(lifetime.end(), count, BULLET_LIFESPAN);
+
+	if (add_entity.isNull())
+	{
+		return;
+	}
+	EntityRegistry& registry = *g_entity_registry;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const EntityHandle entity = registry.create(model_ID);
+		registry.set_position(entity, x[i], y, z[i]);
+		add_entity(entity);
+		scene_entity.push_back(entity);
+	}
+}
+
+void BulletPool::update_scene_entities()
+{
+	EntityRegistry& registry = *g_entity_registry;
+	const size_t count = scene_entity.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const EntityHandle entity = scene_entity[i];
+		glm::vec3& position = registry.position(entity);
+		position.x = position_x[i];
+		position.y = position_y[i];
+		position.z = position_z[i];
+		registry.mark_dirty(entity);
+	}
+}
@@ -0,0 +1,320 @@
+#include "entities/collision_kernel.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) \
+	|| defined(__i386__)
+#define COLLISION_KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define COLLISION_KERNEL_X86 0
+#endif
+
+#if COLLISION_KERNEL_X86 && (defined(__GNUC__) || defined(__clang__))
+/// <summary>
+/// Lets GCC and Clang compile AVX2 intrinsics in a single function without
+/// requiring AVX2 for the whole program. MSVC allows them anywhere.
+/// </summary>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace CollisionKernel
+{
+	using FindFirstWithin = size_t(*)(const float*, const float*,
+		const size_t, const float, const float, const float);
+	using FindWithin = void(*)(const float*, const float*, const size_t,
+		const float, const float, const float, uint8_t*);
+
+	/// <summary>
+	/// Scalar version of find_first_within, also used for the leftover points
+	/// of the wider versions.
+	/// </summary>
+	static size_t find_first_within_scalar(const float* x, const float* z,
+		const size_t count, const float center_x, const float center_z,
+		const float radius_squared) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (within(x[i], z[i], center_x, center_z, radius_squared))
+			{
+				return i;
+			}
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// Scalar version of find_within, also used for the leftover points of the
+	/// wider versions.
+	/// </summary>
+	static void find_within_scalar(const float* x, const float* z,
+		const size_t count, const float center_x, const float center_z,
+		const float radius_squared, uint8_t* hit_masks) noexcept
+	{
+		std::fill(hit_masks, hit_masks + mask_count(count), uint8_t{ 0 });
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (within(x[i], z[i], center_x, center_z, radius_squared))
+			{
+				hit_masks[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+			}
+		}
+	}
+
+#if COLLISION_KERNEL_X86
+
+	/// <summary>
+	/// Test 4 points starting at the given index.
+	/// </summary>
+	/// <returns>A 4 bit hit mask.</returns>
+	static inline uint32_t test_4_sse2(const float* x, const float* z,
+		const size_t index, const __m128 center_x, const __m128 center_z,
+		const __m128 radius_squared) noexcept
+	{
+		const __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + index), center_x);
+		const __m128 dz = _mm_sub_ps(_mm_loadu_ps(z + index), center_z);
+		const __m128 distance_squared =
+			_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+		return static_cast<uint32_t>(
+			_mm_movemask_ps(_mm_cmple_ps(distance_squared, radius_squared)));
+	}
+
+	/// <summary>
+	/// SSE2 version of find_first_within, testing 4 points at a time.
+	/// </summary>
+	static size_t find_first_within_sse2(const float* x, const float* z,
+		const size_t count, const float center_x, const float center_z,
+		const float radius_squared) noexcept
+	{
+		const __m128 wide_center_x = _mm_set1_ps(center_x);
+		const __m128 wide_center_z = _mm_set1_ps(center_z);
+		const __m128 wide_radius_squared = _mm_set1_ps(radius_squared);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const uint32_t mask = test_4_sse2(x, z, i, wide_center_x,
+				wide_center_z, wide_radius_squared);
+			if (mask != 0)
+			{
+				return i + std::countr_zero(mask);
+			}
+		}
+		const size_t tail = find_first_within_scalar(x + i, z + i, count - i,
+			center_x, center_z, radius_squared);
+		return i + tail;
+	}
+
+	/// <summary>
+	/// SSE2 version of find_within, testing 4 points at a time.
+	/// </summary>
+	static void find_within_sse2(const float* x, const float* z,
+		const size_t count, const float center_x, const float center_z,
+		const float radius_squared, uint8_t* hit_masks) noexcept
+	{
+		const __m128 wide_center_x = _mm_set1_ps(center_x);
+		const __m128 wide_center_z = _mm_set1_ps(center_z);
+		const __m128 wide_radius_squared = _mm_set1_ps(radius_squared);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const uint32_t low = test_4_sse2(x, z, i, wide_center_x,
+				wide_center_z, wide_radius_squared);
+			const uint32_t high = test_4_sse2(x, z, i + 4, wide_center_x,
+				wide_center_z, wide_radius_squared);
+			hit_masks[i / 8] = static_cast<uint8_t>(low | (high << 4));
+		}
+		// Starts on a mask boundary, so the scalar version fills the rest
+		find_within_scalar(x + i, z + i, count - i, center_x, center_z,
+			radius_squared, hit_masks + i / 8);
+	}
+
+	/// <summary>
+	/// Test 8 points starting at the given index.
+	/// </summary>
+	/// <returns>An 8 bit hit mask.</returns>
+	static TARGET_AVX2 inline uint32_t test_8_avx2(const float* x,
+		const float* z, const size_t index, const __m256 center_x,
+		const __m256 center_z, const __m256 radius_squared) noexcept
+	{
+		const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + index), center_x);
+		const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z + index), center_z);
+		const __m256 distance_squared =
+			_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz));
+		return static_cast<uint32_t>(_mm256_movemask_ps(
+			_mm256_cmp_ps(distance_squared, radius_squared, _CMP_LE_OQ)));
+	}
+
+	/// <summary>
+	/// AVX2 version of find_first_within, testing 8 points at a time.
+	/// </summary>
+	static TARGET_AVX2 size_t find_first_within_avx2(const float* x,
+		const float* z, const size_t count, const float center_x,
+		const float center_z, const float radius_squared) noexcept
+	{
+		const __m256 wide_center_x = _mm256_set1_ps(center_x);
+		const __m256 wide_center_z = _mm256_set1_ps(center_z);
+		const __m256 wide_radius_squared = _mm256_set1_ps(radius_squared);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const uint32_t mask = test_8_avx2(x, z, i, wide_center_x,
+				wide_center_z, wide_radius_squared);
+			if (mask != 0)
+			{
+				return i + std::countr_zero(mask);
+			}
+		}
+		const size_t tail = find_first_within_scalar(x + i, z + i, count - i,
+			center_x, center_z, radius_squared);
+		return i + tail;
+	}
+
+	/// <summary>
+	/// AVX2 version of find_within, testing 8 points at a time.
+	/// </summary>
+	static TARGET_AVX2 void find_within_avx2(const float* x, const float* z,
+		const size_t count, const float center_x, const float center_z,
+		const float radius_squared, uint8_t* hit_masks) noexcept
+	{
+		const __m256 wide_center_x = _mm256_set1_ps(center_x);
+		const __m256 wide_center_z = _mm256_set1_ps(center_z);
+		const __m256 wide_radius_squared = _mm256_set1_ps(radius_squared);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			hit_masks[i / 8] = static_cast<uint8_t>(test_8_avx2(x, z, i,
+				wide_center_x, wide_center_z, wide_radius_squared));
+		}
+		// Starts on a mask boundary, so the scalar version fills the rest
+		find_within_scalar(x + i, z + i, count - i, center_x, center_z,
+			radius_squared, hit_masks + i / 8);
+	}
+
+	/// <summary>
+	/// Check if the processor and operating system both support AVX2.
+	/// </summary>
+	/// <returns>Whether we can use AVX2.</returns>
+	static bool supports_avx2() noexcept
+	{
+#if defined(_MSC_VER)
+		int registers[4];
+		__cpuid(registers, 0);
+		if (registers[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(registers, 1);
+		const bool os_saves_registers = (registers[2] & (1 << 27)) != 0;
+		const bool has_avx = (registers[2] & (1 << 28)) != 0;
+		if (!os_saves_registers || !has_avx)
+		{
+			return false;
+		}
+
+		// The OS has to preserve the SSE and AVX state across context switches
+		if ((_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(registers, 7, 0);
+		return (registers[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+#endif // COLLISION_KERNEL_X86
+
+	/// <summary>
+	/// The implementations currently in use.
+	/// </summary>
+	struct Dispatch
+	{
+		InstructionSet instruction_set;
+		FindFirstWithin find_first_within;
+		FindWithin find_within;
+	};
+
+	/// <summary>
+	/// Fetch the implementations for an instruction set.
+	/// </summary>
+	/// <param name="instruction_set">The instruction set to use.</param>
+	/// <returns>The implementations to use.</returns>
+	static Dispatch dispatch_for(const InstructionSet instruction_set) noexcept
+	{
+		switch (instruction_set)
+		{
+#if COLLISION_KERNEL_X86
+		case InstructionSet::AVX2:
+			return Dispatch{ instruction_set, find_first_within_avx2,
+				find_within_avx2 };
+		case InstructionSet::SSE2:
+			return Dispatch{ instruction_set, find_first_within_sse2,
+				find_within_sse2 };
+#endif
+		default:
+			return Dispatch{ InstructionSet::SCALAR,
+				find_first_within_scalar, find_within_scalar };
+		}
+	}
+
+	/// <summary>
+	/// The implementations that calls are forwarded to.
+	/// </summary>
+	static Dispatch active = dispatch_for(supported_instruction_set());
+
+	[[nodiscard]] size_t find_first_within(const float* x, const float* z,
+		const size_t count, const float center_x, const float center_z,
+		const float radius_squared) noexcept
+	{
+		return active.find_first_within(x, z, count, center_x, center_z,
+			radius_squared);
+	}
+
+	void find_within(const float* x, const float* z, const size_t count,
+		const float center_x, const float center_z, const float radius_squared,
+		uint8_t* hit_masks) noexcept
+	{
+		active.find_within(x, z, count, center_x, center_z, radius_squared,
+			hit_masks);
+	}
+
+	[[nodiscard]] InstructionSet get_instruction_set() noexcept
+	{
+		return active.instruction_set;
+	}
+
+	bool set_instruction_set(const InstructionSet instruction_set) noexcept
+	{
+		if (instruction_set > supported_instruction_set())
+		{
+			return false;
+		}
+		active = dispatch_for(instruction_set);
+		return true;
+	}
+
+	[[nodiscard]] InstructionSet supported_instruction_set() noexcept
+	{
+#if COLLISION_KERNEL_X86
+		// SSE2 is part of every 64 bit x86 processor, and MSVC assumes it
+		// for 32 bit builds too
+		return supports_avx2() ? InstructionSet::AVX2 : InstructionSet::SSE2;
+#else
+		return InstructionSet::SCALAR;
+#endif
+	}
+}
@@ -1,6 +1,6 @@
 #include "entities/pawn.h"
 
-#include "graphics/scene/entity.h"
+#include "graphics/scene/entity_registry.h"
 
 Pawn::Pawn()
 	: desired_facing{ 0.0f, 0.0f }
@@ -11,7 +11,7 @@ Pawn::Pawn()
 	, state{ AIState::IDLE }
 {}
 
-Pawn::Pawn(std::shared_ptr<Entity> entity, Health health)
+Pawn::Pawn(const EntityHandle entity, Health health)
 	: desired_facing{ 0.0f, 0.0f }
 	, desired_movement{ 0.0f, 0.0f }
 	, health{ health }
@@ -22,5 +22,5 @@ Pawn::Pawn(std::shared_ptr<Entity> entity, Health health)
 
 Pawn::~Pawn()
 {
-	scene_entity->dead = true;
+	g_entity_registry->destroy(scene_entity);
 }
\ No newline at end of file
@@ -1,18 +1,19 @@
 #include "entities/pawn_manager.h"
 
 #include <cmath>
-#include <float.h>
+
+#include "glm/gtx/quaternion.hpp"
 
 #include "ai/brain.h"
 #include "debugging/logger.h"
 #include "debugging/timer.h"
-#include "entities/bullet.h"
+#include "entities/bullet_pool.h"
+#include "entities/collision_kernel.h"
 #include "entities/pawn.h"
-#include "graphics/graph/animation_resource.h"
-#include "graphics/graph/model_resource.h"
-#include "graphics/scene/entity.h"
-#include "graphics/scene/scene.h"
-#include "main/game_logic.h"
+#include "entities/separation.h"
+#include "graphics/scene/entity_registry.h"
+#include "map/game_map.h"
+#include "memory/job_system.h"
 #include "utilities/math_util.h"
 
 PawnManager* g_pawn_manager = nullptr;
@@ -45,10 +46,14 @@ constexpr float PLAYER_MOVE_SPEED =
 /// </summary>
 constexpr float ENEMY_MOVE_SPEED = PLAYER_MOVE_SPEED * 0.40f;
 
+static_assert(BULLET_MOVE_SPEED_PER_SECOND
+	== PLAYER_MOVE_SPEED_PER_SECOND * 3.0f,
+	"Bullets should be three times as fast as the player");
+
 /// <summary>
-/// The base movement speed of bullets, in world units per timestep.
+/// How many bullets of each kind we allocate space for up front.
 /// </summary>
-constexpr float BULLET_MOVE_SPEED = PLAYER_MOVE_SPEED * 3.0f;
+constexpr size_t BULLET_POOL_CAPACITY = 1000;
 
 /// <summary>
 /// The maximum number of enemies that we can ever have at once.
@@ -78,132 +83,358 @@ constexpr float COLLISION_RADIUS = 0.5;
 constexpr float COLLISION_RADIUS_SQUARED = COLLISION_RADIUS 
 	* COLLISION_RADIUS;
 
+/// <summary>
+/// How close the centers of two pawns can get before they are pushed apart,
+/// which is when their collision areas start to overlap.
+/// </summary>
+constexpr float PAWN_SEPARATION_DISTANCE = COLLISION_RADIUS * 2.0f;
+
+/// <summary>
+/// The furthest an enemy can be pushed away from other enemies in one
+/// timestep, so that crowds spread out smoothly instead of jumping apart.
+/// </summary>
+constexpr float MAX_SEPARATION_PUSH = PLAYER_MOVE_SPEED;
+
+/// <summary>
+/// The width of the cells in the enemy grid. Bullets only collide within
+/// the collision radius and pawns only push each other within the
+/// separation distance, so this is large enough for both to only check the
+/// neighbouring cells.
+/// </summary>
+constexpr float ENEMY_GRID_CELL_SIZE = COLLISION_RADIUS * 2.0f;
+
+static_assert(ENEMY_GRID_CELL_SIZE >= PAWN_SEPARATION_DISTANCE,
+	"Separation needs every overlap to be in a neighbouring cell");
+
+//NOTE(ches) The grid is built every tick for targeting, but for small numbers
+// of enemies a brute force pass is still faster than a grid lookup. This was
+// picked by running BulletHellSim --bullet-grid, which times both across a
+// range of enemy counts. With the SIMD collision kernel the grid pulls ahead
+// somewhere between 128 and 256 enemies.
+
+/// <summary>
+/// The fewest enemies we need before we use the grid for bullet collision.
+/// </summary>
+constexpr size_t ENEMY_GRID_MINIMUM_ENEMIES = 128;
+
+/// <summary>
+/// How many enemies each worker updates at once while running AI.
+/// </summary>
+constexpr size_t AI_CHUNK_SIZE = 256;
+
+/// <summary>
+/// How many enemies each worker moves at once.
+/// </summary>
+constexpr size_t MOVEMENT_CHUNK_SIZE = 256;
+
+/// <summary>
+/// The delay between animation frames, in seconds.
+/// </summary>
+constexpr double ANIMATION_FRAME_TIME = 1.0 / 24;
+
+/// <summary>
+/// While shedding load, each enemy only rethinks what it is doing once every
+/// this many ticks, and keeps doing the same thing in between.
+/// </summary>
+constexpr size_t SHED_AI_INTERVAL = 2;
+
+/// <summary>
+/// While shedding load, enemies animate this many times less often than
+/// they would otherwise.
+/// </summary>
+constexpr size_t SHED_ANIMATION_INTERVAL = 2;
+
+/// <summary>
+/// How far from its position an enemy might reach, for checking whether it
+/// can be seen.
+/// </summary>
+constexpr float ANIMATION_CULL_RADIUS = 2.0f;
+
+/// <summary>
+/// Enemies within this distance of the camera animate every frame. The
+/// camera sits about 27 units from the player.
+/// </summary>
+constexpr float ANIMATION_FULL_RATE_DISTANCE = 40.0f;
+
+/// <summary>
+/// Enemies within this distance of the camera, but not close enough for the
+/// full rate, animate every other frame.
+/// </summary>
+constexpr float ANIMATION_HALF_RATE_DISTANCE = 70.0f;
+
+/// <summary>
+/// How many frames apart enemies beyond the half rate distance animate.
+/// </summary>
+constexpr size_t ANIMATION_FAR_INTERVAL = 4;
+
 #pragma endregion
 
-PawnManager::PawnManager()
-	: player_bullets{ 1000 }
-	, enemy_bullets{ 1000 }
+PawnManager::PawnManager(const PawnAssets& assets,
+	const EntityHandler& add_entity, const uint32_t seed)
+	: player_bullets{ add_entity, assets.player_bullet_model_id,
+		BULLET_POOL_CAPACITY }
+	, enemy_bullets{ add_entity, assets.enemy_bullet_model_id,
+		BULLET_POOL_CAPACITY }
 	, player{ std::make_shared<Pawn>() }
-	, random{}
-	, spawn_offset{ -SPAWN_RADIUS, SPAWN_RADIUS }
+	, shedding_load{ false }
+	, viewpoint{}
+	, add_entity{ add_entity }
+	, player_attack_animation{ assets.player_attack_animation }
+	, player_idle_animation{ assets.player_idle_animation }
+	, player_running_animation{ assets.player_running_animation }
+	, enemy_model_id{ assets.enemy_model_id }
+	, enemy_attack_animation{ assets.enemy_attack_animation }
+	, enemy_idle_animation{ assets.enemy_idle_animation }
+	, enemy_running_animation{ assets.enemy_running_animation }
+	, enemy_emitter{ enemy_bullets }
+	, player_emitter{ player_bullets }
+	, enemy_pattern{ enemy_emitter.add_pattern(assets.enemy_bullet_pattern) }
+	, player_pattern{
+		player_emitter.add_pattern(assets.player_bullet_pattern) }
+	, map_center{}
+	, flow_field{}
+	, sleeping_enemies{}
+	, sleeping_count{ 0 }
+	, sleep_center{}
+	, enemy_grid{ ENEMY_GRID_CELL_SIZE }
+	, shed_ai_phase{ 0 }
+	, animation_frame_count{ 0 }
+	, seconds_since_animation_frame{ 0 }
+	, game_ticks{ 0 }
+	, random{ seed }
 {
-	auto player_model = load_model("models/player/human_male.model");
-	g_game_logic->current_scene->add_model(player_model);
-	auto player_entity = std::make_shared<Entity>(player_model->id);
-	g_game_logic->current_scene->add_entity(player_entity);
-	player_entity->update_model_matrix();
-	player_attack_animation = load_animation("models/player/human_male.human_male_cast_unarmed_magic.animation");
-	player_idle_animation = load_animation("models/player/human_male.human_male_idle.animation");
-	player_running_animation = load_animation("models/player/human_male.human_male_run.animation");
-	player_entity->animation_data.set_current_animation(player_idle_animation);
+	const EntityHandle player_entity =
+		g_entity_registry->create(assets.player_model_id);
+	if (!add_entity.isNull())
+	{
+		add_entity(player_entity);
+	}
+	g_entity_registry->animation_data(player_entity)
+		.set_current_animation(player_idle_animation);
 
 	player->scene_entity = player_entity;
 	player->max_health = 1000;
 	player->health = player->max_health;
 	player->desired_facing = glm::vec2(0.0f, 1.0f);
+}
 
-	auto enemy_model = load_model("models/enemy/enemy.model");
-	g_game_logic->current_scene->add_model(enemy_model);
-	enemy_model_id = enemy_model->id;
-
-	enemy_attack_animation = load_animation("models/enemy/enemy.human_male_cast_unarmed_magic.animation");
-	enemy_idle_animation = load_animation("models/enemy/enemy.human_male_idle.animation");
-	enemy_running_animation = load_animation("models/enemy/enemy.human_male_run.animation");
-
-	auto enemy_bullet_model = load_model("models/projectile/gem_red.model");
-	g_game_logic->current_scene->add_model(enemy_bullet_model);
-	enemy_bullet_model_id = enemy_bullet_model->id;
-
-	auto player_bullet_model = load_model("models/projectile/gem_blue.model");
-	g_game_logic->current_scene->add_model(player_bullet_model);
-	player_bullet_model_id = player_bullet_model->id;
+[[nodiscard]] size_t PawnManager::animation_interval(
+	const glm::vec3& position) const noexcept
+{
+	if (!viewpoint.watching)
+	{
+		return 1;
+	}
+	if (!viewpoint.frustum.intersects_sphere(position, ANIMATION_CULL_RADIUS))
+	{
+		return 0;
+	}
 
-	std::random_device random_device;
-	random.seed(random_device());
+	const glm::vec3 offset = position - viewpoint.position;
+	const float distance_squared = glm::dot(offset, offset);
+	if (distance_squared
+		<= ANIMATION_FULL_RATE_DISTANCE * ANIMATION_FULL_RATE_DISTANCE)
+	{
+		return 1;
+	}
+	if (distance_squared
+		<= ANIMATION_HALF_RATE_DISTANCE * ANIMATION_HALF_RATE_DISTANCE)
+	{
+		return 2;
+	}
+	return ANIMATION_FAR_INTERVAL;
 }
 
-void PawnManager::fire_enemy_bullet(Pawn& enemy)
+void PawnManager::fire_enemy_pattern(Pawn& enemy)
 {
 	enemy.seconds_since_attack = 0;
 
-	auto bullet = std::make_shared<Entity>(enemy_bullet_model_id);
-	const glm::vec3 position = enemy.scene_entity->position;
-	const glm::vec3 offset{ 
-		enemy.desired_facing.x,
-		3.0f,
-		enemy.desired_facing.y
-	};
-	bullet->position = position + offset;
-	g_game_logic->current_scene->add_entity(bullet);
-	bullet->update_model_matrix();
-
-	std::shared_ptr<Bullet> projectile = std::make_shared<Bullet>(100,
-		enemy.desired_facing, BULLET_MOVE_SPEED, bullet);
-
-	enemy_bullets.push_back(projectile);
+	const glm::vec3 position =
+		g_entity_registry->position(enemy.scene_entity);
+	enemy_emitter.fire(enemy_pattern, position, enemy.desired_facing);
 }
 
-void PawnManager::fire_player_bullet()
+void PawnManager::fire_player_pattern()
 {
 	player->seconds_since_attack = 0;
 
-	auto bullet = std::make_shared<Entity>(player_bullet_model_id);
-	const glm::vec3 position = player->scene_entity->position;
-	const glm::vec3 offset{
-		player->desired_facing.x,
-		3.0f,
-		player->desired_facing.y
-	};
-	bullet->position = position + offset;
-	g_game_logic->current_scene->add_entity(bullet);
-	bullet->update_model_matrix();
+	const glm::vec3 position =
+		g_entity_registry->position(player->scene_entity);
+	player_emitter.fire(player_pattern, position, player->desired_facing);
+}
 
-	std::shared_ptr<Bullet> projectile = std::make_shared<Bullet>(50,
-		player->desired_facing, BULLET_MOVE_SPEED, bullet);
+void PawnManager::index_enemies()
+{
+	EntityRegistry& registry = *g_entity_registry;
+	const size_t enemy_count = enemies.size();
+	enemy_x.resize(enemy_count);
+	enemy_z.resize(enemy_count);
+	for (size_t i = 0; i < enemy_count; ++i)
+	{
+		const glm::vec3& position =
+			registry.position(enemies[i]->scene_entity);
+		enemy_x[i] = position.x;
+		enemy_z[i] = position.z;
+	}
+	enemy_grid.build(enemy_x.data(), enemy_z.data(), enemy_count);
+}
 
-	player_bullets.push_back(projectile);
+double PawnManager::random_spawn_offset()
+{
+	const double unit = random() / (static_cast<double>(random.max()) + 1.0);
+	return (unit * 2.0 - 1.0) * SPAWN_RADIUS;
 }
 
-void PawnManager::reset()
+void PawnManager::reset(const uint32_t seed)
 {
+	random.seed(seed);
+	seconds_since_enemy_spawn = 0;
+	shed_ai_phase = 0;
+	animation_frame_count = 0;
+	seconds_since_animation_frame = 0;
+	game_ticks = 0;
+
+	player_emitter.clear();
+	enemy_emitter.clear();
 	player_bullets.clear();
 	enemy_bullets.clear();
 	enemies.clear();
+	sleeping_enemies.clear();
+	sleeping_count = 0;
+	map_center = ChunkCoordinates{};
+	sleep_center = ChunkCoordinates{};
+
 	player->max_health = 1000;
 	player->health = player->max_health;
 	player->desired_facing = glm::vec2(0.0f, 1.0f);
 	player->desired_movement = glm::vec2(0.0f, 0.0f);
-	player->scene_entity->position = glm::vec3(0);
+	player->wants_to_attack = false;
+	player->seconds_since_attack = 0;
+
+	const EntityHandle player_entity = player->scene_entity;
+	g_entity_registry->position(player_entity) = glm::vec3(0);
+	g_entity_registry->rotation(player_entity) = glm::quat();
+	g_entity_registry->mark_dirty(player_entity);
+	g_entity_registry->animation_data(player_entity)
+		.reset(player_idle_animation);
+}
+
+void PawnManager::set_map(const GameMap& map)
+{
+	map_center = map.center;
+	flow_field.load(map);
+}
+
+void PawnManager::recenter_map_when_due(GameMap& map)
+{
+	if (game_ticks % MAP_RECENTER_TICKS != 0)
+	{
+		return;
+	}
+	const glm::vec3& player_position =
+		g_entity_registry->position(player->scene_entity);
+	map.recenter_on(player_position.x, player_position.z);
+	set_map(map);
+}
+
+[[nodiscard]] size_t PawnManager::sleeping_enemy_count() const noexcept
+{
+	return sleeping_count;
+}
+
+void PawnManager::sleep_enemy(const std::shared_ptr<Pawn>& enemy,
+	const ChunkCoordinates& chunk)
+{
+	EntityRegistry& registry = *g_entity_registry;
+	const EntityHandle entity = enemy->scene_entity;
+	sleeping_enemies[chunk.combined].push_back(SleepingEnemy{
+		enemy, registry.position(entity), registry.rotation(entity) });
+	++sleeping_count;
+
+	registry.destroy(entity);
+	enemy->scene_entity = EntityHandle{};
+	enemy->wants_to_attack = false;
 }
 
 void PawnManager::spawn_enemy(const float& x, const float& z)
 {
-	auto enemy_entity = std::make_shared<Entity>(enemy_model_id);
-	g_game_logic->current_scene->add_entity(enemy_entity);
-	enemy_entity->position.x = x;
-	enemy_entity->position.z = z;
-	enemy_entity->update_model_matrix();
-	enemy_entity->animation_data.set_current_animation(enemy_idle_animation);
-	enemy_entity->animation_data.current_frame_index = rand() % enemy_idle_animation->frames.size();
+	EntityRegistry& registry = *g_entity_registry;
+	const EntityHandle enemy_entity = registry.create(enemy_model_id);
+	if (!add_entity.isNull())
+	{
+		add_entity(enemy_entity);
+	}
+	registry.set_position(enemy_entity, x, 0.0f, z);
+	AnimationData& animation_data = registry.animation_data(enemy_entity);
+	animation_data.set_current_animation(enemy_idle_animation);
+	animation_data.current_frame_index = static_cast<int>(
+		random() % enemy_idle_animation->frames.size());
 
 	enemies.push_back(std::make_shared<Pawn>(enemy_entity, 200));
 }
 
+void PawnManager::spawn_enemies(const size_t count)
+{
+	const glm::vec3 player_position =
+		g_entity_registry->position(player->scene_entity);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double x = player_position.x + random_spawn_offset();
+		const double z = player_position.z + random_spawn_offset();
+		spawn_enemy(static_cast<float>(x), static_cast<float>(z));
+	}
+}
+
 void PawnManager::tick()
 {
 	tick_ai();
+	index_enemies();
 	tick_attacks();
 	tick_bullets();
 	tick_movement();
+
+	seconds_since_animation_frame += SIMULATION_TIMESTEP;
+	if (seconds_since_animation_frame >= ANIMATION_FRAME_TIME)
+	{
+		seconds_since_animation_frame -= ANIMATION_FRAME_TIME;
+		tick_animations();
+	}
+	++game_ticks;
 }
 
 void PawnManager::tick_animations()
 {
-	player->scene_entity->animation_data.next_frame();
+	EntityRegistry& registry = *g_entity_registry;
+
+	// The player always animates smoothly, since that is what people watch
+	registry.animation_data(player->scene_entity).next_frame();
+
+	const size_t frame = animation_frame_count++;
+	const size_t shed_factor = shedding_load ? SHED_ANIMATION_INTERVAL : 1;
 	for (auto& pawn : enemies)
 	{
-		AnimationData& animation_data = pawn->scene_entity->animation_data;
-		if (animation_data.current_animation)
+		const EntityHandle entity = pawn->scene_entity;
+		AnimationData& animation_data = registry.animation_data(entity);
+		if (!animation_data.current_animation)
+		{
+			continue;
+		}
+
+		// Offscreen enemies stay frozen until they can be seen again
+		const size_t interval =
+			animation_interval(registry.position(entity)) * shed_factor;
+		if (interval == 0)
+		{
+			continue;
+		}
+
+		// Spread enemies on the same interval out over different frames,
+		// and skip ahead when it is their turn so they keep the same speed
+		if ((frame + entity.index) % interval != 0)
+		{
+			continue;
+		}
+		for (size_t i = 0; i < interval; ++i)
 		{
 			animation_data.next_frame();
 		}
@@ -213,35 +444,67 @@ void PawnManager::tick_animations()
 void inline PawnManager::tick_ai()
 {
 	seconds_since_enemy_spawn += SIMULATION_TIMESTEP;
-
-	for (auto iterator = enemies.begin(); iterator != enemies.end();)
-	{
-		if (iterator->get()->health <= 0)
-		{
-			iterator = enemies.erase(iterator);
-		}
-		else
+	tick_sleeping_enemies();
+
+	// Slide the survivors down over the dead in a single pass, so a wave
+	// dying at once costs the same as one enemy. Enemies that have left the
+	// hot region go in the same pass, to sleep if their chunk is cold or for
+	// good if it isn't loaded at all. Their order is kept, since it decides
+	// who a bullet hits first and so how a seed plays out.
+	EntityRegistry& registry = *g_entity_registry;
+	const ChunkCoordinates center = map_center;
+	std::erase_if(enemies, [&](const std::shared_ptr<Pawn>& enemy)
 		{
-			++iterator;
-		}
-	}
+			if (enemy->health <= 0)
+			{
+				return true;
+			}
+			const glm::vec3& position = registry.position(enemy->scene_entity);
+			const ChunkCoordinates chunk =
+				GameMap::chunk_at(position.x, position.z);
+			const int distance = GameMap::chunk_distance(chunk, center);
+			if (distance <= HOT_CACHE_RADIUS)
+			{
+				return false;
+			}
+			if (distance <= COLD_CACHE_RADIUS)
+			{
+				sleep_enemy(enemy, chunk);
+			}
+			return true;
+		});
 
+	const glm::vec3 player_position =
+		g_entity_registry->position(player->scene_entity);
 	while (enemies.size() < MAX_ENEMIES 
 		&& seconds_since_enemy_spawn >= SECONDS_PER_SPAWN)
 	{
-		const double x = 
-			player->scene_entity->position.x + spawn_offset(random);
-		const double z = 
-			player->scene_entity->position.z + spawn_offset(random);
+		const double x = player_position.x + random_spawn_offset();
+		const double z = player_position.z + random_spawn_offset();
 		spawn_enemy(static_cast<float>(x), static_cast<float>(z));
 		seconds_since_enemy_spawn -= SECONDS_PER_SPAWN;
 	}
-
-	for (auto& enemy : enemies)
-	{
-		enemy->seconds_since_attack += SIMULATION_TIMESTEP;
-		Brain::update(*enemy, *player);
-	}
+	flow_field.update(player_position.x, player_position.z);
+
+	// Each enemy only reads the player and writes to itself, so the chunks
+	// can run in any order without changing the outcome
+	const Pawn& target = *player;
+	const bool shedding = shedding_load;
+	const size_t phase = shed_ai_phase;
+	shed_ai_phase = (phase + 1) % SHED_AI_INTERVAL;
+	g_job_system->parallel_for(enemies.size(), AI_CHUNK_SIZE,
+		[&](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				Pawn& enemy = *enemies[i];
+				enemy.seconds_since_attack += SIMULATION_TIMESTEP;
+				if (!shedding || (i + phase) % SHED_AI_INTERVAL == 0)
+				{
+					Brain::update(enemy, target);
+				}
+			}
+		});
 	player->seconds_since_attack += SIMULATION_TIMESTEP;
 }
 
@@ -255,91 +518,141 @@ void inline PawnManager::tick_attacks()
 		}
 		if (enemy->seconds_since_attack >= TIME_BETWEEN_ENEMY_ATTACKS)
 		{
-			enemy->scene_entity->animation_data.
-				run_immediate_once(enemy_attack_animation);
-			fire_enemy_bullet(*enemy);
+			g_entity_registry->animation_data(enemy->scene_entity)
+				.run_immediate_once(enemy_attack_animation);
+			fire_enemy_pattern(*enemy);
 		}
 	}
 	if (player->wants_to_attack)
 	{
 		if (player->seconds_since_attack >= TIME_BETWEEN_PLAYER_ATTACKS)
 		{
-			player->scene_entity->animation_data.
-				run_immediate_once(player_attack_animation);
-			player->scene_entity->animation_data.current_frame_index = 0;
-			fire_player_bullet();
+			AnimationData& animation_data =
+				g_entity_registry->animation_data(player->scene_entity);
+			animation_data.run_immediate_once(player_attack_animation);
+			animation_data.current_frame_index = 0;
+			fire_player_pattern();
 		}
 	}
 }
 
-[[nodiscard]] bool collides(const glm::vec3& bullet_position, 
-	const glm::vec3& pawn_position) noexcept
+void inline PawnManager::tick_sleeping_enemies()
 {
-	const glm::vec2 bullet_position_2d{ bullet_position.x, bullet_position.z };
-	const glm::vec2 pawn_position_2d{ pawn_position.x, pawn_position.z };
-
-	const float distance2 = 
-		glm::distance2(bullet_position_2d, pawn_position_2d);
-
-	return distance2 <= COLLISION_RADIUS_SQUARED;
-}
+	if (sleep_center == map_center)
+	{
+		return;
+	}
+	const ChunkCoordinates center = map_center;
+	sleep_center = center;
 
-void inline PawnManager::tick_bullets()
-{
-	for (std::shared_ptr<Bullet> bullet : enemy_bullets)
-	{
-		bullet->scene_entity->position +=
-			glm::vec3(bullet->direction.x, 0, bullet->direction.y) 
-			* BULLET_MOVE_SPEED;
-		bullet->scene_entity->update_model_matrix();
-		
-		if (collides(bullet->scene_entity->position,
-			player->scene_entity->position)
-			&& !bullet->scene_entity->dead)
+	std::erase_if(sleeping_enemies, [&](const auto& bucket)
 		{
-			player->health -= bullet->damage;
-			if (player->health <= 0)
+			const ChunkCoordinates chunk{ bucket.first };
+			if (GameMap::chunk_distance(chunk, center) <= COLD_CACHE_RADIUS)
 			{
-				player->health = 0;
-				g_game_logic->end_game();
+				return false;
 			}
-			bullet->scene_entity->dead = true;
-		}
-		else
+			sleeping_count -= bucket.second.size();
+			return true;
+		});
+
+	// Wake chunks in a fixed order rather than the order of the map, so
+	// that a seed still plays out the same way everywhere
+	for (int x = -HOT_CACHE_RADIUS; x <= HOT_CACHE_RADIUS; ++x)
+	{
+		for (int z = -HOT_CACHE_RADIUS; z <= HOT_CACHE_RADIUS; ++z)
 		{
-			bullet->lifetime -= SIMULATION_TIMESTEP;
+			const ChunkCoordinates chunk{ center.x + x, center.z + z };
+			const auto bucket = sleeping_enemies.find(chunk.combined);
+			if (bucket == sleeping_enemies.end())
+			{
+				continue;
+			}
+			for (SleepingEnemy& sleeper : bucket->second)
+			{
+				wake_enemy(sleeper);
+			}
+			sleeping_count -= bucket->second.size();
+			sleeping_enemies.erase(bucket);
 		}
 	}
+}
 
-	while (!enemy_bullets.empty() && enemy_bullets.front()->lifetime <= 0)
-	{
-		enemy_bullets.pop_front();
-	}
+[[nodiscard]] size_t PawnManager::find_bullet_target(const float x,
+	const float z) const noexcept
+{
+	return CollisionKernel::find_first_within(enemy_x.data(), enemy_z.data(),
+		enemy_x.size(), x, z, COLLISION_RADIUS_SQUARED);
+}
 
-	for (std::shared_ptr<Bullet> bullet : player_bullets)
+[[nodiscard]] size_t PawnManager::find_bullet_target_in_grid(const float x,
+	const float z) const noexcept
+{
+	return enemy_grid.find_first_within(x, z, COLLISION_RADIUS_SQUARED);
+}
+
+void inline PawnManager::tick_bullets()
+{
+	const float delta_time = static_cast<float>(SIMULATION_TIMESTEP);
+	const glm::vec3 player_position =
+		g_entity_registry->position(player->scene_entity);
+
+	// Patterns with more than one volley keep firing, with enemies aiming at
+	// the player and the player aiming wherever they are facing
+	const glm::vec2 player_target{ player_position.x, player_position.z };
+	enemy_emitter.update(delta_time, player_target);
+	player_emitter.update(delta_time,
+		player_target + player->desired_facing);
+
+	enemy_bullets.advance(delta_time);
+	enemy_bullet_hits.resize(CollisionKernel::mask_count(enemy_bullets.size()));
+	CollisionKernel::find_within(enemy_bullets.position_x.data(),
+		enemy_bullets.position_z.data(), enemy_bullets.size(),
+		player_position.x, player_position.z, COLLISION_RADIUS_SQUARED,
+		enemy_bullet_hits.data());
+
+	player->health -= enemy_bullets.release_hits(enemy_bullet_hits.data());
+	if (player->health <= 0)
 	{
-		bullet->scene_entity->position +=
-			glm::vec3(bullet->direction.x, 0, bullet->direction.y)
-			* BULLET_MOVE_SPEED;
-		bullet->scene_entity->update_model_matrix();
+		player->health = 0;
+	}
+	enemy_bullets.release_expired();
+	enemy_bullets.update_scene_entities();
 
-		for (auto& enemy : enemies)
-		{
-			if (collides(bullet->scene_entity->position,
-				enemy->scene_entity->position)
-				&& !bullet->scene_entity->dead)
-			{
-				enemy->health -= bullet->damage;
-				bullet->scene_entity->dead = true;
-			}
-		}
+	player_bullets.advance(delta_time);
+	tick_player_bullet_collisions();
+	player_bullets.release_expired();
+	player_bullets.update_scene_entities();
+}
 
-		bullet->lifetime -= SIMULATION_TIMESTEP;
+void inline PawnManager::tick_player_bullet_collisions()
+{
+	if (player_bullets.empty() || enemies.empty())
+	{
+		return;
 	}
 
-	while (!player_bullets.empty() && player_bullets.front()->lifetime <= 0)
+	const size_t enemy_count = enemies.size();
+	const bool use_grid = enemy_count >= ENEMY_GRID_MINIMUM_ENEMIES;
+
+	for (size_t i = 0; i < player_bullets.size();)
 	{
-		player_bullets.pop_front();
+		const float bullet_x = player_bullets.position_x[i];
+		const float bullet_z = player_bullets.position_z[i];
+		const size_t target = use_grid
+			? find_bullet_target_in_grid(bullet_x, bullet_z)
+			: find_bullet_target(bullet_x, bullet_z);
+
+		if (target < enemy_count)
+		{
+			enemies[target]->health -= player_bullets.damage[i];
+			// The last bullet is moved into this slot, so check it again
+			player_bullets.release(i);
+		}
+		else
+		{
+			++i;
+		}
 	}
 }
 
@@ -368,44 +681,41 @@ void inline PawnManager::tick_movement()
 	};
 	movement *= PLAYER_MOVE_SPEED;
 
+	EntityRegistry& registry = *g_entity_registry;
 	if (movement.x != 0 || movement.z != 0)
 	{
-		player->scene_entity->position += movement;
-		player->needs_updating = true;
-		g_game_logic->current_scene->camera.add_position(movement);
+		registry.position(player->scene_entity) += movement;
+		registry.mark_dirty(player->scene_entity);
 	}
 
 	if (player->desired_movement.x != 0 || player->desired_movement.y != 0)
 	{
-		auto& animation_data = player->scene_entity->animation_data;
+		auto& animation_data = registry.animation_data(player->scene_entity);
 		animation_data.set_current_animation(player_running_animation);
 	}
 	else
 	{
-		auto& animation_data = player->scene_entity->animation_data;
+		auto& animation_data = registry.animation_data(player->scene_entity);
 		animation_data.set_current_animation(player_idle_animation);
 	}
-	for (auto& pawn : enemies)
-	{
-		update_movement(*pawn, ENEMY_MOVE_SPEED);
-
-		auto& animation_data = pawn->scene_entity->animation_data;
-	}
 
-	if (player->needs_updating)
-	{
-		player->scene_entity->update_model_matrix();
-		player->needs_updating = false;
-	}
-	
-	for (auto& pawn : enemies)
-	{
-		if (pawn->needs_updating)
+	// Every push comes from where enemies were when they were indexed, so
+	// they can be moved in any order
+	const size_t enemy_count = enemies.size();
+	separation_x.resize(enemy_count);
+	separation_z.resize(enemy_count);
+	g_job_system->parallel_for(enemy_count, MOVEMENT_CHUNK_SIZE,
+		[&](const size_t begin, const size_t end)
 		{
-			pawn->scene_entity->update_model_matrix();
-			pawn->needs_updating = false;
-		}
-	}
+			Separation::find_pushes(enemy_grid, enemy_x.data(),
+				enemy_z.data(), begin, end, PAWN_SEPARATION_DISTANCE,
+				MAX_SEPARATION_PUSH, separation_x.data(),
+				separation_z.data());
+			for (size_t i = begin; i < end; ++i)
+			{
+				update_enemy_movement(*enemies[i], i);
+			}
+		});
 }
 
 [[nodiscard]]
@@ -420,27 +730,15 @@ glm::vec2 PawnManager::find_enemy_nearest_player()
 		return glm::vec2{ 1.0f, 0.0f };
 	}
 
-	float nearest_distance = FLT_MAX;
-	std::shared_ptr<Pawn> nearest_so_far;
-
-	const glm::vec3 player_position = player->scene_entity->position;
-
-	for (auto& enemy : enemies)
-	{
-		const float current_distance = 
-			glm::distance2(player_position, enemy->scene_entity->position);
-		if (current_distance < nearest_distance)
-		{
-			nearest_distance = current_distance;
-			nearest_so_far = enemy;
-		}
-	}
+	// Enemies have not moved since they were indexed this tick
+	const glm::vec3 player_position =
+		g_entity_registry->position(player->scene_entity);
+	const size_t nearest =
+		enemy_grid.find_nearest(player_position.x, player_position.z);
 
-	const glm::vec3 enemy_direction_3d =
-		nearest_so_far->scene_entity->position 
-		- player->scene_entity->position;
 	const glm::vec2 enemy_direction{
-		enemy_direction_3d.x, enemy_direction_3d.z
+		enemy_x[nearest] - player_position.x,
+		enemy_z[nearest] - player_position.z
 	};
 
 	return glm::normalize(enemy_direction);
@@ -452,9 +750,9 @@ void PawnManager::update_direction(Pawn& pawn)
 		glm::radians(-MathUtil::vector_to_angle(pawn.desired_facing)), 
 		glm::vec3(0.0f, 1.0f, 0.0f)
 	);
+	glm::quat& rotation = g_entity_registry->rotation(pawn.scene_entity);
 #if SMOOTH_ROTATION
-	const glm::quat& current_rotation = pawn.scene_entity->rotation;
-	const float dot = glm::dot(current_rotation, target_rotation);
+	const float dot = glm::dot(rotation, target_rotation);
 	const float angle = 1 - dot * dot;
 
 	if (MathUtil::close_enough(angle, 0.0f))
@@ -466,32 +764,71 @@ void PawnManager::update_direction(Pawn& pawn)
 	if (angle > max_rotation)
 	{
 		const float percentage = max_rotation / angle;
-		const glm::quat& result =
-			glm::slerp(current_rotation, target_rotation, percentage);
-		pawn.scene_entity->set_rotation(result);
+		rotation = glm::slerp(rotation, target_rotation, percentage);
 	}
 	else
 	{
-		pawn.scene_entity->set_rotation(target_rotation);
+		rotation = target_rotation;
 	}
 #else
-	pawn.scene_entity->set_rotation(target_rotation);
+	rotation = target_rotation;
 #endif
-	pawn.needs_updating = true;
+	g_entity_registry->mark_dirty(pawn.scene_entity);
 }
 
-void PawnManager::update_movement(Pawn& pawn, const float move_speed)
+void PawnManager::update_enemy_movement(Pawn& enemy, const size_t index)
 {
 	glm::vec3 movement{
-		pawn.desired_movement.x,
+		enemy.desired_movement.x,
 		0.0f,
-		pawn.desired_movement.y
+		enemy.desired_movement.y
 	};
-	movement *= move_speed;
-	//TODO(ches) BH-49 - Check for collision
-	if (movement.x != 0 || movement.z != 0)
+	movement *= ENEMY_MOVE_SPEED;
+	movement.x += separation_x[index];
+	movement.z += separation_z[index];
+
+	if (movement.x == 0 && movement.z == 0)
+	{
+		return;
+	}
+
+	EntityRegistry& registry = *g_entity_registry;
+	glm::vec3& position = registry.position(enemy.scene_entity);
+	position += movement;
+
+	// Enemies are kept out of the player, rather than the player being
+	// blocked by enemies
+	const glm::vec3& player_position =
+		registry.position(player->scene_entity);
+	const float offset_x = position.x - player_position.x;
+	const float offset_z = position.z - player_position.z;
+	const float distance_squared = offset_x * offset_x + offset_z * offset_z;
+	if (distance_squared > 0 && distance_squared
+		< PAWN_SEPARATION_DISTANCE * PAWN_SEPARATION_DISTANCE)
+	{
+		const float scale =
+			PAWN_SEPARATION_DISTANCE / std::sqrt(distance_squared);
+		position.x = player_position.x + offset_x * scale;
+		position.z = player_position.z + offset_z * scale;
+	}
+
+	registry.mark_dirty(enemy.scene_entity);
+}
+
+void PawnManager::wake_enemy(SleepingEnemy& sleeper)
+{
+	EntityRegistry& registry = *g_entity_registry;
+	const EntityHandle entity = registry.create(enemy_model_id);
+	if (!add_entity.isNull())
 	{
-		pawn.scene_entity->position += movement;
-		pawn.needs_updating = true;
+		add_entity(entity);
 	}
+	registry.position(entity) = sleeper.position;
+	registry.rotation(entity) = sleeper.rotation;
+	registry.mark_dirty(entity);
+	registry.animation_data(entity)
+		.set_current_animation(enemy_idle_animation);
+
+	sleeper.pawn->scene_entity = entity;
+	enemies.push_back(std::move(sleeper.pawn));
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "entities/separation.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "entities/spatial_grid.h"
+
+namespace Separation
+{
+	void find_pushes(const SpatialGrid& grid, const float* x, const float* z,
+		const size_t begin, const size_t end, const float distance,
+		const float max_push, float* push_x, float* push_z) noexcept
+	{
+		const float distance_squared = distance * distance;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			float total_x = 0;
+			float total_z = 0;
+
+			grid.for_each_nearby(x[i], z[i],
+				[&](const uint32_t other, const float other_x,
+					const float other_z)
+				{
+					if (other == i)
+					{
+						return;
+					}
+
+					const float dx = x[i] - other_x;
+					const float dz = z[i] - other_z;
+					const float length_squared = dx * dx + dz * dz;
+					if (length_squared >= distance_squared)
+					{
+						return;
+					}
+
+					if (length_squared == 0)
+					{
+						// Stacked exactly on top of each other, so there is
+						// no direction to push in. Split them along x.
+						total_x += (i < other ? -0.5f : 0.5f) * distance;
+						return;
+					}
+
+					const float length = std::sqrt(length_squared);
+					const float push = (distance - length) * 0.5f / length;
+					total_x += dx * push;
+					total_z += dz * push;
+				});
+
+			const float total_squared = total_x * total_x + total_z * total_z;
+			if (total_squared > max_push * max_push)
+			{
+				const float scale = max_push / std::sqrt(total_squared);
+				total_x *= scale;
+				total_z *= scale;
+			}
+
+			push_x[i] = total_x;
+			push_z[i] = total_z;
+		}
+	}
+}
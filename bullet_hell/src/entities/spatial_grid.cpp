@@ -0,0 +1,214 @@
+#include "entities/spatial_grid.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include "entities/collision_kernel.h"
+
+SpatialGrid::SpatialGrid(const float cell_size)
+	: cell_size{ cell_size }
+	, inverse_cell_size{ 1.0f / cell_size }
+{}
+
+void SpatialGrid::build(const float* x, const float* z, const size_t count)
+{
+	// Aim for about two buckets per point to keep collisions rare
+	const uint32_t bucket_count =
+		std::bit_ceil(static_cast<uint32_t>(count * 2 + 1));
+	bucket_mask = bucket_count - 1;
+
+	bucket_start.assign(bucket_count + 1, 0);
+	point_bucket.resize(count);
+	sorted_index.resize(count);
+	sorted_x.resize(count);
+	sorted_z.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t bucket =
+			bucket_of(cell_coordinate(x[i]), cell_coordinate(z[i]));
+		point_bucket[i] = bucket;
+		++bucket_start[bucket + 1];
+	}
+
+	for (uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+	{
+		bucket_start[bucket + 1] += bucket_start[bucket];
+	}
+
+	// Counting up from the start of each bucket leaves each entry pointing
+	// at the start of the next bucket, so shift them back afterwards
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t slot = bucket_start[point_bucket[i]]++;
+		sorted_index[slot] = static_cast<uint32_t>(i);
+		sorted_x[slot] = x[i];
+		sorted_z[slot] = z[i];
+	}
+
+	for (uint32_t bucket = bucket_count; bucket > 0; --bucket)
+	{
+		bucket_start[bucket] = bucket_start[bucket - 1];
+	}
+	bucket_start[0] = 0;
+}
+
+void SpatialGrid::clear() noexcept
+{
+	bucket_mask = 0;
+	bucket_start.clear();
+	point_bucket.clear();
+	sorted_index.clear();
+	sorted_x.clear();
+	sorted_z.clear();
+}
+
+/// <summary>
+/// Check if a neighbour is nearer than another, breaking ties by index.
+/// </summary>
+/// <param name="first">The first neighbour.</param>
+/// <param name="second">The second neighbour.</param>
+/// <returns>Whether the first neighbour is nearer.</returns>
+static bool nearer(const SpatialGrid::Neighbour& first,
+	const SpatialGrid::Neighbour& second) noexcept
+{
+	if (first.distance_squared != second.distance_squared)
+	{
+		return first.distance_squared < second.distance_squared;
+	}
+	return first.index < second.index;
+}
+
+[[nodiscard]] size_t SpatialGrid::find_nearest(const float x, const float z)
+	const noexcept
+{
+	if (sorted_index.empty())
+	{
+		return size();
+	}
+
+	Neighbour best{ 0, std::numeric_limits<float>::infinity() };
+	const auto consider = [&](const uint32_t slot)
+		{
+			const float dx = sorted_x[slot] - x;
+			const float dz = sorted_z[slot] - z;
+			const Neighbour candidate{ sorted_index[slot], dx * dx + dz * dz };
+			if (nearer(candidate, best))
+			{
+				best = candidate;
+			}
+		};
+
+	const int32_t cell_x = cell_coordinate(x);
+	const int32_t cell_z = cell_coordinate(z);
+	for (int32_t ring = 0; ; ++ring)
+	{
+		const uint64_t side = 2 * static_cast<uint64_t>(ring) + 1;
+		if (side * side > sorted_index.size())
+		{
+			// Checking a point twice does not change the answer
+			for (uint32_t slot = 0; slot < sorted_index.size(); ++slot)
+			{
+				consider(slot);
+			}
+			break;
+		}
+
+		for_each_in_ring(cell_x, cell_z, ring, consider);
+		if (best.distance_squared < unsearched_distance_squared(ring))
+		{
+			break;
+		}
+	}
+	return best.index;
+}
+
+void SpatialGrid::find_k_nearest(const float x, const float z,
+	const size_t count, std::vector<Neighbour>& result) const
+{
+	result.clear();
+	if (count == 0 || sorted_index.empty())
+	{
+		return;
+	}
+
+	// The result is kept as a heap with the furthest neighbour on top, so
+	// it can be swapped out when something nearer turns up
+	const auto consider = [&](const uint32_t slot)
+		{
+			const float dx = sorted_x[slot] - x;
+			const float dz = sorted_z[slot] - z;
+			const Neighbour candidate{ sorted_index[slot], dx * dx + dz * dz };
+			if (result.size() < count)
+			{
+				result.push_back(candidate);
+				std::push_heap(result.begin(), result.end(), nearer);
+			}
+			else if (nearer(candidate, result.front()))
+			{
+				std::pop_heap(result.begin(), result.end(), nearer);
+				result.back() = candidate;
+				std::push_heap(result.begin(), result.end(), nearer);
+			}
+		};
+
+	const int32_t cell_x = cell_coordinate(x);
+	const int32_t cell_z = cell_coordinate(z);
+	for (int32_t ring = 0; ; ++ring)
+	{
+		const uint64_t side = 2 * static_cast<uint64_t>(ring) + 1;
+		if (side * side > sorted_index.size())
+		{
+			// Start over, since points that were already found would be
+			// added a second time
+			result.clear();
+			for (uint32_t slot = 0; slot < sorted_index.size(); ++slot)
+			{
+				consider(slot);
+			}
+			break;
+		}
+
+		for_each_in_ring(cell_x, cell_z, ring, consider);
+		if (result.size() == count && result.front().distance_squared
+			< unsearched_distance_squared(ring))
+		{
+			break;
+		}
+	}
+
+	std::sort_heap(result.begin(), result.end(), nearer);
+}
+
+[[nodiscard]] size_t SpatialGrid::find_first_within(const float x,
+	const float z, const float radius_squared) const noexcept
+{
+	// The grid is not in index order, so keep the lowest index that was hit
+	size_t result = size();
+	for_each_nearby(x, z,
+		[&](const uint32_t index, const float point_x, const float point_z)
+		{
+			if (index < result && CollisionKernel::within(point_x, point_z,
+				x, z, radius_squared))
+			{
+				result = index;
+			}
+		});
+	return result;
+}
+
+[[nodiscard]] size_t SpatialGrid::size() const noexcept
+{
+	return sorted_index.size();
+}
+
+[[nodiscard]] float SpatialGrid::unsearched_distance_squared(
+	const int32_t ring) const noexcept
+{
+	// Anything further out is at least a whole cell per ring away, minus a
+	// little in case a point right on the edge of a cell rounded into the
+	// neighbouring one
+	const float distance = ring * cell_size * 0.999f;
+	return distance * distance;
+}
@@ -4,8 +4,17 @@
 
 #include "graphics/backend/opengl/command_buffers.h"
 
+#include <climits>
+
+#include "debugging/logger.h"
+
 #include "glad.h"
 
+/// <summary>
+/// How many ints make up each indirect draw command.
+/// </summary>
+constexpr size_t COMMAND_SIZE = 5;
+
 void CommandBuffers::cleanup()
 {
 	if (animated_command_buffer != 0)
@@ -18,11 +27,7 @@ void CommandBuffers::cleanup()
 		glDeleteBuffers(1, &animated_draw_element_buffer);
 		animated_draw_element_buffer = 0;
 	}
-	if (animated_model_matrices_buffer != 0)
-	{
-		glDeleteBuffers(1, &animated_model_matrices_buffer);
-		animated_model_matrices_buffer = 0;
-	}
+	animated_model_matrices.cleanup();
 	animated_draw_count = 0;
 
 	if (static_command_buffer != 0)
@@ -35,11 +40,7 @@ void CommandBuffers::cleanup()
 		glDeleteBuffers(1, &static_draw_element_buffer);
 		static_draw_element_buffer = 0;
 	}
-	if (static_model_matrices_buffer != 0)
-	{
-		glDeleteBuffers(1, &static_model_matrices_buffer);
-		static_model_matrices_buffer = 0;
-	}
+	static_model_matrices.cleanup();
 	static_draw_count = 0;
 }
 
@@ -47,18 +48,16 @@ CommandBuffers::CommandBuffers()
 	: animated_command_buffer{ 0 }
 	, animated_draw_count{ 0 }
 	, animated_draw_element_buffer{ 0 }
-	, animated_model_matrices_buffer{ 0 }
+	, animated_model_matrices{}
 	, static_command_buffer{ 0 }
 	, static_draw_count{ 0 }
 	, static_draw_element_buffer{ 0 }
-	, static_model_matrices_buffer{ 0 }
+	, static_model_matrices{}
 {
 	glGenBuffers(1, &animated_command_buffer);
-	glGenBuffers(1, &animated_model_matrices_buffer);
 	glGenBuffers(1, &animated_draw_element_buffer);
 
 	glGenBuffers(1, &static_command_buffer);
-	glGenBuffers(1, &static_model_matrices_buffer);
 	glGenBuffers(1, &static_draw_element_buffer);
 }
 	
@@ -67,4 +66,47 @@ CommandBuffers::~CommandBuffers()
 	cleanup();
 }
 
+CascadeCommandBuffers::CascadeCommandBuffers()
+	: animated_command_buffers{}
+	, animated_draw_element_buffers{}
+	, static_command_buffers{}
+	, static_draw_element_buffers{}
+{
+	glGenBuffers(SHADOW_MAP_CASCADE_COUNT, animated_command_buffers.data());
+	glGenBuffers(SHADOW_MAP_CASCADE_COUNT,
+		animated_draw_element_buffers.data());
+	glGenBuffers(SHADOW_MAP_CASCADE_COUNT, static_command_buffers.data());
+	glGenBuffers(SHADOW_MAP_CASCADE_COUNT,
+		static_draw_element_buffers.data());
+}
+
+CascadeCommandBuffers::~CascadeCommandBuffers()
+{
+	glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT,
+		animated_command_buffers.data());
+	glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT,
+		animated_draw_element_buffers.data());
+	glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT, static_command_buffers.data());
+	glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT,
+		static_draw_element_buffers.data());
+}
+
+unsigned int upload_draw_commands(const GLuint command_buffer,
+	const GLuint draw_element_buffer, const std::vector<int>& commands,
+	const std::vector<int>& draw_elements)
+{
+	LOG_ASSERT(commands.size() / COMMAND_SIZE <= UINT_MAX
+		&& "We have more draws than fit in an unsigned int");
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(int),
+		commands.data(), GL_STREAM_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, draw_element_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, draw_elements.size() * sizeof(int),
+		draw_elements.data(), GL_STREAM_DRAW);
+
+	return static_cast<unsigned int>(commands.size() / COMMAND_SIZE);
+}
+
 #endif
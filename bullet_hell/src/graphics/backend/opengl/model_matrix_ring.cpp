@@ -0,0 +1,193 @@
+#include "graphics/frontend/backend_type.h"
+
+#if BACKEND_CURRENT == BACKEND_OPENGL || BACKEND_CURRENT == BACKEND_OPENGL_DEPRECATED
+
+#include "graphics/backend/opengl/model_matrix_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "debugging/logger.h"
+#include "graphics/scene/entity_view.h"
+
+#include "glad.h"
+
+/// <summary>
+/// How long to wait on a fence before checking it again, in nanoseconds.
+/// </summary>
+constexpr GLuint64 FENCE_TIMEOUT = 1000000000;
+
+ModelMatrixRing::ModelMatrixRing()
+	: buffer{ 0 }
+	, mapped{ nullptr }
+	, capacity{ 0 }
+	, region_size{ 0 }
+	, region{ 0 }
+	, frame{ 0 }
+	, fences{}
+	, region_frames{}
+	, latest{}
+	, changed_frames{}
+{}
+
+ModelMatrixRing::~ModelMatrixRing()
+{
+	cleanup();
+}
+
+void ModelMatrixRing::update(
+	const std::vector<std::shared_ptr<Model>>& models)
+{
+	++frame;
+
+	size_t count = 0;
+	for (const auto& model : models)
+	{
+		count += model->entity_list.size();
+	}
+
+	if (count > capacity)
+	{
+		reserve(count);
+	}
+	else if (region_frames[region] != 0)
+	{
+		// Everything that reads the last region has been submitted by now
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	region = (region + 1) % FRAME_COUNT;
+	wait_for(region);
+
+	// Anything new counts as changed, whatever was there before
+	latest.resize(count);
+	changed_frames.resize(count, frame);
+
+	size_t index = 0;
+	for (const auto& model : models)
+	{
+		for (const auto& entity : model->entity_list)
+		{
+			const glm::mat4& matrix = g_entity_view->model_matrix(entity);
+			// Compared bitwise, which is quicker, and at worst writes a
+			// matrix that hadn't really changed
+			if (std::memcmp(&matrix, &latest[index], sizeof(glm::mat4)) != 0)
+			{
+				latest[index] = matrix;
+				changed_frames[index] = frame;
+			}
+			++index;
+		}
+	}
+
+	// Copy over each run of matrices that changed since we were last here
+	std::byte* destination = mapped + region * region_size;
+	const uint64_t written_frame = region_frames[region];
+	size_t first = 0;
+	while (first < count)
+	{
+		if (changed_frames[first] <= written_frame)
+		{
+			++first;
+			continue;
+		}
+		size_t last = first + 1;
+		while (last < count && changed_frames[last] > written_frame)
+		{
+			++last;
+		}
+		std::memcpy(destination + first * sizeof(glm::mat4),
+			latest.data() + first, (last - first) * sizeof(glm::mat4));
+		first = last;
+	}
+	region_frames[region] = frame;
+}
+
+void ModelMatrixRing::bind(const GLuint binding) const
+{
+	if (latest.empty())
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+		return;
+	}
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer,
+		region * region_size, latest.size() * sizeof(glm::mat4));
+}
+
+void ModelMatrixRing::cleanup()
+{
+	for (GLsync& fence : fences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	if (buffer != 0)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+	mapped = nullptr;
+	capacity = 0;
+	region_size = 0;
+	region = 0;
+	region_frames.fill(0);
+	latest.clear();
+	changed_frames.clear();
+}
+
+void ModelMatrixRing::reserve(const size_t count)
+{
+	// Grow ahead of what we need, so that spawning a few entities at a time
+	// doesn't replace the buffer every frame
+	const size_t new_capacity = std::max(count, capacity * 2);
+
+	// Deleting a buffer the GPU is still reading is safe, as the driver
+	// holds on to it until it is done
+	cleanup();
+	capacity = new_capacity;
+
+	GLint alignment = 1;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	const size_t align = static_cast<size_t>(std::max(alignment, 1));
+	region_size = (capacity * sizeof(glm::mat4) + align - 1) / align * align;
+	const size_t buffer_size = region_size * FRAME_COUNT;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT
+		| GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, buffer_size, nullptr, flags);
+	mapped = static_cast<std::byte*>(glMapBufferRange(
+		GL_SHADER_STORAGE_BUFFER, 0, buffer_size, flags));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	LOG_ASSERT(mapped != nullptr && "Failed to map the model matrix buffer");
+}
+
+void ModelMatrixRing::wait_for(const size_t index)
+{
+	GLsync& fence = fences[index];
+	if (fence == nullptr)
+	{
+		return;
+	}
+
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+		FENCE_TIMEOUT);
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		result = glClientWaitSync(fence, 0, FENCE_TIMEOUT);
+	}
+	if (result == GL_WAIT_FAILED)
+	{
+		LOG_ERROR("Failed to wait for the GPU to finish with model matrices");
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+#endif
@@ -16,6 +16,7 @@ Texture* PipelineManager::default_texture = nullptr;
 
 #include "debugging/logger.h"
 #include "graphics/backend/opengl/stages/animation_render.h"
+#include "graphics/backend/opengl/stages/cull_render.h"
 #include "graphics/backend/opengl/stages/debug_render.h"
 #include "graphics/backend/opengl/stages/filter_render.h"
 #include "graphics/backend/opengl/stages/framebuffer_transition.h"
@@ -43,6 +44,7 @@ struct PipelineManager::Data
 	StageResource<Buffer> point_lights;
 	StageResource<Buffer> spot_lights;
 	StageResource<CascadeShadows> cascade_shadows;
+	StageResource<CascadeCommandBuffers> cascade_command_buffers;
 	StageResource<CommandBuffers> command_buffers;
 	StageResource<Framebuffer> back_buffer;
 	StageResource<Framebuffer> gbuffer;
@@ -58,6 +60,7 @@ struct PipelineManager::Data
 	int cached_width;
 
 	AnimationRender animation_render;
+	CullRender cull_render;
 	FramebufferTransition back_buffer_binding;
 	FramebufferTransition screen_texture_binding;
 	FilterRender filter_render;
@@ -77,6 +80,7 @@ PipelineManager::Data::Data(Window& window)
 	: point_lights{ ALLOC Buffer(Buffer::Type::SHADER_STORAGE) }
 	, spot_lights{ ALLOC Buffer(Buffer::Type::SHADER_STORAGE) }
 	, cascade_shadows{}
+	, cascade_command_buffers{ ALLOC CascadeCommandBuffers() }
 	, command_buffers{ ALLOC CommandBuffers() }
 	, gbuffer{ nullptr }
 	, back_buffer{ nullptr }
@@ -90,6 +94,8 @@ PipelineManager::Data::Data(Window& window)
 	, cached_width{0}
 	, cached_height{0}
 	, animation_render{ &render_buffers }
+	, cull_render{ &command_buffers, &cascade_command_buffers,
+		&cascade_shadows, &animation_render }
 	, back_buffer_binding{ &back_buffer, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA }
 	, screen_texture_binding{ &screen_texture, GL_ONE, GL_ONE }
 	, filter_render{ &screen_texture, &quad_mesh }
@@ -103,7 +109,7 @@ PipelineManager::Data::Data(Window& window)
 	, scene_render_wireframe{ &render_buffers, &gbuffer, &command_buffers,
 		&default_texture }
 	, shadow_render{ &render_buffers, &cascade_shadows, &shadow_buffer,
-		&command_buffers }
+		&command_buffers, &cascade_command_buffers }
 	, skybox_render{ &skybox }
 {
 	//TODO(ches) generate buffers, font
@@ -223,6 +229,14 @@ Pipeline* PipelineManager::build_pipeline(RenderConfig config)
 		rendering_scene = true;
 	}
 
+	// Every pass that draws entities draws what this leaves in the command
+	// buffers, so it runs once before any of them
+	if (config & (RenderConfigValues::SHADOW_PASS_MASK
+		| RenderConfigValues::SCENE_PASS_MASK))
+	{
+		result->render_stages.push_back(&(data->cull_render));
+	}
+
 	if (config & RenderConfigValues::SHADOW_PASS_MASK)
 	{
 		result->render_stages.push_back(&(data->shadow_render));
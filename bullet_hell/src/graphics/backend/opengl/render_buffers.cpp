@@ -20,6 +20,27 @@
 
 #include "glad.h"
 
+/// <summary>
+/// Work out how many different poses of an animated model could be on
+/// screen at once, which is one for every frame of its animations, plus one
+/// for entities that are not animating. This doesn't depend on how many
+/// entities there are, since the buffers are not reloaded as more of them
+/// spawn.
+/// </summary>
+/// <param name="model">The model to check.</param>
+/// <returns>How many pose slots the model needs.</returns>
+static size_t pose_slot_count(const Model& model)
+{
+	const std::set<std::shared_ptr<Animation>> animations(
+		model.animation_list.begin(), model.animation_list.end());
+	size_t frame_count = 1;
+	for (const auto& animation : animations)
+	{
+		frame_count += animation->frames.size();
+	}
+	return frame_count;
+}
+
 RenderBuffers::RenderBuffers()
 	: vbo_list{}
 	, buffers_populated{ false }
@@ -57,6 +78,7 @@ void RenderBuffers::cleanup()
 		return;
 	}
 	buffers_populated = false;
+	++animated_buffers_generation;
 
 	glDeleteBuffers(static_cast<int>(vbo_list.size()), vbo_list.data());
 	vbo_list.clear();
@@ -97,19 +119,19 @@ void RenderBuffers::define_vertex_attributes()
 void RenderBuffers::load_animated_entity_buffers(const Scene& scene)
 {
 	buffers_populated = true;
+	++animated_buffers_generation;
 
 	const ModelList& model_list = scene.get_animated_model_list();
 	glBindVertexArray(animated_vao);
 
 	size_t vertices_size = 0;
 	size_t offset = 0;
-	size_t mesh_binding_pose_offset = 0;
+	size_t model_binding_pose_offset = 0;
 	size_t binding_pose_offset = 0;
-	size_t mesh_weights_offset = 0;
+	size_t model_weights_offset = 0;
 	size_t weights_offset = 0;
 	for (auto& model : model_list)
 	{
-		EntityList& entities = model->entity_list;
 		std::vector<MeshDrawData>& mesh_draw_data_list
 			= model->mesh_draw_data_list;
 
@@ -118,10 +140,11 @@ void RenderBuffers::load_animated_entity_buffers(const Scene& scene)
 		{
 			continue;
 		}
-		for (auto& entity : entities)
+		const size_t slot_count = pose_slot_count(*model);
+		for (size_t slot = 0; slot < slot_count; ++slot)
 		{
-			binding_pose_offset = mesh_binding_pose_offset;
-			weights_offset = mesh_weights_offset;
+			binding_pose_offset = model_binding_pose_offset;
+			weights_offset = model_weights_offset;
 			for (auto& mesh_data : model->mesh_data_list)
 			{
 				vertices_size += mesh_data.vertices.size();
@@ -131,7 +154,6 @@ void RenderBuffers::load_animated_entity_buffers(const Scene& scene)
 				mesh_draw_data_list.emplace_back(mesh_size_in_bytes,
 					mesh_data.material->material_id, offset,
 					mesh_data.indices.size(), AnimMeshDrawData(
-						entity,
 						static_cast<int>(binding_pose_offset),
 						static_cast<int>(weights_offset)
 					)
@@ -143,8 +165,8 @@ void RenderBuffers::load_animated_entity_buffers(const Scene& scene)
 				offset = vertices_size;
 			}
 		}
-		mesh_binding_pose_offset += binding_pose_offset;
-		mesh_weights_offset += weights_offset;
+		model_binding_pose_offset = binding_pose_offset;
+		model_weights_offset = weights_offset;
 	}
 
 	std::vector<float> meshes_buffer;
@@ -153,17 +175,27 @@ void RenderBuffers::load_animated_entity_buffers(const Scene& scene)
 	LOG_ASSERT(sizeof(GLuint) == sizeof(float)
 		&& "This system has different sizes for unsigned int and float, which is currently unsupported.");
 
+	// Every pose slot gets its own vertices to be skinned into, but they all
+	// share one copy of the indices
 	for (auto& model : model_list)
 	{
 		const std::vector<MeshData>& mesh_data_list = model->mesh_data_list;
-		for (const auto& entity : model->entity_list)
+		if (model->entity_list.empty())
+		{
+			continue;
+		}
+		const size_t slot_count = pose_slot_count(*model);
+		for (size_t slot = 0; slot < slot_count; ++slot)
 		{
 			for (const auto& mesh_data : mesh_data_list)
 			{
 				mesh_data.append_vertices_to_buffer(meshes_buffer);
-				mesh_data.append_indices_to_buffer(indices_buffer);
 			}
 		}
+		for (const auto& mesh_data : mesh_data_list)
+		{
+			mesh_data.append_indices_to_buffer(indices_buffer);
+		}
 	}
 	glBindBuffer(GL_ARRAY_BUFFER, dest_animation_vbo);
 	glBufferData(GL_ARRAY_BUFFER, meshes_buffer.size() * sizeof(float),
@@ -183,6 +215,7 @@ void RenderBuffers::load_animated_entity_buffers(const Scene& scene)
 void RenderBuffers::load_animated_models(const Scene& scene)
 {
 	buffers_populated = true;
+	++animated_buffers_generation;
 	const ModelList& model_list = scene.get_animated_model_list();
 
 	load_binding_poses(model_list);
@@ -108,18 +108,26 @@ ShaderModuleHandle Shader::create_shader(const Shader::Module& shader_data)
 
 	LOG_ASSERT(shader_id != 0 && "Failed to create shader module");
 
-	Resource file(shader_data.file_name);
-	std::shared_ptr<ResourceHandle> shader_handle =
-		g_game_logic->resource_cache->get_handle(&file);
+	const char* shader_source = shader_data.source.data();
+	int source_length = static_cast<int>(shader_data.source.size());
 
-	if (!shader_handle)
+	// Kept alive until the source has been handed over
+	std::shared_ptr<ResourceHandle> shader_handle;
+	if (shader_data.source.empty())
 	{
-		LOG_ERROR(std::format("Cannot find shader {}", shader_data.file_name));
-		return false;
+		Resource file(shader_data.file_name);
+		shader_handle = g_game_logic->resource_cache->get_handle(&file);
+
+		if (!shader_handle)
+		{
+			LOG_ERROR(std::format("Cannot find shader {}",
+				shader_data.file_name));
+			return false;
+		}
+
+		shader_source = shader_handle->get_buffer();
+		source_length = static_cast<int>(shader_handle->get_size());
 	}
-
-	const char* shader_source = shader_handle->get_buffer();
-	const int source_length = static_cast<int>(shader_handle->get_size());
 	
 	glShaderSource(shader_id, 1, &shader_source, &source_length);
 	OpenGLUtil::check_gl_errors();
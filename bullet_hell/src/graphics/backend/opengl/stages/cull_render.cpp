@@ -0,0 +1,372 @@
+#include "graphics/frontend/backend_type.h"
+
+#if BACKEND_CURRENT == BACKEND_OPENGL
+
+#include "graphics/backend/opengl/stages/cull_render.h"
+
+#include <climits>
+#include <format>
+
+#include "debugging/logger.h"
+#include "graphics/scene/scene.h"
+#include "memory/memory_util.h"
+
+#include "glad.h"
+
+/// <summary>
+/// How many instances each work group of the compute shader culls, which
+/// has to match local_size_x in the shader.
+/// </summary>
+constexpr GLuint CULL_GROUP_SIZE = 64;
+
+/// <summary>
+/// Culls one instance per thread, counting up the instances of its command
+/// and writing a draw element for it if any of its bounding sphere is
+/// inside every plane. GpuCullPlan::cull does the same on the CPU, and the
+/// two have to be kept in step.
+/// </summary>
+constexpr const char* CULL_SHADER_SOURCE = R"(#version 460 core
+layout(local_size_x = 64) in;
+
+struct Draw
+{
+	vec4 sphere;
+	int material;
+	int first_element;
+	int padding[2];
+};
+
+struct Instance
+{
+	int matrix_index;
+	int draw;
+};
+
+struct Command
+{
+	uint count;
+	uint instance_count;
+	uint first_index;
+	int base_vertex;
+	uint base_instance;
+};
+
+layout(std430, binding = 0) readonly buffer ModelMatrices
+{
+	mat4 model_matrices[];
+};
+
+layout(std430, binding = 1) readonly buffer Draws
+{
+	Draw draws[];
+};
+
+layout(std430, binding = 2) readonly buffer Instances
+{
+	Instance instances[];
+};
+
+layout(std430, binding = 3) buffer Commands
+{
+	Command commands[];
+};
+
+layout(std430, binding = 4) writeonly buffer DrawElements
+{
+	ivec2 draw_elements[];
+};
+
+uniform vec4 planes[6];
+uniform uint instance_count;
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= instance_count)
+	{
+		return;
+	}
+
+	Instance instance = instances[index];
+	Draw draw = draws[instance.draw];
+	mat4 matrix = model_matrices[instance.matrix_index];
+
+	vec3 center = (matrix * vec4(draw.sphere.xyz, 1.0)).xyz;
+	float scale = max(length(matrix[0].xyz),
+		max(length(matrix[1].xyz), length(matrix[2].xyz)));
+	float radius = draw.sphere.w * scale;
+
+	for (int i = 0; i < 6; ++i)
+	{
+		if (dot(planes[i].xyz, center) + planes[i].w < -radius)
+		{
+			return;
+		}
+	}
+
+	uint slot = atomicAdd(commands[instance.draw].instance_count, 1u);
+	draw_elements[draw.first_element + int(slot)] =
+		ivec2(instance.matrix_index, draw.material);
+}
+)";
+
+/// <summary>
+/// Build a draw command for each mesh of each static model, covering every
+/// entity of the model.
+/// </summary>
+/// <param name="models">The static models.</param>
+/// <param name="commands">Set to the draw commands.</param>
+/// <param name="draw_elements">Set to the draw elements.</param>
+static void build_static_commands(
+	const std::vector<std::shared_ptr<Model>>& models,
+	std::vector<int>& commands, std::vector<int>& draw_elements)
+{
+	commands.clear();
+	draw_elements.clear();
+
+	int first_index = 0;
+	int base_instance = 0;
+	int first_matrix = 0;
+	for (const auto& model : models)
+	{
+		const int entity_count = static_cast<int>(model->entity_list.size());
+		for (const auto& mesh_draw_data : model->mesh_draw_data_list)
+		{
+			commands.insert(commands.end(), { mesh_draw_data.indices,
+				entity_count, first_index, mesh_draw_data.offset,
+				base_instance });
+			first_index += mesh_draw_data.indices;
+			base_instance += entity_count;
+
+			for (int entity = 0; entity < entity_count; ++entity)
+			{
+				draw_elements.push_back(first_matrix + entity);
+				draw_elements.push_back(mesh_draw_data.material);
+			}
+		}
+		first_matrix += entity_count;
+	}
+}
+
+CullRender::CullRender(StageResource<CommandBuffers>* command_buffers,
+	StageResource<CascadeCommandBuffers>* cascade_command_buffers,
+	StageResource<CascadeShadows>* cascade_shadows,
+	const AnimationRender* animation_render)
+	: command_buffers{ command_buffers }
+	, cascade_command_buffers{ cascade_command_buffers }
+	, cascade_shadows{ cascade_shadows }
+	, animation_render{ animation_render }
+	, static_plan{}
+	, animated_plan{}
+	, static_buffers{}
+	, animated_buffers{}
+	, static_shapes{}
+	, current_static_shapes{}
+	, animated_generation{ 0 }
+	, animated_plan_built{ false }
+	, static_commands{}
+	, static_draw_elements{}
+{
+	// Shipped with the code rather than the other shaders, since it has to
+	// match GpuCullPlan
+	std::vector<Shader::Module> shader_modules;
+	shader_modules.push_back(Shader::Module{ "cull.compute",
+		Shader::Type::COMPUTE, CULL_SHADER_SOURCE });
+
+	shader = ALLOC Shader(shader_modules);
+	for (int i = 0; i < 6; ++i)
+	{
+		shader->uniforms.create_uniform(std::format("planes[{}]", i));
+	}
+	shader->uniforms.create_uniform("instance_count");
+
+	for (PlanBuffers* buffers : { &static_buffers, &animated_buffers })
+	{
+		glGenBuffers(1, &buffers->commands);
+		glGenBuffers(1, &buffers->draws);
+		glGenBuffers(1, &buffers->instances);
+	}
+}
+
+CullRender::~CullRender()
+{
+	for (PlanBuffers* buffers : { &static_buffers, &animated_buffers })
+	{
+		glDeleteBuffers(1, &buffers->commands);
+		glDeleteBuffers(1, &buffers->draws);
+		glDeleteBuffers(1, &buffers->instances);
+	}
+	safe_delete(shader);
+}
+
+void CullRender::render(Scene& scene)
+{
+	update_plans(scene);
+
+	// The shadow stage draws from these, so it shares our cascades
+	CascadeShadowSlice::updateCascadeShadows(**cascade_shadows, scene);
+
+	CommandBuffers& camera = **command_buffers;
+	CascadeCommandBuffers& cascades = **cascade_command_buffers;
+
+	shader->bind();
+
+	const Frustum frustum(scene.projection.projection_matrix
+		* scene.camera.view_matrix);
+	cull(static_plan, static_buffers, camera.static_model_matrices, frustum,
+		camera.static_command_buffer, camera.static_draw_element_buffer);
+	cull(animated_plan, animated_buffers, camera.animated_model_matrices,
+		frustum, camera.animated_command_buffer,
+		camera.animated_draw_element_buffer);
+
+	for (unsigned int i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		const Frustum cascade((**cascade_shadows)[i].projection_view_matrix);
+		cull(static_plan, static_buffers,
+			camera.static_model_matrices, cascade,
+			cascades.static_command_buffers[i],
+			cascades.static_draw_element_buffers[i]);
+		cull(animated_plan, animated_buffers,
+			camera.animated_model_matrices, cascade,
+			cascades.animated_command_buffers[i],
+			cascades.animated_draw_element_buffers[i]);
+	}
+
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	shader->unbind();
+}
+
+void CullRender::update_plans(const Scene& scene)
+{
+	CommandBuffers& camera = **command_buffers;
+	CascadeCommandBuffers& cascades = **cascade_command_buffers;
+
+	const auto& static_models = scene.get_static_model_list();
+	current_static_shapes.clear();
+	for (const auto& model : static_models)
+	{
+		current_static_shapes.push_back(StaticModelShape{ model.get(),
+			model->entity_list.size(), model->mesh_draw_data_list.size() });
+	}
+	if (current_static_shapes != static_shapes)
+	{
+		static_shapes.swap(current_static_shapes);
+		build_static_commands(static_models, static_commands,
+			static_draw_elements);
+		static_plan.build(static_models, static_commands,
+			static_draw_elements);
+		upload_plan(static_plan, static_buffers,
+			camera.static_command_buffer, camera.static_draw_element_buffer,
+			cascades.static_command_buffers,
+			cascades.static_draw_element_buffers);
+
+		LOG_ASSERT(static_plan.draws.size() <= UINT_MAX
+			&& "We have more static draws than fit in an unsigned int");
+		camera.static_draw_count =
+			static_cast<unsigned int>(static_plan.draws.size());
+	}
+
+	const unsigned int generation = animation_render->commands_generation();
+	if (!animated_plan_built || generation != animated_generation)
+	{
+		animated_generation = generation;
+		animated_plan_built = true;
+		animated_plan.build(scene.get_animated_model_list(),
+			animation_render->commands(), animation_render->draw_elements());
+		upload_plan(animated_plan, animated_buffers,
+			camera.animated_command_buffer,
+			camera.animated_draw_element_buffer,
+			cascades.animated_command_buffers,
+			cascades.animated_draw_element_buffers);
+
+		LOG_ASSERT(animated_plan.draws.size() <= UINT_MAX
+			&& "We have more animated draws than fit in an unsigned int");
+		camera.animated_draw_count =
+			static_cast<unsigned int>(animated_plan.draws.size());
+	}
+}
+
+void CullRender::upload_plan(const GpuCullPlan& plan,
+	const PlanBuffers& buffers, const GLuint command_buffer,
+	const GLuint draw_element_buffer,
+	const std::array<GLuint, SHADOW_MAP_CASCADE_COUNT>&
+		cascade_command_buffers,
+	const std::array<GLuint, SHADOW_MAP_CASCADE_COUNT>&
+		cascade_draw_element_buffers)
+{
+	const size_t command_bytes = plan.commands.size() * sizeof(int);
+	const size_t draw_element_bytes = plan.instances.size()
+		* GpuCullPlan::DRAW_ELEMENT_SIZE * sizeof(int);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.commands);
+	glBufferData(GL_COPY_WRITE_BUFFER, command_bytes, plan.commands.data(),
+		GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.draws);
+	glBufferData(GL_COPY_WRITE_BUFFER,
+		plan.draws.size() * sizeof(GpuCullPlan::Draw), plan.draws.data(),
+		GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.instances);
+	glBufferData(GL_COPY_WRITE_BUFFER,
+		plan.instances.size() * sizeof(GpuCullPlan::Instance),
+		plan.instances.data(), GL_STATIC_DRAW);
+
+	// Only ever written by the shader
+	glBindBuffer(GL_COPY_WRITE_BUFFER, command_buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, command_bytes, nullptr,
+		GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, draw_element_buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, draw_element_bytes, nullptr,
+		GL_DYNAMIC_DRAW);
+	for (unsigned int i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, cascade_command_buffers[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER, command_bytes, nullptr,
+			GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, cascade_draw_element_buffers[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER, draw_element_bytes, nullptr,
+			GL_DYNAMIC_DRAW);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void CullRender::cull(const GpuCullPlan& plan, const PlanBuffers& buffers,
+	const ModelMatrixRing& model_matrices, const Frustum& frustum,
+	const GLuint command_buffer, const GLuint draw_element_buffer)
+{
+	if (plan.commands.empty())
+	{
+		return;
+	}
+
+	// Start every command off with no instances, for the shader to count up
+	glBindBuffer(GL_COPY_READ_BUFFER, buffers.commands);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, command_buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+		plan.commands.size() * sizeof(int));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	if (plan.instances.empty())
+	{
+		return;
+	}
+
+	const auto& planes = frustum.get_planes();
+	for (size_t i = 0; i < planes.size(); ++i)
+	{
+		shader->uniforms.set_uniform(std::format("planes[{}]", i),
+			planes[i]);
+	}
+	const GLuint instance_count = static_cast<GLuint>(plan.instances.size());
+	shader->uniforms.set_uniform("instance_count", instance_count);
+
+	model_matrices.bind(0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffers.draws);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, buffers.instances);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, command_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, draw_element_buffer);
+
+	glDispatchCompute(
+		(instance_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+}
+
+#endif
@@ -16,6 +16,7 @@
 #include "graphics/graph/cascade_shadow_slice.h"
 #include "graphics/graph/mesh_data.h"
 #include "graphics/graph/model.h"
+#include "graphics/scene/entity_view.h"
 #include "graphics/scene/scene.h"
 #include "main/game_logic.h"
 #include "map/chunk.h"
@@ -222,7 +223,7 @@ void DebugRender::update_AABBs(const Scene& scene)
 
         for (auto& entity : model->entity_list)
         {
-            glm::vec3 position = entity->position;
+            glm::vec3 position = g_entity_view->position(entity);
 
             for (const auto& box : boxes)
             {
@@ -290,7 +291,7 @@ void DebugRender::update_lines(const Scene& scene)
         {
             for (auto& entity : model_pair.second)
             {
-                glm::vec3 start = entity->position;
+                glm::vec3 start = g_entity_view->position(entity);
                 glm::vec3 end = start + glm::vec3(0.0f, 1.0f, 0.0f);
                 lines.emplace_back(start, end);
 
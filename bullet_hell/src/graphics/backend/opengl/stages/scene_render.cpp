@@ -90,8 +90,7 @@ void SceneRender::common_scene_render(Scene& scene)
 
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
         (*command_buffers)->static_draw_element_buffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MATRICES_BINDING,
-        (*command_buffers)->static_model_matrices_buffer);
+    (*command_buffers)->static_model_matrices.bind(MODEL_MATRICES_BINDING);
     glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
         (*command_buffers)->static_command_buffer);
     glBindVertexArray((*render_buffers)->static_vao);
@@ -102,8 +101,7 @@ void SceneRender::common_scene_render(Scene& scene)
 
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
         (*command_buffers)->animated_draw_element_buffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MATRICES_BINDING,
-        (*command_buffers)->animated_model_matrices_buffer);
+    (*command_buffers)->animated_model_matrices.bind(MODEL_MATRICES_BINDING);
     glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
         (*command_buffers)->animated_command_buffer);
     glBindVertexArray((*render_buffers)->animated_vao);
@@ -14,11 +14,13 @@
 ShadowRender::ShadowRender(StageResource<RenderBuffers>* render_buffers,
 	StageResource<CascadeShadows>* cascade_shadows,
 	StageResource<Framebuffer>* depth_map,
-	StageResource<CommandBuffers>* command_buffers)
+	StageResource<CommandBuffers>* command_buffers,
+	StageResource<CascadeCommandBuffers>* cascade_command_buffers)
 	: render_buffers{ render_buffers }
 	, cascade_shadows{ cascade_shadows }
 	, depth_map{ depth_map }
 	, command_buffers{ command_buffers }
+	, cascade_command_buffers{ cascade_command_buffers }
 {
 	std::vector<Shader::Module> shader_modules;
 	shader_modules.emplace_back("shaders/shadow.vert",
@@ -31,7 +33,9 @@ ShadowRender::ShadowRender(StageResource<RenderBuffers>* render_buffers,
 
 void ShadowRender::render(Scene& scene)
 {
-    CascadeShadowSlice::updateCascadeShadows(**cascade_shadows, scene);
+    // The cull stage has already updated the cascades and culled against
+    // them
+    const CascadeCommandBuffers& cascades = **cascade_command_buffers;
 
     glBindFramebuffer(GL_FRAMEBUFFER, (*depth_map)->handle);
     glViewport(0, 0, SHADOW_MAP_WIDTH, SHADOW_MAP_HEIGHT);
@@ -46,17 +50,16 @@ void ShadowRender::render(Scene& scene)
     }
 
     //NOTE(ches) static meshes
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
-        (*command_buffers)->static_draw_element_buffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MATRICES_BINDING,
-        (*command_buffers)->static_model_matrices_buffer);
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
-        (*command_buffers)->static_command_buffer);
+    (*command_buffers)->static_model_matrices.bind(MODEL_MATRICES_BINDING);
     glBindVertexArray((*render_buffers)->static_vao);
     for (unsigned int i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
     {
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
             GL_TEXTURE_2D, (*depth_map)->textures[i], 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
+            cascades.static_draw_element_buffers[i]);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
+            cascades.static_command_buffers[i]);
 
         shader->uniforms.set_uniform("projection_view_matrix",
             (**cascade_shadows)[i].projection_view_matrix);
@@ -65,17 +68,16 @@ void ShadowRender::render(Scene& scene)
     }
 
     //NOTE(ches) animated meshes
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
-        (*command_buffers)->animated_draw_element_buffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MATRICES_BINDING,
-        (*command_buffers)->animated_model_matrices_buffer);
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
-        (*command_buffers)->animated_command_buffer);
+    (*command_buffers)->animated_model_matrices.bind(MODEL_MATRICES_BINDING);
     glBindVertexArray((*render_buffers)->animated_vao);
     for (unsigned int i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
     {
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
             GL_TEXTURE_2D, (*depth_map)->textures[i], 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
+            cascades.animated_draw_element_buffers[i]);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
+            cascades.animated_command_buffers[i]);
 
         shader->uniforms.set_uniform("projection_view_matrix",
             (**cascade_shadows)[i].projection_view_matrix);
@@ -10,6 +10,7 @@
 #include "graphics/graph/material.h"
 #include "graphics/graph/mesh_data.h"
 #include "graphics/graph/texture_resource.h"
+#include "graphics/scene/entity_view.h"
 #include "graphics/scene/scene.h"
 
 #include "glad.h"
@@ -65,7 +66,8 @@ void SkyboxRender::render(Scene& scene)
 
     glBindVertexArray((*skybox)->vao);
 
-    shader->uniforms.set_uniform("model_matrix", (*skybox)->entity->model_matrix);
+    shader->uniforms.set_uniform("model_matrix",
+        g_entity_view->model_matrix((*skybox)->entity));
     glDrawElements(GL_TRIANGLES, (*skybox)->index_count, GL_UNSIGNED_INT,
         nullptr);
 
@@ -0,0 +1,138 @@
+#include "graphics/graph/draw_culler.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+
+#include "debugging/logger.h"
+#include "graphics/scene/entity_view.h"
+
+DrawCuller::DrawCuller()
+	: source_commands{ nullptr }
+	, source_draw_elements{ nullptr }
+	, model_bounds{}
+	, center_x{}
+	, center_y{}
+	, center_z{}
+	, radius{}
+	, visible{}
+{}
+
+void DrawCuller::gather(const std::vector<std::shared_ptr<Model>>& models,
+	const std::vector<int>& commands, const std::vector<int>& draw_elements)
+{
+	source_commands = &commands;
+	source_draw_elements = &draw_elements;
+	model_bounds.clear();
+	center_x.clear();
+	center_y.clear();
+	center_z.clear();
+	radius.clear();
+
+	for (const auto& model : models)
+	{
+		const EntityList& entities = model->entity_list;
+		if (entities.empty())
+		{
+			continue;
+		}
+
+		const glm::vec4 sphere = model->bounding_sphere();
+		const glm::vec3 local_center{ sphere };
+		const float local_radius = sphere.w;
+
+		ModelBounds& bounds = model_bounds.emplace_back();
+		bounds.min = glm::vec3(std::numeric_limits<float>::max());
+		bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+		bounds.first_entity = center_x.size();
+		bounds.entity_count = entities.size();
+
+		for (const EntityHandle entity : entities)
+		{
+			const glm::mat4& matrix = g_entity_view->model_matrix(entity);
+			const glm::vec3 center{ matrix * glm::vec4(local_center, 1.0f) };
+
+			// Scaling stretches the sphere by at most the longest axis
+			const float scale = std::max({ glm::length(glm::vec3(matrix[0])),
+				glm::length(glm::vec3(matrix[1])),
+				glm::length(glm::vec3(matrix[2])) });
+			const float world_radius = local_radius * scale;
+
+			center_x.push_back(center.x);
+			center_y.push_back(center.y);
+			center_z.push_back(center.z);
+			radius.push_back(world_radius);
+
+			bounds.min = glm::min(bounds.min, center - world_radius);
+			bounds.max = glm::max(bounds.max, center + world_radius);
+		}
+	}
+}
+
+void DrawCuller::cull(const Frustum& frustum,
+	std::vector<int>& visible_commands,
+	std::vector<int>& visible_draw_elements)
+{
+	visible_commands.clear();
+	visible_draw_elements.clear();
+	if (source_commands == nullptr)
+	{
+		return;
+	}
+	const std::vector<int>& commands = *source_commands;
+	const std::vector<int>& draw_elements = *source_draw_elements;
+
+	visible.assign(center_x.size(), 0);
+	for (const ModelBounds& bounds : model_bounds)
+	{
+		if (!frustum.intersects_box(bounds.min, bounds.max))
+		{
+			continue;
+		}
+		const size_t first = bounds.first_entity;
+		frustum.intersects_spheres(center_x.data() + first,
+			center_y.data() + first, center_z.data() + first,
+			radius.data() + first, bounds.entity_count,
+			visible.data() + first);
+	}
+
+	for (size_t i = 0; i + COMMAND_SIZE <= commands.size();
+		i += COMMAND_SIZE)
+	{
+		const int instance_count = commands[i + 1];
+		const size_t base_instance = static_cast<size_t>(commands[i + 4]);
+		const int visible_base = static_cast<int>(
+			visible_draw_elements.size() / DRAW_ELEMENT_SIZE);
+
+		for (int instance = 0; instance < instance_count; ++instance)
+		{
+			const size_t element = (base_instance + instance)
+				* DRAW_ELEMENT_SIZE;
+			const size_t entity = static_cast<size_t>(draw_elements[element]);
+			LOG_ASSERT(entity < visible.size()
+				&& "Draw element refers to an entity we have no bounds for");
+			if (visible[entity] != 0)
+			{
+				visible_draw_elements.insert(visible_draw_elements.end(),
+					draw_elements.begin() + element,
+					draw_elements.begin() + element + DRAW_ELEMENT_SIZE);
+			}
+		}
+
+		const int visible_count = static_cast<int>(
+			visible_draw_elements.size() / DRAW_ELEMENT_SIZE) - visible_base;
+		if (visible_count == 0)
+		{
+			continue;
+		}
+		visible_commands.insert(visible_commands.end(),
+			commands.begin() + i, commands.begin() + i + COMMAND_SIZE);
+		const size_t written = visible_commands.size() - COMMAND_SIZE;
+		visible_commands[written + 1] = visible_count;
+		visible_commands[written + 4] = visible_base;
+	}
+}
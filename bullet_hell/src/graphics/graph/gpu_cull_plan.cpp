@@ -0,0 +1,113 @@
+#include "graphics/graph/gpu_cull_plan.h"
+
+#include <algorithm>
+
+#include "glm/geometric.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
+#include "debugging/logger.h"
+
+static_assert(sizeof(GpuCullPlan::Draw) == 32,
+	"Draws must match the std430 layout in the compute shader");
+static_assert(sizeof(GpuCullPlan::Instance) == 8,
+	"Instances must match the std430 layout in the compute shader");
+
+GpuCullPlan::GpuCullPlan()
+	: commands{}
+	, draws{}
+	, instances{}
+	, matrix_spheres{}
+{}
+
+void GpuCullPlan::build(const std::vector<std::shared_ptr<Model>>& models,
+	const std::vector<int>& source_commands,
+	const std::vector<int>& source_draw_elements)
+{
+	matrix_spheres.clear();
+	for (const auto& model : models)
+	{
+		matrix_spheres.insert(matrix_spheres.end(),
+			model->entity_list.size(), model->bounding_sphere());
+	}
+
+	commands = source_commands;
+	draws.clear();
+	instances.clear();
+	for (size_t i = 0; i + COMMAND_SIZE <= commands.size();
+		i += COMMAND_SIZE)
+	{
+		const int draw_index = static_cast<int>(draws.size());
+		const int instance_count = commands[i + 1];
+		const int base_instance = commands[i + 4];
+		commands[i + 1] = 0;
+
+		Draw& draw = draws.emplace_back();
+		draw.first_element = base_instance;
+		draw.padding[0] = 0;
+		draw.padding[1] = 0;
+		if (instance_count == 0)
+		{
+			std::fill(std::begin(draw.sphere), std::end(draw.sphere), 0.0f);
+			draw.material = 0;
+			continue;
+		}
+
+		// Every instance of a command shares a model and a mesh
+		const size_t first = static_cast<size_t>(base_instance)
+			* DRAW_ELEMENT_SIZE;
+		LOG_ASSERT(first + instance_count * DRAW_ELEMENT_SIZE
+			<= source_draw_elements.size()
+			&& "Command refers to draw elements that don't exist");
+		const size_t first_matrix =
+			static_cast<size_t>(source_draw_elements[first]);
+		LOG_ASSERT(first_matrix < matrix_spheres.size()
+			&& "Draw element refers to an entity we have no bounds for");
+		const glm::vec4& sphere = matrix_spheres[first_matrix];
+		draw.sphere[0] = sphere.x;
+		draw.sphere[1] = sphere.y;
+		draw.sphere[2] = sphere.z;
+		draw.sphere[3] = sphere.w;
+		draw.material = source_draw_elements[first + 1];
+
+		for (int instance = 0; instance < instance_count; ++instance)
+		{
+			const size_t element = first + instance * DRAW_ELEMENT_SIZE;
+			instances.push_back(
+				Instance{ source_draw_elements[element], draw_index });
+		}
+	}
+}
+
+void GpuCullPlan::cull(const Frustum& frustum,
+	const std::vector<glm::mat4>& model_matrices,
+	std::vector<int>& culled_commands,
+	std::vector<int>& culled_draw_elements) const
+{
+	culled_commands = commands;
+	culled_draw_elements.assign(instances.size() * DRAW_ELEMENT_SIZE, 0);
+
+	for (const Instance& instance : instances)
+	{
+		const Draw& draw = draws[instance.draw];
+		const glm::mat4& matrix = model_matrices[instance.matrix_index];
+
+		const glm::vec3 center{ matrix * glm::vec4(draw.sphere[0],
+			draw.sphere[1], draw.sphere[2], 1.0f) };
+		const float scale = std::max(glm::length(glm::vec3(matrix[0])),
+			std::max(glm::length(glm::vec3(matrix[1])),
+				glm::length(glm::vec3(matrix[2]))));
+		if (!frustum.intersects_sphere(center, draw.sphere[3] * scale))
+		{
+			continue;
+		}
+
+		int& instance_count =
+			culled_commands[instance.draw * COMMAND_SIZE + 1];
+		const size_t element = (static_cast<size_t>(draw.first_element)
+			+ instance_count) * DRAW_ELEMENT_SIZE;
+		culled_draw_elements[element] = instance.matrix_index;
+		culled_draw_elements[element + 1] = draw.material;
+		++instance_count;
+	}
+}
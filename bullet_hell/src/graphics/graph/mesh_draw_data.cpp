@@ -1,12 +1,8 @@
 #include "graphics/graph/mesh_draw_data.h"
 
-#include "graphics/scene/entity.h"
-
-AnimMeshDrawData::AnimMeshDrawData(std::shared_ptr<Entity> entity,
-	int binding_pose_offset,
+AnimMeshDrawData::AnimMeshDrawData(int binding_pose_offset,
 	int weights_offset)
-	: entity{ entity }
-	, binding_pose_offset{ binding_pose_offset }
+	: binding_pose_offset{ binding_pose_offset }
 	, weights_offset{ weights_offset }
 {}
 
@@ -1,5 +1,11 @@
 #include "graphics/graph/model.h"
 
+#include <limits>
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/vec3.hpp"
+
 Model::Model(const std::string id)
 	: id{ id }
 	, mesh_data_list{}
@@ -11,4 +17,21 @@ Model::Model(const std::string id)
 bool Model::is_animated()
 {
 	return !animation_list.empty();
+}
+
+[[nodiscard]] glm::vec4 Model::bounding_sphere() const noexcept
+{
+	glm::vec3 min{ std::numeric_limits<float>::max() };
+	glm::vec3 max{ std::numeric_limits<float>::lowest() };
+	for (const MeshData& mesh : mesh_data_list)
+	{
+		min = glm::min(min, mesh.aabb_min);
+		max = glm::max(max, mesh.aabb_max);
+	}
+	if (min.x > max.x)
+	{
+		return glm::vec4(0.0f);
+	}
+	const glm::vec3 center = (min + max) * 0.5f;
+	return glm::vec4(center, glm::length(max - center));
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "graphics/graph/pose_cache.h"
+
+#include "debugging/logger.h"
+
+/// <summary>
+/// Marks entities that have not been given a slot yet.
+/// </summary>
+constexpr uint32_t UNASSIGNED = std::numeric_limits<uint32_t>::max();
+
+PoseCache::PoseCache()
+	: slot_frames{}
+	, frame_slots{}
+	, slot_used{}
+{}
+
+void PoseCache::assign(const size_t model, const size_t slot_count,
+	const std::vector<int>& frames, std::vector<uint32_t>& entity_slots,
+	std::vector<uint32_t>& skin_slots)
+{
+	if (slot_frames.size() <= model)
+	{
+		slot_frames.resize(model + 1);
+	}
+	std::vector<int>& slots = slot_frames[model];
+	const size_t count = frames.size();
+	slots.resize(slot_count, EMPTY);
+
+	frame_slots.clear();
+	for (uint32_t slot = 0; slot < slots.size(); ++slot)
+	{
+		if (slots[slot] != EMPTY)
+		{
+			frame_slots.emplace(slots[slot], slot);
+		}
+	}
+	slot_used.assign(slot_count, 0);
+	entity_slots.resize(count);
+
+	// Poses that are already skinned stay where they are
+	bool all_assigned = true;
+	for (size_t entity = 0; entity < count; ++entity)
+	{
+		const auto found = frame_slots.find(frames[entity]);
+		if (found == frame_slots.end())
+		{
+			entity_slots[entity] = UNASSIGNED;
+			all_assigned = false;
+			continue;
+		}
+		entity_slots[entity] = found->second;
+		slot_used[found->second] = 1;
+	}
+	if (all_assigned)
+	{
+		return;
+	}
+
+	// New poses go in slots that nobody is drawing from this frame
+	uint32_t next_free = 0;
+	for (size_t entity = 0; entity < count; ++entity)
+	{
+		if (entity_slots[entity] != UNASSIGNED)
+		{
+			continue;
+		}
+		const int frame = frames[entity];
+		const auto found = frame_slots.find(frame);
+		if (found != frame_slots.end())
+		{
+			// Another entity in the same pose already claimed a slot
+			entity_slots[entity] = found->second;
+			continue;
+		}
+
+		while (next_free < slot_count && slot_used[next_free] != 0)
+		{
+			++next_free;
+		}
+		// Models get a slot for every frame they have, so this only fails
+		// if an entity shows a frame from another model
+		LOG_ASSERT(next_free < slot_count
+			&& "More different frames than pose slots");
+		if (slots[next_free] != EMPTY)
+		{
+			frame_slots.erase(slots[next_free]);
+		}
+		slots[next_free] = frame;
+		frame_slots.emplace(frame, next_free);
+		slot_used[next_free] = 1;
+		entity_slots[entity] = next_free;
+		skin_slots.push_back(next_free);
+	}
+}
+
+void PoseCache::clear()
+{
+	slot_frames.clear();
+}
+
+[[nodiscard]] int PoseCache::slot_frame(const size_t model,
+	const uint32_t slot) const noexcept
+{
+	if (model >= slot_frames.size() || slot >= slot_frames[model].size())
+	{
+		return EMPTY;
+	}
+	return slot_frames[model][slot];
+}
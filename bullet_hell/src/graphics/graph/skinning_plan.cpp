@@ -0,0 +1,223 @@
+#include "graphics/graph/skinning_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "graphics/graph/animation.h"
+#include "graphics/scene/entity_view.h"
+
+/// <summary>
+/// Marks entities that have not been drawn from any slot yet.
+/// </summary>
+constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+SkinningPlan::SkinningPlan()
+	: parameters{}
+	, dispatches{}
+	, commands{}
+	, draw_elements{}
+	, pose_cache{}
+	, generation{ 0 }
+	, drawn_slots{}
+	, frames{}
+	, entity_slots{}
+	, skin_slots{}
+	, slot_starts{}
+	, sorted_entities{}
+{}
+
+bool SkinningPlan::update(const std::vector<std::shared_ptr<Model>>& models,
+	const unsigned int buffers_generation)
+{
+	// Whatever was skinned into the old buffers is gone
+	bool commands_changed = false;
+	if (generation != buffers_generation)
+	{
+		pose_cache.clear();
+		drawn_slots.clear();
+		generation = buffers_generation;
+		commands_changed = true;
+	}
+
+	parameters.clear();
+	dispatches.clear();
+	size_t model_index = 0;
+	size_t first_entity = 0;
+	int destination_offset = 0;
+	for (const auto& model : models)
+	{
+		const std::vector<MeshDrawData>& draw_list =
+			model->mesh_draw_data_list;
+		const size_t mesh_count = model->mesh_data_list.size();
+		if (model->entity_list.empty() || draw_list.empty())
+		{
+			continue;
+		}
+		const size_t entity_count = model->entity_list.size();
+		const size_t slot_count = draw_list.size() / mesh_count;
+
+		frames.clear();
+		for (const auto& entity : model->entity_list)
+		{
+			const AnimatedFrame* frame = g_entity_view->animation_frame(entity);
+			// Entities that are not in the view are collapsed anyway
+			frames.push_back(
+				frame != nullptr ? static_cast<int>(frame->offset) : 0);
+		}
+		skin_slots.clear();
+		pose_cache.assign(model_index, slot_count, frames, entity_slots,
+			skin_slots);
+
+		if (drawn_slots.size() < first_entity + entity_count)
+		{
+			drawn_slots.resize(first_entity + entity_count, NO_SLOT);
+		}
+		const auto drawn = drawn_slots.begin() + first_entity;
+		if (!std::equal(entity_slots.begin(), entity_slots.end(), drawn))
+		{
+			std::copy(entity_slots.begin(), entity_slots.end(), drawn);
+			commands_changed = true;
+		}
+
+		int model_vertex_count = 0;
+		for (const auto& mesh_data : model->mesh_data_list)
+		{
+			model_vertex_count += static_cast<int>(mesh_data.vertices.size());
+		}
+
+		// Every slot is the same size, so where a pose goes is just an
+		// offset from the start of the model
+		const int slot_size = std::accumulate(draw_list.begin(),
+			draw_list.begin() + mesh_count, 0,
+			[](const int total, const MeshDrawData& mesh_draw_data)
+			{
+				return total + mesh_draw_data.size_in_bytes / 4;
+			});
+		for (const uint32_t slot : skin_slots)
+		{
+			const int frame_offset = pose_cache.slot_frame(model_index, slot);
+			int destination = destination_offset
+				+ static_cast<int>(slot) * slot_size;
+			for (size_t mesh = 0; mesh < mesh_count; ++mesh)
+			{
+				const MeshDrawData& mesh_draw_data =
+					draw_list[slot * mesh_count + mesh];
+				const AnimMeshDrawData& anim_mesh_draw_data =
+					mesh_draw_data.animated_mesh_draw_data;
+				parameters.insert(parameters.end(), {
+					anim_mesh_draw_data.binding_pose_offset,
+					mesh_draw_data.size_in_bytes / 4,
+					anim_mesh_draw_data.weights_offset,
+					frame_offset,
+					destination
+				});
+				destination += mesh_draw_data.size_in_bytes / 4;
+			}
+		}
+		if (!skin_slots.empty())
+		{
+			dispatches.push_back(Dispatch{ model_vertex_count,
+				static_cast<int>(skin_slots.size() * mesh_count) });
+		}
+
+		destination_offset += static_cast<int>(slot_count) * slot_size;
+		first_entity += entity_count;
+		++model_index;
+	}
+	if (drawn_slots.size() != first_entity)
+	{
+		drawn_slots.resize(first_entity);
+		commands_changed = true;
+	}
+
+	if (commands_changed)
+	{
+		build_commands(models);
+	}
+	return commands_changed;
+}
+
+void SkinningPlan::build_commands(
+	const std::vector<std::shared_ptr<Model>>& models)
+{
+	commands.clear();
+	draw_elements.clear();
+
+	// Model matrices are stored for every animated entity in model order
+	int model_matrix_index = 0;
+	// Index buffers hold one copy of each mesh, in model order
+	int first_index = 0;
+	size_t first_entity = 0;
+	int base_instance = 0;
+	for (const auto& model : models)
+	{
+		const std::vector<MeshDrawData>& draw_list =
+			model->mesh_draw_data_list;
+		const size_t mesh_count = model->mesh_data_list.size();
+		const size_t entity_count = model->entity_list.size();
+		if (entity_count == 0 || draw_list.empty())
+		{
+			model_matrix_index += static_cast<int>(entity_count);
+			continue;
+		}
+		const size_t slot_count = draw_list.size() / mesh_count;
+		const auto drawn = drawn_slots.begin() + first_entity;
+
+		// Sort the entities by slot, keeping them in order within each one
+		slot_starts.assign(slot_count + 1, 0);
+		for (size_t entity = 0; entity < entity_count; ++entity)
+		{
+			++slot_starts[drawn[entity] + 1];
+		}
+		for (size_t slot = 0; slot < slot_count; ++slot)
+		{
+			slot_starts[slot + 1] += slot_starts[slot];
+		}
+		sorted_entities.resize(entity_count);
+		for (uint32_t entity = 0; entity < entity_count; ++entity)
+		{
+			sorted_entities[slot_starts[drawn[entity]]++] = entity;
+		}
+		// Filling in moved each start up to where the next slot starts
+		std::rotate(slot_starts.rbegin(), slot_starts.rbegin() + 1,
+			slot_starts.rend());
+		slot_starts[0] = 0;
+
+		for (size_t mesh = 0; mesh < mesh_count; ++mesh)
+		{
+			for (size_t slot = 0; slot < slot_count; ++slot)
+			{
+				const int instances =
+					static_cast<int>(slot_starts[slot + 1] - slot_starts[slot]);
+				if (instances == 0)
+				{
+					continue;
+				}
+				const MeshDrawData& mesh_draw_data =
+					draw_list[slot * mesh_count + mesh];
+				commands.insert(commands.end(), {
+					mesh_draw_data.indices,
+					instances,
+					first_index,
+					mesh_draw_data.offset,
+					base_instance
+				});
+				base_instance += instances;
+
+				for (uint32_t i = slot_starts[slot]; i < slot_starts[slot + 1];
+					++i)
+				{
+					draw_elements.push_back(
+						model_matrix_index
+						+ static_cast<int>(sorted_entities[i]));
+					draw_elements.push_back(mesh_draw_data.material);
+				}
+			}
+			first_index += draw_list[mesh].indices;
+		}
+
+		model_matrix_index += static_cast<int>(entity_count);
+		first_entity += entity_count;
+	}
+}
@@ -7,13 +7,11 @@
 #include "glm/glm.hpp"
 #include "imgui.h"
 
-#include "entities/pawn.h"
-#include "entities/pawn_manager.h"
 #include "debugging/timer.h"
 #include "graphics/frontend/backend_type.h"
 #include "graphics/graph/animation.h"
 #include "graphics/render/render.h"
-#include "graphics/scene/entity.h"
+#include "graphics/scene/entity_view.h"
 #include "graphics/scene/scene.h"
 #include "main/game_logic.h"
 
@@ -99,47 +97,59 @@ void DebugUI::draw_window_debug()
 	ImGui::Text(std::format("FPS for the last second: {}", 
 		std::to_string(actual_fps)).c_str());
 
-	const glm::vec3& player_position = 
-		g_pawn_manager->player->scene_entity->position;
+	const SimulationSnapshot& snapshot = *g_game_logic->frame_snapshot;
+	const EntityHandle player_entity = snapshot.player_entity;
+	const glm::vec3 player_position = g_entity_view->position(player_entity);
 	ImGui::Text(std::format("Player position: ({}, {}, {})",
 		std::to_string(player_position.x),
 		std::to_string(player_position.y),
 		std::to_string(player_position.z)).c_str());
 
 	const glm::vec2& desired_player_rotation =
-		g_pawn_manager->player->desired_facing;
+		snapshot.player_desired_facing;
 	ImGui::Text(std::format("Desired player rotation: ({}, {})",
 		std::to_string(desired_player_rotation.x),
 		std::to_string(desired_player_rotation.y)).c_str());
 
-	const glm::quat& player_rotation = 
-		g_pawn_manager->player->scene_entity->rotation;
+	const glm::quat player_rotation = g_entity_view->rotation(player_entity);
 	ImGui::Text(std::format("Actual player rotation: ({}, {}, {}, {})",
 		std::to_string(player_rotation.x),
 		std::to_string(player_rotation.y),
 		std::to_string(player_rotation.z), 
 		std::to_string(player_rotation.w)).c_str());
 
-	const auto& animation_data = 
-		g_pawn_manager->player->scene_entity->animation_data;
+	const Animation* player_animation =
+		g_entity_view->animation(player_entity);
 	ImGui::Text(std::format("Player animation: {}",
-		animation_data.current_animation != nullptr 
-		? animation_data.current_animation->name :"(none)").c_str());
+		player_animation != nullptr 
+		? player_animation->name :"(none)").c_str());
 	ImGui::Text(std::format("Player animation frame: {}",
-		std::to_string(animation_data.current_frame_index)).c_str());
+		std::to_string(g_entity_view->animation_frame_index(player_entity))
+	).c_str());
 
-	const size_t enemy_count = g_pawn_manager->enemies.size();
+	const size_t enemy_count = snapshot.enemy_count;
 	ImGui::Text(std::format("Enemy count: {}",
 		std::to_string(enemy_count)).c_str());
 	
-	const size_t enemy_bullet_count = g_pawn_manager->enemy_bullets.size();
+	const size_t enemy_bullet_count = snapshot.enemy_bullet_count;
 	ImGui::Text(std::format("Enemy bullet count: {}",
 		std::to_string(enemy_bullet_count)).c_str());
 
-	const size_t player_bullet_count = g_pawn_manager->player_bullets.size();
+	const size_t player_bullet_count = snapshot.player_bullet_count;
 	ImGui::Text(std::format("Player bullet count: {}",
 		std::to_string(player_bullet_count)).c_str());
 
+	const SimulationLoad& load = snapshot.load;
+	ImGui::Text(std::format("Simulation speed: {}%",
+		std::to_string(static_cast<int>(load.time_dilation * 100))).c_str());
+	ImGui::Text(std::format("Shedding load? {}",
+		load.shedding ? "yes" : "no").c_str());
+	ImGui::Text(std::format("Overrun ticks: {}",
+		std::to_string(load.overrun_ticks)).c_str());
+	ImGui::Text(std::format("Dropped ticks: {} in {} catch ups",
+		std::to_string(load.dropped_ticks),
+		std::to_string(load.capped_catch_ups)).c_str());
+
 	ImGui::End();
 }
 
@@ -5,7 +5,6 @@
 #if _DEBUG
 #include "graphics/gui/debug_ui.h"
 #endif
-#include "entities/pawn_manager.h"
 #include "main/game_logic.h"
 #include "resource_cache/resource_cache.h"
 
@@ -219,8 +218,9 @@ void UI::draw_player_health()
 		ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs
 	);
 	
-	const int current_health = g_pawn_manager->player->health;
-	const int max_health = g_pawn_manager->player->max_health;
+	const SimulationSnapshot& snapshot = *g_game_logic->frame_snapshot;
+	const int current_health = snapshot.player_health;
+	const int max_health = snapshot.player_max_health;
 	const float health = static_cast<float>(current_health) / max_health;
 
 	std::string overlay = std::to_string(current_health) + "/" 
@@ -4,13 +4,10 @@
 
 #include "graphics/render/animation_render.h"
 
-#include <cmath>
 #include <vector>
 
 #include "debugging/logger.h"
 #include "graphics/backend/opengl/render_buffers.h"
-#include "graphics/graph/animation.h"
-#include "graphics/graph/mesh_draw_data.h"
 #include "graphics/scene/scene.h"
 #include "main/game_logic.h"
 #include "resource_cache/resource_cache.h"
@@ -18,6 +15,7 @@
 #include "glad.h"
 
 AnimationRender::AnimationRender()
+    : skinning_plan{}
 {
     Resource compute("shaders/animation.compute");
     std::shared_ptr<ResourceHandle> compute_handle =
@@ -33,58 +31,20 @@ AnimationRender::AnimationRender()
     uniforms_map->create_uniform("base_draw_parameter");
 }
 
-struct RenderInfo
-{
-    int model_vertex_count;
-    int entity_count;
-};
-
 void AnimationRender::render(const Scene& scene,
     const RenderBuffers& render_buffer)
 {
-    const auto& model_list = scene.get_animated_model_list();
+    // The draw commands are culled for each pass, so whether they changed
+    // doesn't matter here
+    skinning_plan.update(scene.get_animated_model_list(),
+        render_buffer.animated_buffers_generation);
 
-    int destination_offset = 0;
-    std::map<std::string, RenderInfo> render_info;
-    int parameter_count = 0;
-    std::vector<int> parameter_list;
-    for (const auto& model : model_list)
+    const std::vector<int>& parameter_list = skinning_plan.parameters;
+    if (parameter_list.empty())
     {
-        if (model->entity_list.empty())
-        {
-            continue;
-        }
-
-        int model_vertex_count = 0;
-        const int entity_count = static_cast<int>(model->entity_list.size());
-
-        for (const auto& mesh_data : model->mesh_data_list)
-        {
-            model_vertex_count += static_cast<int>(mesh_data.vertices.size());
-        }
-
-        for (const auto& mesh_draw_data : model->mesh_draw_data_list)
-        {
-            const AnimMeshDrawData& anim_mesh_draw_data =
-                mesh_draw_data.animated_mesh_draw_data;
-            std::shared_ptr<Entity> entity = anim_mesh_draw_data.entity;
-            const AnimatedFrame& frame = 
-                entity->animation_data.get_current_frame();
-            
-            parameter_list.push_back(anim_mesh_draw_data.binding_pose_offset);
-            parameter_list.push_back(mesh_draw_data.size_in_bytes / 4);
-            parameter_list.push_back(anim_mesh_draw_data.weights_offset);
-            parameter_list.push_back(static_cast<int>(frame.offset));
-            parameter_list.push_back(destination_offset);
-            ++parameter_count;
-            destination_offset += mesh_draw_data.size_in_bytes / 4;
-        }
-
-        render_info.emplace(
-            model->id, 
-            RenderInfo{ model_vertex_count, entity_count }
-        );
+        return;
     }
+
     glBindBuffer(GL_SHADER_STORAGE_BUFFER,
         render_buffer.animation_draw_parameters_ssbo);
     glBufferData(GL_SHADER_STORAGE_BUFFER,
@@ -103,23 +63,27 @@ void AnimationRender::render(const Scene& scene,
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4,
         render_buffer.animation_draw_parameters_ssbo);
 
-    int mesh_count = 0;
     int base_draw_parameter = 0;
-    for (const auto& model : model_list)
+    for (const SkinningPlan::Dispatch& dispatch : skinning_plan.dispatches)
     {
-        if (model->entity_list.empty())
-        {
-            continue;
-        }
-        const RenderInfo& info = render_info.find(model->id)->second;
-        
-        mesh_count = static_cast<int>(model->mesh_data_list.size());
         uniforms_map->set_uniform("base_draw_parameter", base_draw_parameter);
-        glDispatchCompute(info.model_vertex_count, info.entity_count * mesh_count, 1);
-        base_draw_parameter += info.entity_count * mesh_count;
+        glDispatchCompute(dispatch.model_vertex_count, dispatch.draw_count, 1);
+        base_draw_parameter += dispatch.draw_count;
     }
 
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     shader_program->unbind();
 }
+
+[[nodiscard]] const std::vector<int>& AnimationRender::commands()
+    const noexcept
+{
+    return skinning_plan.commands;
+}
+
+[[nodiscard]] const std::vector<int>& AnimationRender::draw_elements()
+    const noexcept
+{
+    return skinning_plan.draw_elements;
+}
 #endif
\ No newline at end of file
@@ -6,13 +6,13 @@
 
 #include <unordered_map>
 
-#include "glm/gtc/type_ptr.hpp"
-
 #include "debugging/logger.h"
 #include "debugging/timer.h"
 #include "graphics/window.h"
 #include "graphics/graph/mesh_draw_data.h"
 #include "graphics/backend/opengl/quad_mesh.h"
+#include "graphics/scene/entity_view.h"
+#include "graphics/scene/frustum.h"
 #include "graphics/scene/scene.h"
 #include "utilities/opengl_util.h"
 
@@ -32,6 +32,12 @@ Render::Render(const Window& window)
 	, filter_render{}
 	, render_buffers{}
 	, command_buffers{}
+	, static_commands{}
+	, static_draw_elements{}
+	, static_culler{}
+	, animated_culler{}
+	, visible_commands{}
+	, visible_draw_elements{}
 	, screen_FBO{ 0 }
 	, screen_RBO_depth{ 0 }
 	, screen_texture{ 0 }
@@ -77,6 +83,29 @@ Render::~Render()
 	glDeleteTextures(1, &screen_texture);
 }
 
+void Render::cull_draw_commands(const Scene& scene)
+{
+	static_culler.gather(scene.get_static_model_list(), static_commands,
+		static_draw_elements);
+	animated_culler.gather(scene.get_animated_model_list(),
+		animation_render.commands(), animation_render.draw_elements());
+
+	const Frustum frustum(scene.projection.projection_matrix
+		* scene.camera.view_matrix);
+
+	static_culler.cull(frustum, visible_commands, visible_draw_elements);
+	command_buffers.static_draw_count = upload_draw_commands(
+		command_buffers.static_command_buffer,
+		command_buffers.static_draw_element_buffer, visible_commands,
+		visible_draw_elements);
+
+	animated_culler.cull(frustum, visible_commands, visible_draw_elements);
+	command_buffers.animated_draw_count = upload_draw_commands(
+		command_buffers.animated_command_buffer,
+		command_buffers.animated_draw_element_buffer, visible_commands,
+		visible_draw_elements);
+}
+
 void Render::light_render_finish()
 {
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -182,8 +211,13 @@ void Render::render(const Window& window, const Scene& scene)
 	animation_render.render(scene, render_buffers);
 	TIME_END("Animation Render");
 
+	TIME_START("Culling");
+	cull_draw_commands(scene);
+	TIME_END("Culling");
+
 	TIME_START("Shadow Render");
-	shadow_render.render(scene, render_buffers, command_buffers);
+	shadow_render.render(scene, render_buffers, command_buffers,
+		static_culler, animated_culler);
 	TIME_END("Shadow Render");
 
 	TIME_START("Scene Render");
@@ -291,115 +325,11 @@ void Render::setup_all_data(Scene& scene)
 
 void Render::setup_animated_command_buffer(const Scene& scene)
 {
-	const std::vector<std::shared_ptr<Model>>& model_list = 
-		scene.get_animated_model_list();
-
 	render_buffers.load_animated_entity_buffers(scene);
 
-	size_t mesh_count = 0;
-	size_t entity_count = 0;
-	for (const auto& model : model_list)
-	{
-		mesh_count += model->mesh_draw_data_list.size();
-		entity_count += model->entity_list.size();
-	}
-
-	std::map<const uint64_t, int> entity_index_map;
-
-	float* model_matrices = ALLOC float[entity_count * 16];
-
-	int entity_index = 0;
-	for (const auto& model : model_list)
-	{
-		EntityList& entities = model->entity_list;
-		for (const auto& entity : entities)
-		{
-			const float* matrix = static_cast<const float*>(
-				glm::value_ptr(entity->model_matrix));
-			for (size_t i = 0; i < 16; ++i)
-			{
-				model_matrices[static_cast<size_t>(entity_index) * 16 + i] 
-					= matrix[i];
-			}
-			entity_index_map.emplace(
-				std::make_pair(entity->entity_ID, entity_index));
-			++entity_index;
-		}
-	}
-	size_t data_size_in_bytes = entity_count * 16 * sizeof(float);
-	
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER,
-		command_buffers.animated_model_matrices_buffer);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, data_size_in_bytes, model_matrices,
-		GL_DYNAMIC_DRAW);
-	safe_delete_array(model_matrices);
-
-	int first_index = 0;
-	int base_instance = 0;
-
-	int command_buffer_index = 0;
-	int draw_element_index = 0;
-	const int COMMAND_SIZE = 5;
-	const int DRAW_ELEMENT_SIZE = 2;
-
-	const int padding = 0;
-
-	int* command_buffer = ALLOC int[mesh_count * COMMAND_SIZE];
-	int* draw_elements = ALLOC int[mesh_count * DRAW_ELEMENT_SIZE];
-	for (const auto& model : model_list)
-	{
-		for (const auto& mesh_draw_data : model->mesh_draw_data_list)
-		{
-			// count
-			command_buffer[command_buffer_index * COMMAND_SIZE + 0] =
-				mesh_draw_data.indices;
-			// instance count
-			command_buffer[command_buffer_index * COMMAND_SIZE + 1] = 1;
-			command_buffer[command_buffer_index * COMMAND_SIZE + 2] =
-				first_index;
-			// base vertex
-			command_buffer[command_buffer_index * COMMAND_SIZE + 3] =
-				mesh_draw_data.offset;
-			command_buffer[command_buffer_index * COMMAND_SIZE + 4] =
-				base_instance;
-
-			first_index += mesh_draw_data.indices;
-			++base_instance;
-			++command_buffer_index;
-
-			const auto& entity = mesh_draw_data.animated_mesh_draw_data.entity;
-
-			const auto result = entity_index_map.find(entity->entity_ID);
-			LOG_ASSERT(result != entity_index_map.end()
-				&& "Entity ID not found in the index map");
-			draw_elements[draw_element_index * DRAW_ELEMENT_SIZE] =
-				result->second;
-			draw_elements[draw_element_index * DRAW_ELEMENT_SIZE + 1] =
-				mesh_draw_data.material;
-			++draw_element_index;
-		}
-	}
-
-	data_size_in_bytes = mesh_count * COMMAND_SIZE * sizeof(int);
-
-	LOG_ASSERT(mesh_count <= UINT_MAX
-		&& "We have more animated models than fit in an unsigned int");
-
-	command_buffers.animated_draw_count = static_cast<unsigned int>(mesh_count);
-
-	glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
-		command_buffers.animated_command_buffer);
-	glBufferData(GL_DRAW_INDIRECT_BUFFER, data_size_in_bytes, command_buffer,
-		GL_STATIC_DRAW);
-	safe_delete_array(command_buffer);
-
-	data_size_in_bytes = mesh_count * DRAW_ELEMENT_SIZE * sizeof(int);
-
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER,
-		command_buffers.animated_draw_element_buffer);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, data_size_in_bytes, draw_elements,
-		GL_STATIC_DRAW);
-	safe_delete_array(draw_elements);
+	// Which pose each entity is drawn from changes as they animate, so the
+	// animation render works out the draw commands once it has skinned them
+	command_buffers.animated_draw_count = 0;
 }
 
 void Render::setup_static_command_buffer(const Scene& scene)
@@ -409,57 +339,36 @@ void Render::setup_static_command_buffer(const Scene& scene)
 
 	size_t mesh_count = 0;
 	size_t draw_element_count = 0;
-	size_t entity_count = 0;
 	for (const auto& model : model_list)
 	{
 		mesh_count += model->mesh_draw_data_list.size();
 		draw_element_count += model->entity_list.size()
 			* model->mesh_draw_data_list.size();
-		entity_count += model->entity_list.size();
 	}
 
-	std::map<const uint64_t, int> entity_index_map;
-
-	float* model_matrices = ALLOC float[entity_count * 16];
-
+	// The model matrices are written in this order every frame by
+	// update_model_matrices
+	std::map<const uint32_t, int> entity_index_map;
 	int entity_index = 0;
 	for (const auto& model : model_list)
 	{
-		EntityList& entities = model->entity_list;
-		for (const auto& entity : entities)
+		for (const auto& entity : model->entity_list)
 		{
-			const float* matrix =  static_cast<const float*>(
-				glm::value_ptr(entity->model_matrix));
-			for (size_t i = 0; i < 16; ++i)
-			{
-				model_matrices[static_cast<size_t>(entity_index) * 16 + i]
-					= matrix[i];
-			}
 			entity_index_map.emplace(
-				std::make_pair(entity->entity_ID, entity_index));
+				std::make_pair(entity.index, entity_index));
 			++entity_index;
 		}
 	}
-	size_t data_size_in_bytes = entity_count * 16 * sizeof(float);
-
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER,
-		command_buffers.static_model_matrices_buffer);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, data_size_in_bytes, model_matrices,
-		GL_DYNAMIC_DRAW);
-	safe_delete_array(model_matrices);
 
 	int first_index = 0;
 	int base_instance = 0;
 
-	int command_buffer_index = 0;
-	int draw_element_index = 0;
-	const int COMMAND_SIZE = 5;
-	const int DRAW_ELEMENT_SIZE = 2;
-
-	const int padding = 0;
-
-	int* command_buffer = ALLOC int[mesh_count * COMMAND_SIZE];
-	int* draw_elements = ALLOC int[draw_element_count * DRAW_ELEMENT_SIZE];
+	// Kept here rather than uploaded, since they are culled every frame
+	static_commands.clear();
+	static_draw_elements.clear();
+	static_commands.reserve(mesh_count * DrawCuller::COMMAND_SIZE);
+	static_draw_elements.reserve(draw_element_count
+		* DrawCuller::DRAW_ELEMENT_SIZE);
 	for (const auto& model : model_list)
 	{
 		const EntityList& entities = model->entity_list;
@@ -467,105 +376,37 @@ void Render::setup_static_command_buffer(const Scene& scene)
 		for (const auto& mesh_draw_data : model->mesh_draw_data_list)
 		{
 			// count
-			command_buffer[command_buffer_index * COMMAND_SIZE + 0] =
-				mesh_draw_data.indices;
-			command_buffer[command_buffer_index * COMMAND_SIZE + 1] =
-				entity_count;
-			command_buffer[command_buffer_index * COMMAND_SIZE + 2] =
-				first_index;
+			static_commands.push_back(mesh_draw_data.indices);
+			static_commands.push_back(entity_count);
+			static_commands.push_back(first_index);
 			// base vertex
-			command_buffer[command_buffer_index * COMMAND_SIZE + 3] =
-				mesh_draw_data.offset;
-			command_buffer[command_buffer_index * COMMAND_SIZE + 4] =
-				base_instance;
+			static_commands.push_back(mesh_draw_data.offset);
+			static_commands.push_back(base_instance);
 
 			first_index += mesh_draw_data.indices;
 			base_instance += entity_count;
-			++command_buffer_index;
 
 			const int material_index = mesh_draw_data.material;
 			for (const auto& entity : entities)
 			{
-				auto index = entity_index_map.find(entity->entity_ID);
+				auto index = entity_index_map.find(entity.index);
 				LOG_ASSERT(index != entity_index_map.end()
 					&& "Our entity ID is missing");
-				const auto id = index->second;
-				draw_elements[draw_element_index * DRAW_ELEMENT_SIZE] =
-					id;
-				draw_elements[draw_element_index * DRAW_ELEMENT_SIZE + 1] =
-					material_index;
-
-				++draw_element_index;
+				static_draw_elements.push_back(index->second);
+				static_draw_elements.push_back(material_index);
 			}
 		}
 	}
 	LOG_ASSERT(mesh_count <= UINT_MAX
 		&& "We have too more static models than fit in an unsigned int");
-
-	data_size_in_bytes = mesh_count * COMMAND_SIZE * sizeof(int);
-
-	command_buffers.static_draw_count = static_cast<unsigned int>(mesh_count);
-
-	glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
-		command_buffers.static_command_buffer);
-	glBufferData(GL_DRAW_INDIRECT_BUFFER, data_size_in_bytes, command_buffer,
-		GL_STATIC_DRAW);
-	safe_delete_array(command_buffer);
-
-	data_size_in_bytes = draw_element_count * DRAW_ELEMENT_SIZE * sizeof(int);
-
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER,
-		command_buffers.static_draw_element_buffer);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, data_size_in_bytes, draw_elements,
-		GL_STATIC_DRAW);
-	safe_delete_array(draw_elements);
-}
-
-void Render::update_model_buffer(
-	const std::vector<std::shared_ptr<Model>> models, GLuint buffer_id)
-{
-	size_t entity_count = 0;
-	for (const auto& model : models)
-	{
-		entity_count += model->entity_list.size();
-	}
-
-	float* model_matrices = ALLOC float[entity_count * 16];
-
-	int entity_index = 0;
-	for (const auto& model : models)
-	{
-		for (const auto& entity : model->entity_list)
-		{
-			const float* matrix = static_cast<const float*>(
-				glm::value_ptr(entity->model_matrix));
-			for (size_t i = 0; i < 16; ++i)
-			{
-				model_matrices[static_cast<size_t>(entity_index) * 16 + i]
-					= matrix[i];
-			}
-			++entity_index;
-		}
-	}
-	size_t data_size_in_bytes = entity_count * 16 * sizeof(float);
-
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_id);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, data_size_in_bytes,
-		model_matrices, GL_DYNAMIC_DRAW);
-
-	safe_delete_array(model_matrices);
 }
 
 void Render::update_model_matrices(const Scene& scene)
 {
-	ModelList animated_models = scene.get_animated_model_list();
-	ModelList static_models = scene.get_static_model_list();
-
-	GLuint animated_buffer = command_buffers.animated_model_matrices_buffer;
-	GLuint static_buffer = command_buffers.static_model_matrices_buffer;
-
-	update_model_buffer(animated_models, animated_buffer);
-	update_model_buffer(static_models, static_buffer);
+	command_buffers.animated_model_matrices.update(
+		scene.get_animated_model_list());
+	command_buffers.static_model_matrices.update(
+		scene.get_static_model_list());
 }
 
 #endif
@@ -8,6 +8,7 @@
 #include "graphics/backend/opengl/command_buffers.h"
 #include "graphics/backend/opengl/render_buffers.h"
 #include "graphics/graph/shadow_buffer.h"
+#include "graphics/scene/frustum.h"
 #include "main/game_logic.h"
 #include "resource_cache/resource_cache.h"
 
@@ -16,6 +17,14 @@
 ShadowRender::ShadowRender()
     : shadow_buffer{}
     , cascade_shadows{}
+    , static_command_buffers{}
+    , static_draw_element_buffers{}
+    , static_draw_counts{}
+    , animated_command_buffers{}
+    , animated_draw_element_buffers{}
+    , animated_draw_counts{}
+    , visible_commands{}
+    , visible_draw_elements{}
 {
     Resource vert("shaders/shadow.vert");
     std::shared_ptr<ResourceHandle> vert_handle =
@@ -29,14 +38,51 @@ ShadowRender::ShadowRender()
 
     uniforms_map = std::make_unique<UniformsMap>(shader_program->program_id);
     uniforms_map->create_uniform("projection_view_matrix");
+
+    glGenBuffers(SHADOW_MAP_CASCADE_COUNT, static_command_buffers.data());
+    glGenBuffers(SHADOW_MAP_CASCADE_COUNT,
+        static_draw_element_buffers.data());
+    glGenBuffers(SHADOW_MAP_CASCADE_COUNT, animated_command_buffers.data());
+    glGenBuffers(SHADOW_MAP_CASCADE_COUNT,
+        animated_draw_element_buffers.data());
+}
+
+ShadowRender::~ShadowRender()
+{
+    glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT, static_command_buffers.data());
+    glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT,
+        static_draw_element_buffers.data());
+    glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT,
+        animated_command_buffers.data());
+    glDeleteBuffers(SHADOW_MAP_CASCADE_COUNT,
+        animated_draw_element_buffers.data());
 }
 
 void ShadowRender::render(const Scene& scene,
     const RenderBuffers& render_buffers,
-    const CommandBuffers& command_buffers)
+    const CommandBuffers& command_buffers, DrawCuller& static_culler,
+    DrawCuller& animated_culler)
 {
     CascadeShadowSlice::updateCascadeShadows(cascade_shadows, scene);
 
+    // Anything outside a cascade's volume would be clipped when drawing its
+    // shadow map anyway, so it can be skipped for that cascade
+    for (unsigned int i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+    {
+        const Frustum frustum(cascade_shadows[i].projection_view_matrix);
+
+        static_culler.cull(frustum, visible_commands, visible_draw_elements);
+        static_draw_counts[i] = upload_draw_commands(
+            static_command_buffers[i], static_draw_element_buffers[i],
+            visible_commands, visible_draw_elements);
+
+        animated_culler.cull(frustum, visible_commands,
+            visible_draw_elements);
+        animated_draw_counts[i] = upload_draw_commands(
+            animated_command_buffers[i], animated_draw_element_buffers[i],
+            visible_commands, visible_draw_elements);
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, shadow_buffer.depth_map_fbo);
     glViewport(0, 0, SHADOW_MAP_WIDTH, SHADOW_MAP_HEIGHT);
 
@@ -50,41 +96,45 @@ void ShadowRender::render(const Scene& scene,
     }
 
     //NOTE(ches) static meshes
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
-        command_buffers.static_draw_element_buffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MATRICES_BINDING,
-        command_buffers.static_model_matrices_buffer);
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
-        command_buffers.static_command_buffer);
+    command_buffers.static_model_matrices.bind(MODEL_MATRICES_BINDING);
     glBindVertexArray(render_buffers.static_vao);
     for (unsigned int i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
     {
+        if (static_draw_counts[i] == 0)
+        {
+            continue;
+        }
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
             GL_TEXTURE_2D, shadow_buffer.depth_map[i], 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
+            static_draw_element_buffers[i]);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, static_command_buffers[i]);
 
         uniforms_map->set_uniform("projection_view_matrix",
             cascade_shadows[i].projection_view_matrix);
         glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
-            command_buffers.static_draw_count, 0);
+            static_draw_counts[i], 0);
     }
 
     //NOTE(ches) animated meshes
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
-        command_buffers.animated_draw_element_buffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MATRICES_BINDING,
-        command_buffers.animated_model_matrices_buffer);
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
-        command_buffers.animated_command_buffer);
+    command_buffers.animated_model_matrices.bind(MODEL_MATRICES_BINDING);
     glBindVertexArray(render_buffers.animated_vao);
     for (unsigned int i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
     {
+        if (animated_draw_counts[i] == 0)
+        {
+            continue;
+        }
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
             GL_TEXTURE_2D, shadow_buffer.depth_map[i], 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ELEMENT_BINDING,
+            animated_draw_element_buffers[i]);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, animated_command_buffers[i]);
 
         uniforms_map->set_uniform("projection_view_matrix",
             cascade_shadows[i].projection_view_matrix);
         glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
-            command_buffers.animated_draw_count, 0);
+            animated_draw_counts[i], 0);
     }
 
     glBindVertexArray(0);
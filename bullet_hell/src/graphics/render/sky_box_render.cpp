@@ -10,6 +10,7 @@
 #include "graphics/graph/material.h"
 #include "graphics/graph/mesh_data.h"
 #include "graphics/graph/texture_resource.h"
+#include "graphics/scene/entity_view.h"
 #include "graphics/scene/scene.h"
 #include "main/game_logic.h"
 #include "resource_cache/resource_cache.h"
@@ -71,7 +72,8 @@ void SkyBoxRender::render(const Scene& scene)
 
     glBindVertexArray(sky_box.vao);
 
-    uniforms_map->set_uniform("model_matrix", sky_box.entity->model_matrix);
+    uniforms_map->set_uniform("model_matrix",
+        g_entity_view->model_matrix(sky_box.entity));
     glDrawElements(GL_TRIANGLES, sky_box.index_count, GL_UNSIGNED_INT,
         nullptr);
 
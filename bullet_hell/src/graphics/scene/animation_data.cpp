@@ -33,7 +33,8 @@ void AnimationData::next_frame()
 	}
 }
 
-void AnimationData::run_immediate_once(std::shared_ptr<Animation> animation)
+void AnimationData::run_immediate_once(
+	const std::shared_ptr<Animation>& animation)
 {
 	LOG_ASSERT(animation);
 	if (animation == current_animation)
@@ -48,8 +49,16 @@ void AnimationData::run_immediate_once(std::shared_ptr<Animation> animation)
 	current_frame_index = 0;
 }
 
+void AnimationData::reset(const std::shared_ptr<Animation>& animation)
+{
+	LOG_ASSERT(animation);
+	current_animation = animation;
+	interrupted_animation = nullptr;
+	current_frame_index = 0;
+}
+
 void AnimationData::set_current_animation(
-	std::shared_ptr<Animation> animation)
+	const std::shared_ptr<Animation>& animation)
 {
 	LOG_ASSERT(animation);
 	if (interrupted_animation == nullptr && animation != current_animation)
@@ -0,0 +1,105 @@
+#include "graphics/scene/chunk_mesh_builder.h"
+
+#include <limits>
+#include <utility>
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/mat3x3.hpp"
+#include "glm/matrix.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
+#include "debugging/logger.h"
+
+/// <summary>
+/// Transform a direction stored in a vertex, and write it back normalized.
+/// </summary>
+/// <param name="transform">The transform for directions.</param>
+/// <param name="direction">The x, y, and z components of the direction.
+/// </param>
+static void transform_direction(const glm::mat3& transform, float* direction)
+{
+	const glm::vec3 original{ direction[0], direction[1], direction[2] };
+	const glm::vec3 moved = transform * original;
+	const float length = glm::length(moved);
+	if (length == 0.0f)
+	{
+		return;
+	}
+	const glm::vec3 result = moved / length;
+	direction[0] = result.x;
+	direction[1] = result.y;
+	direction[2] = result.z;
+}
+
+ChunkMeshBuilder::ChunkMeshBuilder()
+	: meshes{}
+	, mesh_indices{}
+{}
+
+void ChunkMeshBuilder::add(const Model& model, const glm::mat4& transform)
+{
+	LOG_ASSERT(model.animation_list.empty()
+		&& "Animated models can't be baked into a chunk");
+
+	// Normals need the inverse transpose to stay perpendicular to surfaces
+	// under scaling, while tangents lie along them
+	const glm::mat3 tangent_transform{ transform };
+	const glm::mat3 normal_transform =
+		glm::transpose(glm::inverse(tangent_transform));
+
+	for (const MeshData& source : model.mesh_data_list)
+	{
+		auto existing = mesh_indices.find(*source.material);
+		if (existing == mesh_indices.end())
+		{
+			existing =
+				mesh_indices.emplace(*source.material, meshes.size()).first;
+			MeshData& created = meshes.emplace_back();
+			created.material = source.material;
+			created.aabb_min = glm::vec3(std::numeric_limits<float>::max());
+			created.aabb_max = glm::vec3(std::numeric_limits<float>::lowest());
+		}
+		MeshData& mesh = meshes[existing->second];
+
+		const uint32_t first_vertex =
+			static_cast<uint32_t>(mesh.vertices.size());
+		for (const uint32_t index : source.indices)
+		{
+			mesh.indices.push_back(first_vertex + index);
+		}
+
+		for (const MeshVertex& vertex : source.vertices)
+		{
+			MeshVertex moved = vertex;
+			const glm::vec3 position{ transform * glm::vec4(vertex.position[0],
+				vertex.position[1], vertex.position[2], 1.0f) };
+			moved.position[0] = position.x;
+			moved.position[1] = position.y;
+			moved.position[2] = position.z;
+			transform_direction(normal_transform, moved.normal);
+			transform_direction(tangent_transform, moved.tangent);
+			transform_direction(tangent_transform, moved.bitangent);
+			mesh.vertices.push_back(moved);
+
+			mesh.aabb_min = glm::min(mesh.aabb_min, position);
+			mesh.aabb_max = glm::max(mesh.aabb_max, position);
+		}
+	}
+}
+
+[[nodiscard]] bool ChunkMeshBuilder::empty() const noexcept
+{
+	return meshes.empty();
+}
+
+[[nodiscard]] std::shared_ptr<Model> ChunkMeshBuilder::build(
+	const std::string& id)
+{
+	std::shared_ptr<Model> model = std::make_shared<Model>(id);
+	model->mesh_data_list = std::move(meshes);
+	meshes.clear();
+	mesh_indices.clear();
+	return model;
+}
@@ -0,0 +1,265 @@
+#include "graphics/scene/entity_registry.h"
+
+#include <cstring>
+
+#include "glm/gtx/quaternion.hpp"
+
+#include "debugging/logger.h"
+#include "graphics/scene/model_matrix_kernel.h"
+
+EntityRegistry* g_entity_registry = nullptr;
+
+EntityRegistry::EntityRegistry()
+	: slot_generation{}
+	, slot_dense_index{}
+	, free_slots{}
+	, dense_slot{}
+	, positions{}
+	, rotations{}
+	, scales{}
+	, model_matrices{}
+	, matrix_dirty{}
+	, animations{}
+	, model_indices{}
+	, model_IDs{}
+	, model_ID_indices{}
+	, model_lost_entities{}
+	, models_losing_entities{}
+	, dirty_indices{}
+	, total_created{ 0 }
+{}
+
+[[nodiscard]] bool EntityRegistry::alive(const EntityHandle entity)
+	const noexcept
+{
+	return entity.index < slot_generation.size()
+		&& slot_generation[entity.index] == entity.generation;
+}
+
+EntityHandle EntityRegistry::create(const std::string& model_ID)
+{
+	uint32_t slot;
+	if (!free_slots.empty())
+	{
+		slot = free_slots.back();
+		free_slots.pop_back();
+	}
+	else
+	{
+		LOG_ASSERT(slot_generation.size() < EntityHandle::INVALID_INDEX
+			&& "Too many entities for the handle index");
+		slot = static_cast<uint32_t>(slot_generation.size());
+		slot_generation.push_back(0);
+		slot_dense_index.push_back(0);
+	}
+
+	auto model = model_ID_indices.find(model_ID);
+	if (model == model_ID_indices.end())
+	{
+		const uint32_t new_index = static_cast<uint32_t>(model_IDs.size());
+		model_IDs.push_back(model_ID);
+		model_lost_entities.push_back(0);
+		model = model_ID_indices.emplace(model_ID, new_index).first;
+	}
+
+	slot_dense_index[slot] = static_cast<uint32_t>(dense_slot.size());
+	dense_slot.push_back(slot);
+	positions.emplace_back(0.0f);
+	rotations.emplace_back();
+	scales.push_back(1.0f);
+	model_matrices.emplace_back(1.0f);
+	matrix_dirty.push_back(1);
+	animations.emplace_back(std::shared_ptr<Animation>());
+	model_indices.push_back(model->second);
+	++total_created;
+
+	return EntityHandle{ slot, slot_generation[slot] };
+}
+
+void EntityRegistry::destroy(const EntityHandle entity)
+{
+	if (!alive(entity))
+	{
+		return;
+	}
+
+	// Keep the arrays packed by moving the last entity into the gap
+	const uint32_t index = slot_dense_index[entity.index];
+	const uint32_t model_index = model_indices[index];
+	if (!model_lost_entities[model_index])
+	{
+		model_lost_entities[model_index] = 1;
+		models_losing_entities.push_back(model_index);
+	}
+
+	const uint32_t last = static_cast<uint32_t>(dense_slot.size() - 1);
+	if (index != last)
+	{
+		dense_slot[index] = dense_slot[last];
+		positions[index] = positions[last];
+		rotations[index] = rotations[last];
+		scales[index] = scales[last];
+		model_matrices[index] = model_matrices[last];
+		matrix_dirty[index] = matrix_dirty[last];
+		animations[index] = std::move(animations[last]);
+		model_indices[index] = model_indices[last];
+		slot_dense_index[dense_slot[index]] = index;
+	}
+	dense_slot.pop_back();
+	positions.pop_back();
+	rotations.pop_back();
+	scales.pop_back();
+	model_matrices.pop_back();
+	matrix_dirty.pop_back();
+	animations.pop_back();
+	model_indices.pop_back();
+
+	++slot_generation[entity.index];
+	free_slots.push_back(entity.index);
+}
+
+[[nodiscard]] uint64_t EntityRegistry::created_count() const noexcept
+{
+	return total_created;
+}
+
+[[nodiscard]] const std::string& EntityRegistry::model_ID_at(
+	const uint32_t model_index) const
+{
+	LOG_ASSERT(model_index < model_IDs.size() && "Unknown model index");
+	return model_IDs[model_index];
+}
+
+[[nodiscard]] size_t EntityRegistry::size() const noexcept
+{
+	return dense_slot.size();
+}
+
+void EntityRegistry::take_models_losing_entities(
+	std::vector<uint32_t>& model_indices)
+{
+	for (const uint32_t model_index : models_losing_entities)
+	{
+		model_lost_entities[model_index] = 0;
+	}
+	model_indices.insert(model_indices.end(), models_losing_entities.begin(),
+		models_losing_entities.end());
+	models_losing_entities.clear();
+}
+
+[[nodiscard]] AnimationData& EntityRegistry::animation_data(
+	const EntityHandle entity)
+{
+	return animations[dense_index(entity)];
+}
+
+[[nodiscard]] glm::mat4& EntityRegistry::model_matrix(
+	const EntityHandle entity)
+{
+	return model_matrices[dense_index(entity)];
+}
+
+[[nodiscard]] const std::string& EntityRegistry::model_ID(
+	const EntityHandle entity) const
+{
+	return model_IDs[model_indices[dense_index(entity)]];
+}
+
+[[nodiscard]] uint32_t EntityRegistry::model_index(
+	const EntityHandle entity) const
+{
+	return model_indices[dense_index(entity)];
+}
+
+[[nodiscard]] glm::vec3& EntityRegistry::position(const EntityHandle entity)
+{
+	return positions[dense_index(entity)];
+}
+
+[[nodiscard]] glm::quat& EntityRegistry::rotation(const EntityHandle entity)
+{
+	return rotations[dense_index(entity)];
+}
+
+[[nodiscard]] float& EntityRegistry::scale(const EntityHandle entity)
+{
+	return scales[dense_index(entity)];
+}
+
+void EntityRegistry::add_rotation(const EntityHandle entity, const float x,
+	const float y, const float z, const float angle)
+{
+	glm::quat delta = glm::angleAxis(glm::radians(angle),
+		glm::normalize(glm::vec3(x, y, z)));
+	glm::quat& current = rotation(entity);
+	current = delta * current;
+	mark_dirty(entity);
+}
+
+void EntityRegistry::set_position(const EntityHandle entity, const float x,
+	const float y, const float z)
+{
+	glm::vec3& current = position(entity);
+	current.x = x;
+	current.y = y;
+	current.z = z;
+	mark_dirty(entity);
+}
+
+void EntityRegistry::set_rotation(const EntityHandle entity, const float x,
+	const float y, const float z, const float angle)
+{
+	rotation(entity) = glm::angleAxis(glm::radians(angle),
+		glm::normalize(glm::vec3(x, y, z)));
+	mark_dirty(entity);
+}
+
+void EntityRegistry::mark_dirty(const EntityHandle entity)
+{
+	matrix_dirty[dense_index(entity)] = 1;
+}
+
+void EntityRegistry::update_model_matrices()
+{
+	// Most entities are static, so skip over clean ones 8 at a time
+	dirty_indices.clear();
+	const size_t count = matrix_dirty.size();
+	uint8_t* dirty = matrix_dirty.data();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		uint64_t flags;
+		std::memcpy(&flags, dirty + i, sizeof(flags));
+		if (flags == 0)
+		{
+			continue;
+		}
+		for (size_t j = i; j < i + 8; ++j)
+		{
+			if (dirty[j] != 0)
+			{
+				dirty_indices.push_back(static_cast<uint32_t>(j));
+			}
+		}
+		std::memset(dirty + i, 0, 8);
+	}
+	for (; i < count; ++i)
+	{
+		if (dirty[i] != 0)
+		{
+			dirty_indices.push_back(static_cast<uint32_t>(i));
+			dirty[i] = 0;
+		}
+	}
+
+	ModelMatrixKernel::build(dirty_indices.data(), dirty_indices.size(),
+		positions.data(), rotations.data(), scales.data(),
+		model_matrices.data());
+}
+
+[[nodiscard]] uint32_t EntityRegistry::dense_index(const EntityHandle entity)
+	const
+{
+	LOG_ASSERT(alive(entity) && "Using an entity that has been destroyed");
+	return slot_dense_index[entity.index];
+}
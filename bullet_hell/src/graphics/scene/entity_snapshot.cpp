@@ -0,0 +1,40 @@
+#include "graphics/scene/entity_snapshot.h"
+
+#include "graphics/scene/entity_registry.h"
+
+void EntitySnapshot::capture(const EntityRegistry& registry)
+{
+	slot_generation = registry.slot_generation;
+	slot_dense_index = registry.slot_dense_index;
+	dense_slot = registry.dense_slot;
+	positions = registry.positions;
+	rotations = registry.rotations;
+	scales = registry.scales;
+	model_matrices = registry.model_matrices;
+
+	const size_t count = registry.animations.size();
+	animations.resize(count);
+	animation_frames.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const AnimationData& animation_data = registry.animations[i];
+		animations[i] = animation_data.current_animation.get();
+		animation_frames[i] = animation_data.current_frame_index;
+	}
+}
+
+[[nodiscard]] uint32_t EntitySnapshot::find(const EntityHandle entity)
+	const noexcept
+{
+	if (entity.index >= slot_generation.size()
+		|| slot_generation[entity.index] != entity.generation)
+	{
+		return NOT_FOUND;
+	}
+	return slot_dense_index[entity.index];
+}
+
+[[nodiscard]] size_t EntitySnapshot::size() const noexcept
+{
+	return dense_slot.size();
+}
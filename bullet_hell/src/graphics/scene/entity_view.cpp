@@ -0,0 +1,195 @@
+#include "graphics/scene/entity_view.h"
+
+#include "glm/gtc/quaternion.hpp"
+
+#include "graphics/graph/animation.h"
+#include "graphics/scene/model_matrix_kernel.h"
+
+EntityView* g_entity_view = nullptr;
+
+/// <summary>
+/// Given to entities that are not in the view, so they are not drawn.
+/// </summary>
+static const glm::mat4 HIDDEN_MODEL_MATRIX(0.0f);
+
+/// <summary>
+/// Blend between two rotations. Over the span of one tick rotations barely
+/// change, so a normalized linear blend is indistinguishable from slerp and
+/// much cheaper.
+/// </summary>
+/// <param name="from">The rotation at an alpha of 0.</param>
+/// <param name="to">The rotation at an alpha of 1.</param>
+/// <param name="alpha">How far to blend, from 0 to 1.</param>
+/// <returns>The blended rotation.</returns>
+static glm::quat blend_rotation(const glm::quat& from, const glm::quat& to,
+	const float alpha)
+{
+	// Quaternions q and -q are the same rotation, so take the short way
+	const glm::quat target = glm::dot(from, to) < 0 ? -to : to;
+	return glm::normalize(from * (1.0f - alpha) + target * alpha);
+}
+
+EntityView::EntityView()
+	: previous{}
+	, latest{}
+	, blended{}
+	, positions{}
+	, rotations{}
+	, scales{}
+	, model_matrices{}
+	, moved_indices{}
+{}
+
+void EntityView::update(std::shared_ptr<const EntitySnapshot> previous,
+	std::shared_ptr<const EntitySnapshot> latest, const float alpha)
+{
+	this->previous = std::move(previous);
+	this->latest = std::move(latest);
+
+	moved_indices.clear();
+	if (!this->latest)
+	{
+		blended.clear();
+		return;
+	}
+
+	const EntitySnapshot& to = *this->latest;
+	const size_t count = to.size();
+	blended.assign(count, 0);
+	positions.resize(count);
+	rotations.resize(count);
+	scales.resize(count);
+	model_matrices.resize(count);
+
+	if (!this->previous || this->previous == this->latest)
+	{
+		return;
+	}
+
+	const EntitySnapshot& from = *this->previous;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const uint32_t slot = to.dense_slot[i];
+		const uint32_t old_index = from.find(
+			EntityHandle{ slot, to.slot_generation[slot] });
+		if (old_index == EntitySnapshot::NOT_FOUND)
+		{
+			// Spawned this tick, so there is nothing to blend from
+			continue;
+		}
+
+		const glm::vec3& old_position = from.positions[old_index];
+		const glm::quat& old_rotation = from.rotations[old_index];
+		const float old_scale = from.scales[old_index];
+		if (old_position == to.positions[i]
+			&& old_rotation == to.rotations[i]
+			&& old_scale == to.scales[i])
+		{
+			continue;
+		}
+
+		positions[i] = old_position
+			+ (to.positions[i] - old_position) * alpha;
+		rotations[i] = blend_rotation(old_rotation, to.rotations[i], alpha);
+		scales[i] = old_scale + (to.scales[i] - old_scale) * alpha;
+		blended[i] = 1;
+		moved_indices.push_back(i);
+	}
+
+	ModelMatrixKernel::build(moved_indices.data(), moved_indices.size(),
+		positions.data(), rotations.data(), scales.data(),
+		model_matrices.data());
+}
+
+[[nodiscard]] bool EntityView::contains(const EntityHandle entity)
+	const noexcept
+{
+	return latest && latest->find(entity) != EntitySnapshot::NOT_FOUND;
+}
+
+[[nodiscard]] const Animation* EntityView::animation(
+	const EntityHandle entity) const noexcept
+{
+	if (!latest)
+	{
+		return nullptr;
+	}
+	const uint32_t index = latest->find(entity);
+	if (index == EntitySnapshot::NOT_FOUND)
+	{
+		return nullptr;
+	}
+	return latest->animations[index];
+}
+
+[[nodiscard]] const AnimatedFrame* EntityView::animation_frame(
+	const EntityHandle entity) const noexcept
+{
+	const Animation* current_animation = animation(entity);
+	if (current_animation == nullptr)
+	{
+		return nullptr;
+	}
+	return &current_animation->frames[animation_frame_index(entity)];
+}
+
+[[nodiscard]] int EntityView::animation_frame_index(
+	const EntityHandle entity) const noexcept
+{
+	if (!latest)
+	{
+		return 0;
+	}
+	const uint32_t index = latest->find(entity);
+	if (index == EntitySnapshot::NOT_FOUND)
+	{
+		return 0;
+	}
+	return latest->animation_frames[index];
+}
+
+[[nodiscard]] const glm::mat4& EntityView::model_matrix(
+	const EntityHandle entity) const noexcept
+{
+	if (!latest)
+	{
+		return HIDDEN_MODEL_MATRIX;
+	}
+	const uint32_t index = latest->find(entity);
+	if (index == EntitySnapshot::NOT_FOUND)
+	{
+		return HIDDEN_MODEL_MATRIX;
+	}
+	return blended[index] ? model_matrices[index]
+		: latest->model_matrices[index];
+}
+
+[[nodiscard]] glm::vec3 EntityView::position(const EntityHandle entity)
+	const noexcept
+{
+	if (!latest)
+	{
+		return glm::vec3(0.0f);
+	}
+	const uint32_t index = latest->find(entity);
+	if (index == EntitySnapshot::NOT_FOUND)
+	{
+		return glm::vec3(0.0f);
+	}
+	return blended[index] ? positions[index] : latest->positions[index];
+}
+
+[[nodiscard]] glm::quat EntityView::rotation(const EntityHandle entity)
+	const noexcept
+{
+	if (!latest)
+	{
+		return glm::quat();
+	}
+	const uint32_t index = latest->find(entity);
+	if (index == EntitySnapshot::NOT_FOUND)
+	{
+		return glm::quat();
+	}
+	return blended[index] ? rotations[index] : latest->rotations[index];
+}
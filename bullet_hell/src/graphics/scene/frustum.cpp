@@ -0,0 +1,135 @@
+#include "graphics/scene/frustum.h"
+
+#include "glm/geometric.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) \
+	|| defined(__i386__)
+#define FRUSTUM_SSE2 1
+#include <emmintrin.h>
+#else
+#define FRUSTUM_SSE2 0
+#endif
+
+Frustum::Frustum()
+{
+	// Every point is a positive distance inside planes like this
+	planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+Frustum::Frustum(const glm::mat4& view_projection)
+{
+	//NOTE(ches) Gribb and Hartmann, a point is visible when each clip space
+	// coordinate is within -w to w, so the planes fall out of the rows
+	const glm::vec4 row_x{ view_projection[0][0], view_projection[1][0],
+		view_projection[2][0], view_projection[3][0] };
+	const glm::vec4 row_y{ view_projection[0][1], view_projection[1][1],
+		view_projection[2][1], view_projection[3][1] };
+	const glm::vec4 row_z{ view_projection[0][2], view_projection[1][2],
+		view_projection[2][2], view_projection[3][2] };
+	const glm::vec4 row_w{ view_projection[0][3], view_projection[1][3],
+		view_projection[2][3], view_projection[3][3] };
+
+	planes[0] = row_w + row_x;
+	planes[1] = row_w - row_x;
+	planes[2] = row_w + row_y;
+	planes[3] = row_w - row_y;
+	planes[4] = row_w + row_z;
+	planes[5] = row_w - row_z;
+
+	// Normalize so that distances are in world units
+	for (glm::vec4& plane : planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+[[nodiscard]] const std::array<glm::vec4, 6>& Frustum::get_planes()
+	const noexcept
+{
+	return planes;
+}
+
+[[nodiscard]] bool Frustum::intersects_sphere(const glm::vec3& center,
+	const float radius) const noexcept
+{
+	for (const glm::vec4& plane : planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+[[nodiscard]] bool Frustum::intersects_box(const glm::vec3& min,
+	const glm::vec3& max) const noexcept
+{
+	for (const glm::vec4& plane : planes)
+	{
+		// If the corner furthest along the normal is outside, they all are
+		const glm::vec3 corner{
+			plane.x >= 0.0f ? max.x : min.x,
+			plane.y >= 0.0f ? max.y : min.y,
+			plane.z >= 0.0f ? max.z : min.z
+		};
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void Frustum::intersects_spheres(const float* x, const float* y,
+	const float* z, const float* radius, const size_t count,
+	uint8_t* visible) const noexcept
+{
+	size_t i = 0;
+#if FRUSTUM_SSE2
+	__m128 normal_x[6];
+	__m128 normal_y[6];
+	__m128 normal_z[6];
+	__m128 distance[6];
+	for (size_t p = 0; p < planes.size(); ++p)
+	{
+		normal_x[p] = _mm_set1_ps(planes[p].x);
+		normal_y[p] = _mm_set1_ps(planes[p].y);
+		normal_z[p] = _mm_set1_ps(planes[p].z);
+		distance[p] = _mm_set1_ps(planes[p].w);
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(x + i);
+		const __m128 cy = _mm_loadu_ps(y + i);
+		const __m128 cz = _mm_loadu_ps(z + i);
+		const __m128 negative_radius = _mm_sub_ps(zero,
+			_mm_loadu_ps(radius + i));
+
+		// Summed in the same order as glm::dot, so that the answers match
+		// the scalar test exactly
+		__m128 outside = zero;
+		for (size_t p = 0; p < planes.size(); ++p)
+		{
+			const __m128 along = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(normal_x[p], cx), _mm_mul_ps(normal_y[p], cy)),
+				_mm_mul_ps(normal_z[p], cz)), distance[p]);
+			outside = _mm_or_ps(outside,
+				_mm_cmplt_ps(along, negative_radius));
+		}
+
+		const int mask = _mm_movemask_ps(outside);
+		visible[i + 0] = (mask & 1) == 0;
+		visible[i + 1] = (mask & 2) == 0;
+		visible[i + 2] = (mask & 4) == 0;
+		visible[i + 3] = (mask & 8) == 0;
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		visible[i] = intersects_sphere(glm::vec3(x[i], y[i], z[i]),
+			radius[i]);
+	}
+}
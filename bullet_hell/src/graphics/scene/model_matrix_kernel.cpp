@@ -0,0 +1,164 @@
+#include "graphics/scene/model_matrix_kernel.h"
+
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) \
+	|| defined(__i386__)
+#define MODEL_MATRIX_KERNEL_SSE2 1
+#include <emmintrin.h>
+#else
+#define MODEL_MATRIX_KERNEL_SSE2 0
+#endif
+
+namespace ModelMatrixKernel
+{
+	/// <summary>
+	/// Build a model matrix equivalent to translate * toMat4(rotation) * scale,
+	/// writing each element directly rather than multiplying full matrices
+	/// together.
+	/// </summary>
+	/// <param name="position">The translation.</param>
+	/// <param name="rotation">The rotation, which must be normalized.</param>
+	/// <param name="scale">The uniform scale factor.</param>
+	/// <param name="result">Where to write the matrix.</param>
+	static inline void build_model_matrix(const glm::vec3& position,
+		const glm::quat& rotation, const float scale,
+		glm::mat4& result) noexcept
+	{
+		// Same terms, in the same order, as glm::mat3_cast so the results match
+		const float xx = rotation.x * rotation.x;
+		const float yy = rotation.y * rotation.y;
+		const float zz = rotation.z * rotation.z;
+		const float xz = rotation.x * rotation.z;
+		const float xy = rotation.x * rotation.y;
+		const float yz = rotation.y * rotation.z;
+		const float wx = rotation.w * rotation.x;
+		const float wy = rotation.w * rotation.y;
+		const float wz = rotation.w * rotation.z;
+
+		result[0][0] = (1.0f - 2.0f * (yy + zz)) * scale;
+		result[0][1] = (2.0f * (xy + wz)) * scale;
+		result[0][2] = (2.0f * (xz - wy)) * scale;
+		result[0][3] = 0.0f;
+
+		result[1][0] = (2.0f * (xy - wz)) * scale;
+		result[1][1] = (1.0f - 2.0f * (xx + zz)) * scale;
+		result[1][2] = (2.0f * (yz + wx)) * scale;
+		result[1][3] = 0.0f;
+
+		result[2][0] = (2.0f * (xz + wy)) * scale;
+		result[2][1] = (2.0f * (yz - wx)) * scale;
+		result[2][2] = (1.0f - 2.0f * (xx + yy)) * scale;
+		result[2][3] = 0.0f;
+
+		result[3][0] = position.x;
+		result[3][1] = position.y;
+		result[3][2] = position.z;
+		result[3][3] = 1.0f;
+	}
+
+#if MODEL_MATRIX_KERNEL_SSE2
+
+	static_assert(offsetof(glm::quat, x) == 0
+		&& offsetof(glm::quat, w) == 3 * sizeof(float),
+		"Quaternions are loaded as x, y, z, w");
+	static_assert(sizeof(glm::mat4) == 16 * sizeof(float),
+		"Matrices are stored as 4 packed columns");
+
+	/// <summary>
+	/// Build 4 model matrices at once, with each lane of the registers
+	/// working on a different entry. Gives the same results as
+	/// build_model_matrix. The entries are picked by the first 4 indices.
+	/// </summary>
+	static inline void build_4_model_matrices_sse2(const uint32_t* indices,
+		const glm::vec3* positions, const glm::quat* rotations,
+		const float* scales, glm::mat4* model_matrices) noexcept
+	{
+		// Each load is one whole quaternion, so transposing leaves one
+		// component of all 4 in each register
+		__m128 x = _mm_loadu_ps(&rotations[indices[0]].x);
+		__m128 y = _mm_loadu_ps(&rotations[indices[1]].x);
+		__m128 z = _mm_loadu_ps(&rotations[indices[2]].x);
+		__m128 w = _mm_loadu_ps(&rotations[indices[3]].x);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		const __m128 scale = _mm_set_ps(scales[indices[3]], scales[indices[2]],
+			scales[indices[1]], scales[indices[0]]);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+
+		const __m128 xx = _mm_mul_ps(x, x);
+		const __m128 yy = _mm_mul_ps(y, y);
+		const __m128 zz = _mm_mul_ps(z, z);
+		const __m128 xz = _mm_mul_ps(x, z);
+		const __m128 xy = _mm_mul_ps(x, y);
+		const __m128 yz = _mm_mul_ps(y, z);
+		const __m128 wx = _mm_mul_ps(w, x);
+		const __m128 wy = _mm_mul_ps(w, y);
+		const __m128 wz = _mm_mul_ps(w, z);
+
+		// Rows of the rotation part, one entity per lane
+		__m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+		__m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+		__m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+		__m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+		__m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+		__m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+		__m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+		__m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+		__m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+		r00 = _mm_mul_ps(r00, scale);
+		r01 = _mm_mul_ps(r01, scale);
+		r02 = _mm_mul_ps(r02, scale);
+		r10 = _mm_mul_ps(r10, scale);
+		r11 = _mm_mul_ps(r11, scale);
+		r12 = _mm_mul_ps(r12, scale);
+		r20 = _mm_mul_ps(r20, scale);
+		r21 = _mm_mul_ps(r21, scale);
+		r22 = _mm_mul_ps(r22, scale);
+
+		// Transposing back gives one column of each matrix per register
+		__m128 zero_0 = _mm_setzero_ps();
+		__m128 zero_1 = _mm_setzero_ps();
+		__m128 zero_2 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(r00, r01, r02, zero_0);
+		_MM_TRANSPOSE4_PS(r10, r11, r12, zero_1);
+		_MM_TRANSPOSE4_PS(r20, r21, r22, zero_2);
+
+		const __m128 column_0[4] = { r00, r01, r02, zero_0 };
+		const __m128 column_1[4] = { r10, r11, r12, zero_1 };
+		const __m128 column_2[4] = { r20, r21, r22, zero_2 };
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			glm::mat4& result = model_matrices[indices[lane]];
+			const glm::vec3& position = positions[indices[lane]];
+			_mm_storeu_ps(&result[0][0], column_0[lane]);
+			_mm_storeu_ps(&result[1][0], column_1[lane]);
+			_mm_storeu_ps(&result[2][0], column_2[lane]);
+			_mm_storeu_ps(&result[3][0],
+				_mm_set_ps(1.0f, position.z, position.y, position.x));
+		}
+	}
+
+#endif // MODEL_MATRIX_KERNEL_SSE2
+
+	void build(const uint32_t* indices, const size_t count,
+		const glm::vec3* positions, const glm::quat* rotations,
+		const float* scales, glm::mat4* model_matrices) noexcept
+	{
+		size_t built = 0;
+#if MODEL_MATRIX_KERNEL_SSE2
+		for (; built + 4 <= count; built += 4)
+		{
+			build_4_model_matrices_sse2(indices + built, positions, rotations,
+				scales, model_matrices);
+		}
+#endif
+		for (; built < count; ++built)
+		{
+			const uint32_t index = indices[built];
+			build_model_matrix(positions[index], rotations[index],
+				scales[index], model_matrices[index]);
+		}
+	}
+}
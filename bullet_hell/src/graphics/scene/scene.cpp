@@ -3,6 +3,7 @@
 #include <unordered_set>
 
 #include "Delegate.h"
+#include "glm/ext/matrix_transform.hpp"
 
 #include "debugging/logger.h"
 #include "event/event_manager.h"
@@ -12,7 +13,8 @@
 #include "map/chunk.h"
 #include "map/tile.h"
 #include "graphics/graph/model_resource.h"
-#include "graphics/scene/entity.h"
+#include "graphics/scene/chunk_mesh_builder.h"
+#include "graphics/scene/entity_registry.h"
 #include "graphics/graph/model.h"
 
 Scene::Scene(const unsigned int width, const unsigned int height)
@@ -33,12 +35,12 @@ Scene::Scene(const unsigned int width, const unsigned int height)
 	);
 }
 
-void Scene::add_entity(std::shared_ptr<Entity> entity)
+void Scene::add_entity(const EntityHandle entity)
 {
 	// We might want to load models and/or entities from multiple threads
 	std::scoped_lock<std::mutex> lock(pending_models_mutex);
 
-	const std::string& model_ID = entity->model_ID;
+	const std::string& model_ID = g_entity_registry->model_ID(entity);
 	auto result = model_map.find(model_ID);
 
 	if (result != model_map.end())
@@ -80,7 +82,14 @@ void Scene::add_model(std::shared_ptr<Model> model)
 	for (auto it = entities_pending_models.begin(); 
 		it < entities_pending_models.end();)
 	{
-		std::string current_entities_model = it->get()->model_ID;
+		if (!g_entity_registry->alive(*it))
+		{
+			it = entities_pending_models.erase(it);
+			continue;
+		}
+
+		const std::string& current_entities_model =
+			g_entity_registry->model_ID(*it);
 		if (model->id == current_entities_model)
 		{
 			model->entity_list.push_back(*it);
@@ -114,40 +123,38 @@ void Scene::add_model(std::shared_ptr<Model> model)
 
 void Scene::prune_models()
 {
-	for (auto& model_mapping : model_map)
+	// Only models that have lost entities since last time need a look, so
+	// a frame where nothing died costs next to nothing
+	pruned_models.clear();
+	g_entity_registry->take_models_losing_entities(pruned_models);
+	for (const uint32_t model_index : pruned_models)
 	{
-		bool removed_any = false;
-
-		EntityList to_keep;
-		auto& entity_list = model_mapping.second->entity_list;
-		for (auto& entity : entity_list)
+		auto result =
+			model_map.find(g_entity_registry->model_ID_at(model_index));
+		if (result == model_map.end())
 		{
-			if (!entity->dead)
-			{
-				to_keep.push_back(entity);
-			}
-			else
-			{
-				removed_any = true;
-			}
+			continue;
 		}
-		if (removed_any)
-		{
-			entity_list.clear();
-			for (auto& entity : to_keep)
-			{
-				entity_list.push_back(entity);
-			}
 
-			dirty = true;
-			if (model_mapping.second->is_animated())
+		Model& model = *result->second;
+		const size_t removed = std::erase_if(model.entity_list,
+			[](const EntityHandle entity)
 			{
-				animated_entities_dirty = true;
-			}
-			else
-			{
-				static_entities_dirty = true;
-			}
+				return !g_entity_registry->alive(entity);
+			});
+		if (removed == 0)
+		{
+			continue;
+		}
+
+		dirty = true;
+		if (model.is_animated())
+		{
+			animated_entities_dirty = true;
+		}
+		else
+		{
+			static_entities_dirty = true;
 		}
 	}
 }
@@ -195,6 +202,7 @@ void Scene::rebuild_model_lists()
 
 void Scene::reset()
 {
+	prune_models();
 	dirty = true;
 	animated_entities_dirty = true;
 	animated_models_dirty = true;
@@ -214,17 +222,36 @@ void Scene::handle_chunk_loading(EventPointer event)
 
 	std::shared_ptr<SceneCluster> cluster = std::make_shared<SceneCluster>();
 
+	// Tiles never move, so they are baked into one model for the chunk
+	// rather than each being an entity that has to be drawn and updated
+	ChunkMeshBuilder builder;
 	for (int x = 0; x < CHUNK_WIDTH; ++x)
 	{
 		for (int z = 0; z < CHUNK_WIDTH; ++z)
 		{
 			const Tile tile = (*tiles)[x][z];
-			const int world_x = chunk_location->x * CHUNK_WIDTH + x;
-			const int world_z = chunk_location->z * CHUNK_WIDTH + z;
-			load_tile(world_x, world_z, tile, *cluster);
+			load_tile(x, z, tile, builder);
 		}
 	}
 
+	if (!builder.empty())
+	{
+		const std::string model_ID = "chunks/"
+			+ std::to_string(chunk_location->x) + ","
+			+ std::to_string(chunk_location->z);
+		add_model(builder.build(model_ID));
+
+		const EntityHandle chunk_entity =
+			g_entity_registry->create(model_ID);
+		add_entity(chunk_entity);
+		const float chunk_world_width = CHUNK_WIDTH * TILE_SCALE * 2;
+		g_entity_registry->set_position(chunk_entity,
+			chunk_location->x * chunk_world_width, 0.0f,
+			chunk_location->z * chunk_world_width);
+
+		cluster->entities[model_ID].push_back(chunk_entity);
+	}
+
 	chunk_contents.insert(std::make_pair(*chunk_location, cluster));
 	LOG_INFO("Loading a chunk, now we have "
 		+ std::to_string(chunk_contents.size()) + " chunks right now.");
@@ -246,11 +273,17 @@ void Scene::handle_chunk_unloading(EventPointer event)
 	for (auto& entity_mapping : cluster->second->entities)
 	{
 		auto& entity_list = entity_mapping.second;
-		for (auto& existing : entity_list)
+		for (const EntityHandle existing : entity_list)
 		{
-			existing->dead = true;
+			g_entity_registry->destroy(existing);
 		}
 		entity_list.clear();
+
+		// Chunk models are only ever used by their own chunk
+		if (model_map.erase(entity_mapping.first) > 0)
+		{
+			static_models_dirty = true;
+		}
 	}
 
 	chunk_contents.erase(unloaded_event->coordinates);
@@ -259,7 +292,7 @@ void Scene::handle_chunk_unloading(EventPointer event)
 }
 
 void Scene::load_tile(const int& x, const int& z, const Tile& tile,
-	SceneCluster& cluster)
+	ChunkMeshBuilder& builder)
 {
 	std::string model_name = "";
 
@@ -281,23 +314,16 @@ void Scene::load_tile(const int& x, const int& z, const Tile& tile,
 
 	if (model_name != "")
 	{
-		std::shared_ptr<Model> tile_model;
-		if (!model_map.contains(model_name))
+		// Only needed for baking, so they stay out of the model map
+		std::shared_ptr<Model>& tile_model = tile_models[model_name];
+		if (!tile_model)
 		{
 			tile_model = load_model(model_name);
-			add_model(tile_model);
 		}
-		else
-		{
-			tile_model = model_map.find(model_name)->second;
-		}
-		auto tile_entity = std::make_shared<Entity>(tile_model->id);
-		add_entity(tile_entity);
-		tile_entity->scale = TILE_SCALE;
-		tile_entity->set_position(x * TILE_SCALE * 2, 0.0f, 
-			z * TILE_SCALE * 2);
-		tile_entity->update_model_matrix();
-
-		cluster.entities[model_name].push_back(tile_entity);
+
+		const glm::vec3 position{ x * TILE_SCALE * 2, 0.0f,
+			z * TILE_SCALE * 2 };
+		builder.add(*tile_model, glm::scale(
+			glm::translate(glm::mat4(1.0f), position), glm::vec3(TILE_SCALE)));
 	}
 }
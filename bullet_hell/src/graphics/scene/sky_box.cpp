@@ -4,6 +4,7 @@
 #include "graphics/graph/mesh_data.h"
 #include "graphics/graph/model.h"
 #include "graphics/graph/model_resource.h"
+#include "graphics/scene/entity_registry.h"
 #include "main/game_logic.h"
 #include "resource_cache/resource_cache.h"
 
@@ -13,7 +14,7 @@ SkyBox::SkyBox()
 {
 	const std::string model_name = "models/skybox/skybox.model";
 	model = load_model(model_name);
-	entity = std::make_shared<Entity>(model_name);
+	entity = g_entity_registry->create(model_name);
 
 	LOG_ASSERT(model->mesh_data_list.size() == 1
 		&& "We are assuming that skybox models only have one mesh");
@@ -1,7 +1,9 @@
 #include "main/game_logic.h"
 
+#include <algorithm>
 #include <numbers>
 #include <filesystem>
+#include <random>
 
 #include "imgui.h"
 
@@ -20,9 +22,12 @@
 #include "graphics/graph/model_resource.h"
 #include "graphics/graph/texture_resource.h"
 #include "graphics/gui/ui.h"
+#include "graphics/scene/entity_registry.h"
+#include "graphics/scene/entity_view.h"
 #include "graphics/scene/scene.h"
 #include "map/chunk.h"
 #include "map/tile.h"
+#include "memory/job_system.h"
 #include "resource_cache/resource_cache.h"
 #include "resource_cache/resource_zip_file.h"
 #include "utilities/math_util.h"
@@ -30,36 +35,37 @@
 #include "glad.h"
 #include "GLFW/glfw3.h"
 
+#if RECORD_INPUT
 /// <summary>
-/// The delay in seconds between recentering the map.
+/// Where the player input is recorded to.
 /// </summary>
-constexpr double MAP_RECENTER_DELAY = 1;
-
-/// <summary>
-/// The delay between animation frames.
-/// </summary>
-constexpr double ANIMATION_FRAME_TIME = 1.0 / 24;
+constexpr auto INPUT_RECORDING_PATH = "input_recording.bhir";
+#endif
 
 GameLogic::GameLogic()
-	: current_state{ GameState::STARTING_UP }
-	, resource_cache{ nullptr }
+	: resource_cache{ nullptr }
+	, window{ nullptr }
 #if BACKEND_CURRENT == BACKEND_OPENGL_DEPRECATED
 	, render{ nullptr }
 #else
 	, render_instance{ nullptr }
 #endif
 	, current_scene{ nullptr }
-	, last_animation_tick{ std::chrono::steady_clock::now() }
-	, last_frame{ std::chrono::steady_clock::now() }
-	, last_map_recenter{ std::chrono::steady_clock::now() }
-	, window{ nullptr }
+	, simulation{ nullptr }
+	, frame_snapshot{ nullptr }
+	, current_state{ GameState::STARTING_UP }
 	, action_state{}
+	, last_frame{ std::chrono::steady_clock::now() }
+	, camera_follow_position{ 0.0f }
+	, previous_frame_snapshot{ nullptr }
+	, new_scene_entities{}
 {
 }
 
 void GameLogic::end_game()
 {
 	current_state = GameState::GAME_OVER;
+	save_input_recording();
 }
 
 GameState GameLogic::get_current_state() const noexcept
@@ -67,6 +73,49 @@ GameState GameLogic::get_current_state() const noexcept
 	return current_state;
 }
 
+/// <summary>
+/// Load a model and add it to the scene.
+/// </summary>
+/// <param name="scene">The scene to add the model to.</param>
+/// <param name="name">The name of the model resource.</param>
+/// <returns>The ID of the model.</returns>
+static std::string add_model_to_scene(Scene& scene, const std::string& name)
+{
+	auto model = load_model(name);
+	scene.add_model(model);
+	return model->id;
+}
+
+/// <summary>
+/// Load the models and animations for the pawns, adding the models to the
+/// scene.
+/// </summary>
+/// <param name="scene">The scene to add the models to.</param>
+/// <returns>The assets for the pawn manager.</returns>
+static PawnAssets load_pawn_assets(Scene& scene)
+{
+	PawnAssets assets;
+
+	assets.player_model_id =
+		add_model_to_scene(scene, "models/player/human_male.model");
+	assets.player_attack_animation = load_animation("models/player/human_male.human_male_cast_unarmed_magic.animation");
+	assets.player_idle_animation = load_animation("models/player/human_male.human_male_idle.animation");
+	assets.player_running_animation = load_animation("models/player/human_male.human_male_run.animation");
+
+	assets.enemy_model_id =
+		add_model_to_scene(scene, "models/enemy/enemy.model");
+	assets.enemy_attack_animation = load_animation("models/enemy/enemy.human_male_cast_unarmed_magic.animation");
+	assets.enemy_idle_animation = load_animation("models/enemy/enemy.human_male_idle.animation");
+	assets.enemy_running_animation = load_animation("models/enemy/enemy.human_male_run.animation");
+
+	assets.enemy_bullet_model_id =
+		add_model_to_scene(scene, "models/projectile/gem_red.model");
+	assets.player_bullet_model_id =
+		add_model_to_scene(scene, "models/projectile/gem_blue.model");
+
+	return assets;
+}
+
 bool GameLogic::initialize()
 {
 	std::filesystem::path resource_path{ "assets.zip" };
@@ -89,6 +138,16 @@ bool GameLogic::initialize()
 	resource_cache->register_loader(std::make_shared<IconLoader>());
 
 	g_event_manager = ALLOC EventManager();
+	g_entity_registry = ALLOC EntityRegistry();
+	g_entity_view = ALLOC EntityView();
+
+	//NOTE(ches) the simulation thread helps out with work, and the main
+	// thread is busy rendering, so leave them both a core
+	const unsigned int hardware_threads = std::thread::hardware_concurrency();
+	g_job_system = ALLOC JobSystem(
+		hardware_threads > 2 ? hardware_threads - 2 : 0);
+	simulation = std::make_unique<SimulationThread>(
+		options.max_catch_up_ticks, options.shed_load_when_behind);
 
 	window = ALLOC Window();
 	TIME_START("Window Init");
@@ -133,7 +192,19 @@ bool GameLogic::initialize()
 	g_event_manager->update();
 	TIME_END("Map Init");
 
-	g_pawn_manager = ALLOC PawnManager();
+	// Entities are created on the simulation thread, so they go through it
+	// on the way to the scene
+	g_pawn_manager = ALLOC PawnManager(load_pawn_assets(*current_scene),
+		EntityHandler::create<SimulationThread,
+			&SimulationThread::queue_scene_entity>(simulation.get()),
+		std::random_device{}());
+
+	{
+		auto lock = simulation->lock_state();
+		g_pawn_manager->set_map(*current_map);
+		simulation->set_map(current_map);
+		simulation->publish_now(false);
+	}
 
 	current_scene->rebuild_model_lists();
 	current_scene->dirty = true;
@@ -162,7 +233,17 @@ void GameLogic::on_close()
 
 	window->terminate();
 
+	save_input_recording();
+
+	// Nothing else can be torn down while ticks might still run
+	simulation.reset();
+	frame_snapshot.reset();
+	previous_frame_snapshot.reset();
+
 	safe_delete(g_pawn_manager);
+	safe_delete(g_entity_view);
+	safe_delete(g_entity_registry);
+	safe_delete(g_job_system);
 	safe_delete(g_event_manager);
 	safe_delete(window);
 }
@@ -234,38 +315,7 @@ void GameLogic::process_input()
 	}
 #endif
 
-	glm::vec2 movement(0.0f, 0.0f);
-	if (action_desired(Action::PLAYER_MOVE_FORWARD))
-	{
-		movement += glm::vec2(1.0f, 0.0f);
-	}
-	if (action_desired(Action::PLAYER_MOVE_BACKWARD))
-	{
-		movement += glm::vec2(-1.0f, 0.0f);
-	}
-	if (action_desired(Action::PLAYER_MOVE_LEFT))
-	{
-		movement += glm::vec2(0.0f, -1.0f);
-	}
-	if (action_desired(Action::PLAYER_MOVE_RIGHT))
-	{
-		movement += glm::vec2(0.0f, 1.0f);
-	}
-
-	if (movement.x != 0 || movement.y != 0)
-	{
-		movement = glm::normalize(movement);
-	}
-	g_pawn_manager->player->desired_movement = movement;
-
-	if (action_desired(Action::PLAYER_ATTACK))
-	{
-		g_pawn_manager->player->wants_to_attack = true;
-	}
-	else
-	{
-		g_pawn_manager->player->wants_to_attack = false;
-	}
+	simulation->set_actions(held_actions());
 
 	if (action_desired(Action::PAUSE_OR_UNPAUSE_GAME))
 	{
@@ -283,6 +333,17 @@ void GameLogic::process_input()
 	}
 }
 
+void GameLogic::save_input_recording()
+{
+#if RECORD_INPUT
+	auto lock = simulation->lock_state();
+	if (simulation->input_recording.tick_count() > 0)
+	{
+		simulation->input_recording.save(INPUT_RECORDING_PATH);
+	}
+#endif
+}
+
 void GameLogic::request_close()
 {
 	current_state = GameState::QUIT_REQUESTED;
@@ -304,8 +365,6 @@ void GameLogic::calculate_delta_time()
 		frame_count = 0;
 		seconds_since_last_FPS_calcualation = 0;
 	}
-
-	seconds_since_last_animation_tick += seconds_since_last_frame;
 }
 
 [[nodiscard]]
@@ -314,36 +373,17 @@ bool GameLogic::action_desired(const Action& action) const noexcept
 	return action_state.find(action)->second;
 }
 
-void GameLogic::attempt_map_recenter()
+[[nodiscard]] ActionBits GameLogic::held_actions() const noexcept
 {
-	Instant now = std::chrono::steady_clock::now();
-	long long elapsed =
-		std::chrono::duration_cast<std::chrono::microseconds>(
-			now - last_map_recenter
-		).count();
-	double seconds_since_map_recenter = elapsed / 1'000'000.0;
-	if (seconds_since_map_recenter >= MAP_RECENTER_DELAY)
+	ActionBits actions = 0;
+	for (const auto& [action, desired] : action_state)
 	{
-		last_map_recenter = now;
-
-		const glm::vec3 player_position = 
-			g_pawn_manager->player->scene_entity->position;
-
-		glm::i16vec2 tile_coordinates{
-			std::floorf(player_position.x / (CHUNK_WIDTH * TILE_SCALE * 2)),
-			std::floorf(player_position.z / (CHUNK_WIDTH * TILE_SCALE * 2))
-		};
-
-		ChunkCoordinates actual_coordinates{
-			tile_coordinates.x,
-			tile_coordinates.y
-		};
-
-		if (current_map->center != actual_coordinates)
+		if (desired)
 		{
-			current_map->recenter(current_map->center, actual_coordinates);
+			actions |= action_bit(action);
 		}
 	}
+	return actions;
 }
 
 void GameLogic::run_game()
@@ -361,6 +401,8 @@ void GameLogic::run_game()
 		case GameState::GAME_OVER:
 		case GameState::MENU:
 		case GameState::PAUSED:
+			sync_with_simulation(false);
+			update_render_state();
 #if BACKEND_CURRENT == BACKEND_OPENGL_DEPRECATED
 			render->render_just_ui(*window, *current_scene);
 #elif BACKEND_CURRENT == BACKEND_OPENGL
@@ -387,48 +429,14 @@ void GameLogic::main_processing()
 {
 	calculate_delta_time();
 
-	TIME_START("Updating Pawns");
-	simulation_accumulator += seconds_since_last_frame;
-	while (simulation_accumulator >= SIMULATION_TIMESTEP)
+	if (simulation->take_player_died())
 	{
-		g_pawn_manager->tick();
-		simulation_accumulator -= SIMULATION_TIMESTEP;
+		end_game();
 	}
-	TIME_END("Updating Pawns");
-
-	TIME_START("Recentering Map");
-	attempt_map_recenter();
-	TIME_END("Recentering Map");
 
-	TIME_START("Processing Events");
-	g_event_manager->update(10);
-	TIME_END("Processing Events");
-
-	TIME_START("Updating Scene");
-	TIME_START("Updating Scene - Pruning Models");
-	current_scene->prune_models();
-	TIME_END("Updating Scene - Pruning Models");
-	if (current_scene->dirty)
-	{
-		TIME_START("Updating Scene - Updating Model Lists");
-		current_scene->rebuild_model_lists();
-		TIME_END("Updating Scene - Updating Model Lists");
-		TIME_START("Updating Scene - Updating Data");
-#if BACKEND_CURRENT == BACKEND_OPENGL_DEPRECATED
-		render->setup_all_data(*current_scene);
-#else
-		render_instance->setup_data(*current_scene);
-#endif
-		TIME_END("Updating Scene - Updating Data");
-	}
-	TIME_END("Updating Scene");
+	sync_with_simulation(true);
+	update_render_state();
 
-	if (seconds_since_last_animation_tick >= ANIMATION_FRAME_TIME)
-	{
-		last_animation_tick = std::chrono::steady_clock::now();
-		seconds_since_last_animation_tick = 0;
-		g_pawn_manager->tick_animations();
-	}
 #if BACKEND_CURRENT == BACKEND_OPENGL_DEPRECATED
 	render->render(*window, *current_scene);
 #else
@@ -441,24 +449,21 @@ void GameLogic::main_processing()
 void GameLogic::on_pause()
 {
 	current_state = GameState::PAUSED;
+	simulation->pause();
 	//TODO(ches) BH-53 - swap rendering pipelines
 }
 
 void GameLogic::on_resume()
 {
 	seconds_since_last_frame = 0;
-	simulation_accumulator = 0;
 	frame_count = 0;
 	seconds_since_last_FPS_calcualation = 0;
 	last_FPS = 0;
-	seconds_since_last_animation_tick = 0;
 
-	const Instant now = std::chrono::steady_clock::now();
-	last_frame = now;
-	last_animation_tick = now;
-	last_map_recenter = now;
+	last_frame = std::chrono::steady_clock::now();
 
 	current_state = GameState::RUNNING;
+	simulation->resume();
 	//TODO(ches) BH-53 - swap rendering pipelines
 }
 
@@ -468,31 +473,140 @@ void GameLogic::reset()
 	{
 		iterator.second = false;
 	}
+	simulation->set_actions(0);
+
+	auto lock = simulation->lock_state();
 
 	//NOTE(ches) finish processing anything that had been happening
 	g_event_manager->update();
 	current_map->reset();
-	g_pawn_manager->reset();
+
+	// Each game gets a new seed, which is recorded so it can be replayed
+	const uint32_t seed = std::random_device{}();
+	g_pawn_manager->reset(seed);
+	g_pawn_manager->set_map(*current_map);
+	simulation->input_recording.clear(seed);
 	current_scene->reset();
 
 	seconds_since_last_frame = 0;
-	simulation_accumulator = 0;
 	frame_count = 0;
 	seconds_since_last_FPS_calcualation = 0;
 	last_FPS = 0;
-	seconds_since_last_animation_tick = 0;
 
-	const Instant now = std::chrono::steady_clock::now();
-	last_frame = now;
-	last_animation_tick = now;
-	last_map_recenter = now;
+	last_frame = std::chrono::steady_clock::now();
 
 	round_timer = 0;
 
 	current_scene->camera.set_position(-18.0f, 20.0f, 0.0f);
 	current_scene->camera.set_rotation(0.82f, 1.57f);
+	camera_follow_position =
+		g_entity_registry->position(g_pawn_manager->player->scene_entity);
 
 	//NOTE(ches) Process all the map loading stuff
 	g_event_manager->update();
+
+	// Nothing from the last game should be blended into the new one
+	simulation->publish_now(false);
+	lock.unlock();
+
 	current_state = GameState::RUNNING;
+	simulation->resume();
+}
+
+void GameLogic::sync_with_simulation(const bool update_world)
+{
+	TIME_START("Waiting For Simulation");
+	auto lock = simulation->lock_state();
+	TIME_END("Waiting For Simulation");
+
+	const uint64_t created_before = g_entity_registry->created_count();
+
+	if (update_world)
+	{
+		TIME_START("Processing Events");
+		g_event_manager->update(10);
+		TIME_END("Processing Events");
+	}
+
+	// Let the simulation know what can be seen, so that enemies far away or
+	// offscreen can animate less
+	const Camera& camera = current_scene->camera;
+	g_pawn_manager->viewpoint = Viewpoint{
+		camera.position,
+		Frustum(current_scene->projection.projection_matrix
+			* camera.view_matrix),
+		true
+	};
+
+	TIME_START("Updating Scene - Adding Entities");
+	simulation->take_scene_entities(new_scene_entities);
+	for (const EntityHandle entity : new_scene_entities)
+	{
+		// Might have been created and destroyed since the last frame
+		if (g_entity_registry->alive(entity))
+		{
+			current_scene->add_entity(entity);
+		}
+	}
+	new_scene_entities.clear();
+	TIME_END("Updating Scene - Adding Entities");
+
+	TIME_START("Updating Scene - Pruning Models");
+	current_scene->prune_models();
+	TIME_END("Updating Scene - Pruning Models");
+
+	// Things like map tiles are created here rather than during a tick, so
+	// the snapshot needs to be redone to include them
+	if (g_entity_registry->created_count() != created_before)
+	{
+		simulation->publish_now(true);
+	}
+
+	// Fetched while locked, so every entity in the scene is in the snapshot
+	simulation->get_snapshots(previous_frame_snapshot, frame_snapshot);
+}
+
+void GameLogic::update_render_state()
+{
+	TIME_START("Updating Scene");
+	TIME_START("Updating Scene - Blending Entities");
+	const double seconds_since_tick = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - frame_snapshot->time).count();
+	const float alpha = static_cast<float>(
+		std::clamp(seconds_since_tick / SIMULATION_TIMESTEP, 0.0, 1.0));
+
+	// The aliasing constructor keeps the whole snapshot alive while the view
+	// is using part of it
+	g_entity_view->update(
+		std::shared_ptr<const EntitySnapshot>(previous_frame_snapshot,
+			&previous_frame_snapshot->entities),
+		std::shared_ptr<const EntitySnapshot>(frame_snapshot,
+			&frame_snapshot->entities),
+		alpha);
+	TIME_END("Updating Scene - Blending Entities");
+
+	// The camera follows the player around
+	const glm::vec3 player_position =
+		g_entity_view->position(frame_snapshot->player_entity);
+	const glm::vec3 player_movement = player_position - camera_follow_position;
+	if (player_movement.x != 0 || player_movement.z != 0)
+	{
+		current_scene->camera.add_position(player_movement);
+	}
+	camera_follow_position = player_position;
+
+	if (current_scene->dirty)
+	{
+		TIME_START("Updating Scene - Updating Model Lists");
+		current_scene->rebuild_model_lists();
+		TIME_END("Updating Scene - Updating Model Lists");
+		TIME_START("Updating Scene - Updating Data");
+#if BACKEND_CURRENT == BACKEND_OPENGL_DEPRECATED
+		render->setup_all_data(*current_scene);
+#else
+		render_instance->setup_data(*current_scene);
+#endif
+		TIME_END("Updating Scene - Updating Data");
+	}
+	TIME_END("Updating Scene");
 }
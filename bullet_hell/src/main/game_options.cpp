@@ -5,6 +5,8 @@
 GameOptions::GameOptions()
 	: window_title{ "Bullet Hell" }
 	, key_bindings{}
+	, max_catch_up_ticks{ 5 }
+	, shed_load_when_behind{ true }
 {
 #if _DEBUG
 	key_bindings.insert(std::make_pair(GLFW_KEY_UP, Action::CAMERA_MOVE_FORWARD));
@@ -0,0 +1,233 @@
+#include "main/input_recording.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "glm/glm.hpp"
+
+#include "debugging/logger.h"
+#include "entities/pawn.h"
+
+#pragma region Constants
+/// <summary>
+/// The characters that every recording file starts with.
+/// </summary>
+constexpr char RECORDING_MAGIC[4] = { 'B', 'H', 'I', 'R' };
+
+/// <summary>
+/// The version of the file format that we write.
+/// </summary>
+constexpr uint32_t RECORDING_VERSION = 2;
+
+/// <summary>
+/// The oldest version of the file format that we can still read.
+/// </summary>
+constexpr uint32_t RECORDING_OLDEST_VERSION = 1;
+
+/// <summary>
+/// The flag for timesteps where the simulation was shedding load.
+/// </summary>
+constexpr uint8_t RECORDING_FLAG_SHEDDING_LOAD = 1;
+#pragma endregion
+
+/// <summary>
+/// Read a little endian unsigned integer from a file.
+/// </summary>
+/// <typeparam name="T">The type of integer to read.</typeparam>
+/// <param name="source">The file to read from.</param>
+/// <param name="result">Where to store the value.</param>
+/// <returns>Whether the value was read successfully.</returns>
+template<typename T>
+static bool read_little_endian(std::ifstream& source, T& result)
+{
+	unsigned char bytes[sizeof(T)];
+	if (!source.read(reinterpret_cast<char*>(bytes), sizeof(T)))
+	{
+		return false;
+	}
+	result = 0;
+	for (size_t i = 0; i < sizeof(T); ++i)
+	{
+		result |= static_cast<T>(static_cast<T>(bytes[i]) << (i * 8));
+	}
+	return true;
+}
+
+/// <summary>
+/// Write an unsigned integer to a file in little endian order.
+/// </summary>
+/// <typeparam name="T">The type of integer to write.</typeparam>
+/// <param name="value">The value to write.</param>
+/// <param name="target">The file to write to.</param>
+template<typename T>
+static void write_little_endian(const T value, std::ofstream& target)
+{
+	unsigned char bytes[sizeof(T)];
+	for (size_t i = 0; i < sizeof(T); ++i)
+	{
+		bytes[i] = static_cast<unsigned char>(value >> (i * 8));
+	}
+	target.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+void apply_player_actions(Pawn& player, const ActionBits actions)
+{
+	glm::vec2 movement(0.0f, 0.0f);
+	if (actions & action_bit(Action::PLAYER_MOVE_FORWARD))
+	{
+		movement += glm::vec2(1.0f, 0.0f);
+	}
+	if (actions & action_bit(Action::PLAYER_MOVE_BACKWARD))
+	{
+		movement += glm::vec2(-1.0f, 0.0f);
+	}
+	if (actions & action_bit(Action::PLAYER_MOVE_LEFT))
+	{
+		movement += glm::vec2(0.0f, -1.0f);
+	}
+	if (actions & action_bit(Action::PLAYER_MOVE_RIGHT))
+	{
+		movement += glm::vec2(0.0f, 1.0f);
+	}
+
+	if (movement.x != 0 || movement.y != 0)
+	{
+		movement = glm::normalize(movement);
+	}
+	player.desired_movement = movement;
+
+	player.wants_to_attack =
+		(actions & action_bit(Action::PLAYER_ATTACK)) != 0;
+}
+
+InputRecording::InputRecording()
+	: seed{ 0 }
+	, runs{}
+	, ticks{ 0 }
+{}
+
+void InputRecording::clear(const uint32_t seed)
+{
+	this->seed = seed;
+	runs.clear();
+	ticks = 0;
+}
+
+void InputRecording::expand(std::vector<Tick>& destination) const
+{
+	destination.reserve(destination.size() + ticks);
+	for (const Run& run : runs)
+	{
+		destination.insert(destination.end(), run.length, run.tick);
+	}
+}
+
+bool InputRecording::load(const std::string& path)
+{
+	clear(0);
+
+	std::ifstream source(path, std::ios::binary);
+	if (!source)
+	{
+		LOG_ERROR("Could not open input recording " + path);
+		return false;
+	}
+
+	char magic[sizeof(RECORDING_MAGIC)];
+	uint32_t version = 0;
+	uint32_t seed = 0;
+	uint32_t tick_count = 0;
+	uint32_t run_count = 0;
+	if (!source.read(magic, sizeof(magic))
+		|| !std::equal(magic, magic + sizeof(magic), RECORDING_MAGIC)
+		|| !read_little_endian(source, version)
+		|| version < RECORDING_OLDEST_VERSION
+		|| version > RECORDING_VERSION
+		|| !read_little_endian(source, seed)
+		|| !read_little_endian(source, tick_count)
+		|| !read_little_endian(source, run_count))
+	{
+		LOG_ERROR("Input recording has an invalid header " + path);
+		return false;
+	}
+
+	runs.reserve(run_count);
+	uint64_t total_length = 0;
+	for (uint32_t i = 0; i < run_count; ++i)
+	{
+		Run run{ 0, Tick{ 0, false } };
+		uint8_t flags = 0;
+		if (!read_little_endian(source, run.length)
+			|| !read_little_endian(source, run.tick.actions)
+			|| (version > 1 && !read_little_endian(source, flags)))
+		{
+			LOG_ERROR("Input recording is cut short " + path);
+			clear(0);
+			return false;
+		}
+		run.tick.shedding_load = (flags & RECORDING_FLAG_SHEDDING_LOAD) != 0;
+		total_length += run.length;
+		runs.push_back(run);
+	}
+
+	if (total_length != tick_count)
+	{
+		LOG_ERROR("Input recording has the wrong number of ticks " + path);
+		clear(0);
+		return false;
+	}
+
+	this->seed = seed;
+	ticks = tick_count;
+	return true;
+}
+
+void InputRecording::record(const ActionBits actions,
+	const bool shedding_load)
+{
+	if (!runs.empty() && runs.back().tick.actions == actions
+		&& runs.back().tick.shedding_load == shedding_load)
+	{
+		++runs.back().length;
+	}
+	else
+	{
+		runs.push_back(Run{ 1, Tick{ actions, shedding_load } });
+	}
+	++ticks;
+}
+
+bool InputRecording::save(const std::string& path) const
+{
+	std::ofstream target(path, std::ios::binary | std::ios::trunc);
+	if (!target)
+	{
+		LOG_ERROR("Could not create input recording " + path);
+		return false;
+	}
+
+	target.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	write_little_endian(RECORDING_VERSION, target);
+	write_little_endian(seed, target);
+	write_little_endian(ticks, target);
+	write_little_endian(static_cast<uint32_t>(runs.size()), target);
+	for (const Run& run : runs)
+	{
+		write_little_endian(run.length, target);
+		write_little_endian(run.tick.actions, target);
+		write_little_endian(run.tick.shedding_load
+			? RECORDING_FLAG_SHEDDING_LOAD : uint8_t{ 0 }, target);
+	}
+
+	if (!target)
+	{
+		LOG_ERROR("Failed to write input recording " + path);
+		return false;
+	}
+	return true;
+}
+
+[[nodiscard]] uint32_t InputRecording::tick_count() const noexcept
+{
+	return ticks;
+}
@@ -0,0 +1,124 @@
+#include "main/simulation.h"
+
+#include <thread>
+
+#include "debugging/logger.h"
+#include "debugging/timer.h"
+#include "entities/pawn_manager.h"
+#include "event/event_manager.h"
+#include "graphics/scene/entity_registry.h"
+#include "map/game_map.h"
+#include "memory/job_system.h"
+
+#pragma region Constants
+/// <summary>
+/// How many frames are in each of the stand-in animations, which is about
+/// how long the real ones are.
+/// </summary>
+constexpr size_t STUB_ANIMATION_FRAMES = 24;
+#pragma endregion
+
+/// <summary>
+/// Create an animation with empty frames, since nothing is drawn.
+/// </summary>
+/// <param name="name">The name of the animation.</param>
+/// <returns>The new animation.</returns>
+static std::shared_ptr<Animation> make_stub_animation(const std::string& name)
+{
+	auto animation = std::make_shared<Animation>(name,
+		static_cast<double>(STUB_ANIMATION_FRAMES));
+	animation->frames.resize(STUB_ANIMATION_FRAMES);
+	return animation;
+}
+
+/// <summary>
+/// Create stand-ins for the models and animations, since the simulation
+/// does not load any resources.
+/// </summary>
+/// <returns>The assets for the pawn manager.</returns>
+static PawnAssets stub_pawn_assets()
+{
+	PawnAssets assets;
+
+	assets.player_model_id = "player";
+	assets.player_attack_animation = make_stub_animation("player_attack");
+	assets.player_idle_animation = make_stub_animation("player_idle");
+	assets.player_running_animation = make_stub_animation("player_running");
+
+	assets.enemy_model_id = "enemy";
+	assets.enemy_attack_animation = make_stub_animation("enemy_attack");
+	assets.enemy_idle_animation = make_stub_animation("enemy_idle");
+	assets.enemy_running_animation = make_stub_animation("enemy_running");
+
+	assets.enemy_bullet_model_id = "enemy_bullet";
+	assets.player_bullet_model_id = "player_bullet";
+
+	return assets;
+}
+
+Simulation::Simulation(const uint32_t seed, const size_t enemy_count)
+	: ticks{ 0 }
+	, enemy_count{ enemy_count }
+	, seed{ seed }
+{
+	g_event_manager = ALLOC EventManager();
+	g_entity_registry = ALLOC EntityRegistry();
+
+	//NOTE(ches) the main thread helps out with work, so leave it a core
+	const unsigned int hardware_threads = std::thread::hardware_concurrency();
+	g_job_system = ALLOC JobSystem(
+		hardware_threads > 1 ? hardware_threads - 1 : 0);
+
+	map = std::make_shared<GameMap>();
+	g_event_manager->update();
+
+	// Without a scene, nothing is told about new entities
+	g_pawn_manager =
+		ALLOC PawnManager(stub_pawn_assets(), EntityHandler{}, seed);
+	g_pawn_manager->set_map(*map);
+	g_pawn_manager->spawn_enemies(enemy_count);
+}
+
+Simulation::~Simulation()
+{
+	map.reset();
+	safe_delete(g_pawn_manager);
+	safe_delete(g_entity_registry);
+	safe_delete(g_job_system);
+	safe_delete(g_event_manager);
+}
+
+[[nodiscard]] bool Simulation::player_dead() const noexcept
+{
+	return g_pawn_manager->player->health <= 0;
+}
+
+void Simulation::reset()
+{
+	map->reset();
+	g_pawn_manager->reset(seed);
+	g_pawn_manager->set_map(*map);
+	g_pawn_manager->spawn_enemies(enemy_count);
+	g_event_manager->update();
+}
+
+void Simulation::tick(const ActionBits actions, const bool shedding_load)
+{
+	apply_player_actions(*g_pawn_manager->player, actions);
+	g_pawn_manager->shedding_load = shedding_load;
+
+	TIME_START("Updating Pawns");
+	g_pawn_manager->tick();
+	TIME_END("Updating Pawns");
+
+	// Stands in for the once per frame update that the game does before
+	// rendering
+	TIME_START("Updating Model Matrices");
+	g_entity_registry->update_model_matrices();
+	TIME_END("Updating Model Matrices");
+
+	++ticks;
+
+	g_pawn_manager->recenter_map_when_due(*map);
+	g_event_manager->update();
+}
@@ -0,0 +1,1119 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "debugging/logger.h"
+#include "entities/bullet_pool.h"
+#include "entities/collision_kernel.h"
+#include "entities/pawn_manager.h"
+#include "entities/separation.h"
+#include "entities/spatial_grid.h"
+#include "graphics/graph/draw_culler.h"
+#include "graphics/graph/gpu_cull_plan.h"
+#include "graphics/scene/entity_registry.h"
+#include "graphics/scene/entity_snapshot.h"
+#include "graphics/scene/entity_view.h"
+#include "graphics/scene/frustum.h"
+#include "main/input_recording.h"
+#include "main/simulation.h"
+#include "memory/job_system.h"
+
+#pragma region Constants
+/// <summary>
+/// How many timesteps to simulate if not specified, which is 10 minutes of
+/// game time.
+/// </summary>
+constexpr uint64_t DEFAULT_TICKS = 60 * 60 * 10;
+
+/// <summary>
+/// How many enemies to start with if not specified.
+/// </summary>
+constexpr uint64_t DEFAULT_ENEMIES = 500;
+
+/// <summary>
+/// The seed to use if not specified, so that runs are comparable.
+/// </summary>
+constexpr uint64_t DEFAULT_SEED = 0;
+
+/// <summary>
+/// How many timesteps the scripted player runs in each direction before
+/// turning.
+/// </summary>
+constexpr uint64_t SCRIPTED_TURN_TICKS = 150;
+
+/// <summary>
+/// The directions that the scripted player turns through, which takes them
+/// around in a rough circle.
+/// </summary>
+constexpr ActionBits SCRIPTED_DIRECTIONS[] = {
+	action_bit(Action::PLAYER_MOVE_FORWARD),
+	action_bit(Action::PLAYER_MOVE_FORWARD)
+		| action_bit(Action::PLAYER_MOVE_RIGHT),
+	action_bit(Action::PLAYER_MOVE_RIGHT),
+	action_bit(Action::PLAYER_MOVE_BACKWARD)
+		| action_bit(Action::PLAYER_MOVE_RIGHT),
+	action_bit(Action::PLAYER_MOVE_BACKWARD),
+	action_bit(Action::PLAYER_MOVE_BACKWARD)
+		| action_bit(Action::PLAYER_MOVE_LEFT),
+	action_bit(Action::PLAYER_MOVE_LEFT),
+	action_bit(Action::PLAYER_MOVE_FORWARD)
+		| action_bit(Action::PLAYER_MOVE_LEFT),
+};
+
+/// <summary>
+/// How many pawns to separate in the separation benchmark if not specified.
+/// </summary>
+constexpr uint64_t DEFAULT_SEPARATION_POINTS = 10'000;
+
+/// <summary>
+/// How many times to separate the pawns in the separation benchmark.
+/// </summary>
+constexpr size_t SEPARATION_PASSES = 200;
+
+/// <summary>
+/// How close pawns get before they are pushed apart, and the size of the
+/// grid cells. This matches the pawn manager.
+/// </summary>
+constexpr float SEPARATION_DISTANCE = 1.0f;
+
+/// <summary>
+/// The furthest a pawn can be pushed in one pass. This matches the pawn
+/// manager.
+/// </summary>
+constexpr float SEPARATION_MAX_PUSH = 5.0f / 60.0f;
+
+/// <summary>
+/// How many pawns each worker separates at once.
+/// </summary>
+constexpr size_t SEPARATION_CHUNK_SIZE = 256;
+
+/// <summary>
+/// How long a separation pass over 10k pawns, including building the grid,
+/// can take on average before the benchmark fails, in microseconds. This
+/// leaves most of the 16.6 ms timestep for everything else even on a single
+/// core, and is scaled up for larger crowds.
+/// </summary>
+constexpr float SEPARATION_TARGET_MICROSECONDS = 2'000.0f;
+
+/// <summary>
+/// How many jobs to run in each part of the job system benchmark if not
+/// specified.
+/// </summary>
+constexpr uint64_t DEFAULT_BENCHMARK_JOBS = 100'000;
+
+/// <summary>
+/// How many jobs long the chain of dependencies is in the job system
+/// benchmark.
+/// </summary>
+constexpr size_t JOB_CHAIN_LENGTH = 1'000;
+
+/// <summary>
+/// How many player bullets to check in each pass of the bullet grid
+/// benchmark if not specified.
+/// </summary>
+constexpr uint64_t DEFAULT_GRID_BULLETS = 50;
+
+/// <summary>
+/// The enemy counts that the bullet grid benchmark compares brute force and
+/// the grid at, which spans the crossover between them.
+/// </summary>
+constexpr size_t GRID_ENEMY_COUNTS[] = {
+	8, 16, 32, 48, 64, 96, 128, 256, 512, 1'000, 4'000 };
+
+/// <summary>
+/// How many times the bullets are checked at each enemy count in the bullet
+/// grid benchmark.
+/// </summary>
+constexpr size_t GRID_PASSES = 1'000;
+
+/// <summary>
+/// The width of the square that enemies and bullets are spread over in the
+/// bullet grid benchmark.
+/// </summary>
+constexpr float GRID_AREA_SIZE = 100.0f;
+
+/// <summary>
+/// How close a bullet has to be to hit an enemy. This matches the pawn
+/// manager.
+/// </summary>
+constexpr float GRID_COLLISION_RADIUS = 0.5f;
+
+/// <summary>
+/// How many random batches each instruction set is checked with in the
+/// collision self test.
+/// </summary>
+constexpr size_t COLLISION_TEST_BATCHES = 5'000;
+
+/// <summary>
+/// The longest batch in the collision self test. Batch lengths cycle up to
+/// this, which covers several full AVX2 widths and every length of tail.
+/// </summary>
+constexpr size_t COLLISION_TEST_MAX_POINTS = 69;
+
+/// <summary>
+/// How far from the center points are scattered in the collision self test,
+/// which is far enough that about half of them miss.
+/// </summary>
+constexpr float COLLISION_TEST_SPREAD = 0.7f;
+
+/// <summary>
+/// How many models the cull check draws. Every few of them is left without
+/// any entities.
+/// </summary>
+constexpr size_t CULL_TEST_MODELS = 20;
+
+/// <summary>
+/// The most entities that each model has in the cull check.
+/// </summary>
+constexpr uint32_t CULL_TEST_MAX_ENTITIES = 400;
+
+/// <summary>
+/// How many random views the cull check compares the culls from.
+/// </summary>
+constexpr size_t CULL_TEST_FRUSTA = 200;
+
+/// <summary>
+/// How far from the origin entities and cameras are placed in the cull
+/// check, which is far enough that most views miss most entities.
+/// </summary>
+constexpr float CULL_TEST_AREA_SIZE = 200.0f;
+
+/// <summary>
+/// How many indices each mesh of the cull check pretends to have, which is
+/// only used to give every command its own first index.
+/// </summary>
+constexpr int CULL_TEST_MESH_INDICES = 36;
+#pragma endregion
+
+/// <summary>
+/// Parse a command line argument as a number.
+/// </summary>
+/// <param name="argument">The argument to parse.</param>
+/// <param name="result">Where to store the number.</param>
+/// <returns>Whether the argument was a valid number.</returns>
+static bool parse_count(const char* argument, uint64_t& result)
+{
+	try
+	{
+		size_t parsed_length = 0;
+		result = std::stoull(argument, &parsed_length);
+		return argument[parsed_length] == '\0';
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
+
+/// <summary>
+/// The input for the scripted player, who always attacks and runs around in
+/// a circle so that the map keeps recentering.
+/// </summary>
+/// <param name="tick">How many timesteps into the run we are.</param>
+/// <returns>The actions for the timestep.</returns>
+static ActionBits scripted_actions(const uint64_t tick)
+{
+	constexpr size_t direction_count = std::size(SCRIPTED_DIRECTIONS);
+	const size_t direction = (tick / SCRIPTED_TURN_TICKS) % direction_count;
+	return SCRIPTED_DIRECTIONS[direction] | action_bit(Action::PLAYER_ATTACK);
+}
+
+/// <summary>
+/// Simulate one timestep, and measure how long it took.
+/// </summary>
+/// <param name="simulation">The simulation to run.</param>
+/// <param name="tick">The player input for the timestep, and whether to
+/// shed load.</param>
+/// <param name="tick_times">Where to add the time taken, in microseconds.
+/// </param>
+static void timed_tick(Simulation& simulation,
+	const InputRecording::Tick& tick, std::vector<float>& tick_times)
+{
+	const auto start = std::chrono::steady_clock::now();
+	simulation.tick(tick.actions, tick.shedding_load);
+	const auto end = std::chrono::steady_clock::now();
+	tick_times.push_back(
+		std::chrono::duration<float, std::micro>(end - start).count());
+}
+
+/// <summary>
+/// Print how long the timesteps took, and where the game ended up so that
+/// runs can be checked against each other.
+/// </summary>
+/// <param name="tick_times">How long each timestep took, in microseconds.
+/// </param>
+static void report(std::vector<float>& tick_times)
+{
+	if (tick_times.empty())
+	{
+		std::cout << "No ticks were simulated\n";
+		return;
+	}
+
+	double total = 0;
+	for (const float time : tick_times)
+	{
+		total += time;
+	}
+	std::sort(tick_times.begin(), tick_times.end());
+	const auto percentile = [&](const double fraction)
+		{
+			const size_t index =
+				static_cast<size_t>(fraction * (tick_times.size() - 1));
+			return tick_times[index];
+		};
+
+	const size_t count = tick_times.size();
+	std::cout << "Ticks:      " << count << "\n"
+		<< "Ticks/sec:  " << count / (total / 1'000'000.0) << "\n"
+		<< "Mean:       " << total / count << " us\n"
+		<< "Median:     " << percentile(0.5) << " us\n"
+		<< "99th:       " << percentile(0.99) << " us\n"
+		<< "Max:        " << tick_times.back() << " us\n";
+
+	const Pawn& player = *g_pawn_manager->player;
+	const glm::vec3& position =
+		g_entity_registry->position(player.scene_entity);
+	std::cout << "End state:  player at (" << position.x << ", "
+		<< position.z << ") with " << player.health << " health, "
+		<< g_pawn_manager->enemies.size() << " enemies\n";
+}
+
+/// <summary>
+/// Run the scripted player for a number of timesteps, starting a new game
+/// whenever they die.
+/// </summary>
+/// <param name="ticks">The number of timesteps to run.</param>
+/// <param name="enemies">How many enemies to start each game with.</param>
+/// <param name="seed">The seed for each game.</param>
+static void run_scripted(const uint64_t ticks, const uint64_t enemies,
+	const uint64_t seed)
+{
+	Simulation simulation(static_cast<uint32_t>(seed),
+		static_cast<size_t>(enemies));
+
+	std::vector<float> tick_times;
+	tick_times.reserve(ticks);
+	uint64_t deaths = 0;
+	for (uint64_t i = 0; i < ticks; ++i)
+	{
+		timed_tick(simulation, InputRecording::Tick{ scripted_actions(i),
+			false }, tick_times);
+		if (simulation.player_dead())
+		{
+			++deaths;
+			simulation.reset();
+		}
+	}
+
+	std::cout << "Scripted run with " << enemies << " starting enemies, seed "
+		<< seed << ", " << deaths << " deaths\n";
+	report(tick_times);
+}
+
+/// <summary>
+/// Play back a recorded game as fast as possible.
+/// </summary>
+/// <param name="path">The recording to play.</param>
+/// <returns>Whether the recording played back the same way.</returns>
+static bool run_replay(const std::string& path)
+{
+	InputRecording recording;
+	if (!recording.load(path))
+	{
+		std::cerr << "Could not load input recording " << path << "\n";
+		return false;
+	}
+
+	std::vector<InputRecording::Tick> ticks;
+	recording.expand(ticks);
+
+	// Games in the recording start with no extra enemies
+	Simulation simulation(recording.seed, 0);
+
+	std::vector<float> tick_times;
+	tick_times.reserve(ticks.size());
+	bool in_sync = true;
+	size_t shed_ticks = 0;
+	for (size_t i = 0; i < ticks.size(); ++i)
+	{
+		timed_tick(simulation, ticks[i], tick_times);
+		shed_ticks += ticks[i].shedding_load ? 1 : 0;
+		if (simulation.player_dead() && i + 1 < ticks.size())
+		{
+			in_sync = false;
+			break;
+		}
+	}
+
+	std::cout << "Replay of " << path << ", seed " << recording.seed << ", "
+		<< shed_ticks << " ticks shedding load\n";
+	report(tick_times);
+	if (!in_sync)
+	{
+		std::cerr << "The player died " << ticks.size() - tick_times.size()
+			<< " ticks before the recording ended, so the replay did not "
+			"match the recorded game\n";
+	}
+	return in_sync;
+}
+
+/// <summary>
+/// Time how long it takes to separate a crowd of pawns packed about one per
+/// square unit, which is as dense as a swarm around the player gets.
+/// </summary>
+/// <param name="points">How many pawns to separate.</param>
+/// <returns>Whether the passes met the target time, scaled to the number of
+/// pawns.</returns>
+static bool run_separation_benchmark(const uint64_t points)
+{
+	const size_t count = static_cast<size_t>(points);
+	const float side = std::sqrt(static_cast<float>(count));
+	std::mt19937 random(static_cast<uint32_t>(DEFAULT_SEED));
+	const float scale = side / static_cast<float>(std::mt19937::max());
+
+	std::vector<float> x(count);
+	std::vector<float> z(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		x[i] = static_cast<float>(random()) * scale;
+		z[i] = static_cast<float>(random()) * scale;
+	}
+	std::vector<float> push_x(count);
+	std::vector<float> push_z(count);
+
+	const unsigned int hardware_threads = std::thread::hardware_concurrency();
+	JobSystem jobs(hardware_threads > 1 ? hardware_threads - 1 : 0);
+	SpatialGrid grid(SEPARATION_DISTANCE);
+
+	std::vector<float> pass_times;
+	pass_times.reserve(SEPARATION_PASSES);
+	for (size_t pass = 0; pass < SEPARATION_PASSES; ++pass)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		grid.build(x.data(), z.data(), count);
+		jobs.parallel_for(count, SEPARATION_CHUNK_SIZE,
+			[&](const size_t begin, const size_t end)
+			{
+				Separation::find_pushes(grid, x.data(), z.data(), begin, end,
+					SEPARATION_DISTANCE, SEPARATION_MAX_PUSH, push_x.data(),
+					push_z.data());
+			});
+		const auto end = std::chrono::steady_clock::now();
+		pass_times.push_back(
+			std::chrono::duration<float, std::micro>(end - start).count());
+	}
+
+	double total = 0;
+	for (const float time : pass_times)
+	{
+		total += time;
+	}
+	std::sort(pass_times.begin(), pass_times.end());
+	const float mean = static_cast<float>(total / pass_times.size());
+	const float target = SEPARATION_TARGET_MICROSECONDS
+		* std::max(1.0f, static_cast<float>(count) / 10'000.0f);
+
+	std::cout << "Separation of " << count << " pawns over "
+		<< SEPARATION_PASSES << " passes\n"
+		<< "Mean:       " << mean << " us\n"
+		<< "Median:     " << pass_times[pass_times.size() / 2] << " us\n"
+		<< "Max:        " << pass_times.back() << " us\n"
+		<< "Target:     " << target << " us\n";
+
+	if (mean > target)
+	{
+		std::cerr << "Separation took longer than the target\n";
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Time how long it takes the job system to hand out work too small to be
+/// worth splitting up, so that the overhead of a job is all that's left.
+/// </summary>
+/// <param name="job_count">How many jobs to run in each part.</param>
+/// <param name="worker_count">How many worker threads to start.</param>
+/// <returns>Whether every job ran exactly once, in order where it had to.
+/// </returns>
+static bool run_job_benchmark(const uint64_t job_count,
+	const uint64_t worker_count)
+{
+	const size_t count = static_cast<size_t>(job_count);
+	JobSystem jobs(static_cast<size_t>(worker_count));
+	bool success = true;
+
+	// Separate jobs, each queued up on its own
+	std::atomic<size_t> tasks_run{ 0 };
+	auto task = [&]() { tasks_run.fetch_add(1, std::memory_order_relaxed); };
+	auto start = std::chrono::steady_clock::now();
+	{
+		JobCounter counter;
+		for (size_t i = 0; i < count; ++i)
+		{
+			jobs.run(counter, task);
+		}
+		jobs.wait(counter);
+	}
+	auto end = std::chrono::steady_clock::now();
+	const float spawn_time =
+		std::chrono::duration<float, std::nano>(end - start).count();
+	success = success && tasks_run.load() == count;
+
+	// One range split down to single items, which is all stealing
+	std::vector<uint8_t> visits(count, 0);
+	const uint64_t steals_before = jobs.steal_count();
+	start = std::chrono::steady_clock::now();
+	jobs.parallel_for(count, 1, [&](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				++visits[i];
+			}
+		});
+	end = std::chrono::steady_clock::now();
+	const float split_time =
+		std::chrono::duration<float, std::nano>(end - start).count();
+	const uint64_t steals = jobs.steal_count() - steals_before;
+	for (const uint8_t visit : visits)
+	{
+		success = success && visit == 1;
+	}
+
+	// Each job held back until the one before it is done
+	size_t next_link = 0;
+	bool in_order = true;
+	std::vector<std::function<void()>> links;
+	links.reserve(JOB_CHAIN_LENGTH);
+	for (size_t i = 0; i < JOB_CHAIN_LENGTH; ++i)
+	{
+		links.emplace_back([&, i]()
+			{
+				in_order = in_order && next_link == i;
+				++next_link;
+			});
+	}
+	std::vector<JobCounter> chain(JOB_CHAIN_LENGTH);
+	start = std::chrono::steady_clock::now();
+	jobs.run(chain[0], links[0]);
+	for (size_t i = 1; i < JOB_CHAIN_LENGTH; ++i)
+	{
+		jobs.run_after(chain[i - 1], chain[i], links[i]);
+	}
+	for (JobCounter& counter : chain)
+	{
+		jobs.wait(counter);
+	}
+	end = std::chrono::steady_clock::now();
+	const float chain_time =
+		std::chrono::duration<float, std::nano>(end - start).count();
+	success = success && in_order && next_link == JOB_CHAIN_LENGTH;
+
+	std::cout << "Job system with " << jobs.thread_count() << " threads\n"
+		<< "Spawn:      " << spawn_time / count << " ns per job\n"
+		<< "Split:      " << split_time / count << " ns per item, "
+		<< steals << " stolen\n"
+		<< "Chain:      " << chain_time / JOB_CHAIN_LENGTH
+		<< " ns per dependency\n";
+
+	if (!success)
+	{
+		std::cerr << "Jobs were skipped, repeated, or run out of order\n";
+	}
+	return success;
+}
+
+/// <summary>
+/// Time how long it takes to find what each player bullet hits, both by
+/// checking every enemy and by checking nearby enemies in a grid, over a
+/// range of enemy counts. This is how the pawn manager's threshold for
+/// switching to the grid was picked.
+///
+/// The grid is built every tick for targeting anyway, so only the lookups
+/// are timed.
+/// </summary>
+/// <param name="bullet_count">How many bullets to check in each pass.
+/// </param>
+/// <returns>Whether both ways found the same enemy for every bullet.
+/// </returns>
+static bool run_bullet_grid_benchmark(const uint64_t bullet_count)
+{
+	const size_t bullets = static_cast<size_t>(bullet_count);
+	const float radius_squared =
+		GRID_COLLISION_RADIUS * GRID_COLLISION_RADIUS;
+	std::mt19937 random(static_cast<uint32_t>(DEFAULT_SEED));
+	std::uniform_real_distribution<float> position(0.0f, GRID_AREA_SIZE);
+
+	std::vector<float> bullet_x(bullets);
+	std::vector<float> bullet_z(bullets);
+	std::vector<size_t> brute_force_targets(bullets);
+	std::vector<size_t> grid_targets(bullets);
+	std::vector<float> enemy_x;
+	std::vector<float> enemy_z;
+	SpatialGrid grid(GRID_COLLISION_RADIUS * 2.0f);
+
+	std::cout << "Player bullet collision with " << bullets
+		<< " bullets over " << GRID_PASSES << " passes\n"
+		<< "Enemies    Brute force    Grid\n";
+
+	bool agree = true;
+	size_t crossover = 0;
+	for (const size_t enemies : GRID_ENEMY_COUNTS)
+	{
+		enemy_x.resize(enemies);
+		enemy_z.resize(enemies);
+		for (size_t i = 0; i < enemies; ++i)
+		{
+			enemy_x[i] = position(random);
+			enemy_z[i] = position(random);
+		}
+		for (size_t i = 0; i < bullets; ++i)
+		{
+			bullet_x[i] = position(random);
+			bullet_z[i] = position(random);
+		}
+		grid.build(enemy_x.data(), enemy_z.data(), enemies);
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t pass = 0; pass < GRID_PASSES; ++pass)
+		{
+			for (size_t i = 0; i < bullets; ++i)
+			{
+				brute_force_targets[i] = CollisionKernel::find_first_within(
+					enemy_x.data(), enemy_z.data(), enemies, bullet_x[i],
+					bullet_z[i], radius_squared);
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+		const float brute_force_time = std::chrono::duration<float,
+			std::micro>(end - start).count() / GRID_PASSES;
+
+		start = std::chrono::steady_clock::now();
+		for (size_t pass = 0; pass < GRID_PASSES; ++pass)
+		{
+			for (size_t i = 0; i < bullets; ++i)
+			{
+				grid_targets[i] = grid.find_first_within(bullet_x[i],
+					bullet_z[i], radius_squared);
+			}
+		}
+		end = std::chrono::steady_clock::now();
+		const float grid_time = std::chrono::duration<float,
+			std::micro>(end - start).count() / GRID_PASSES;
+
+		agree = agree && brute_force_targets == grid_targets;
+
+		// Timings are noisy, so only count where the grid stays ahead
+		if (grid_time >= brute_force_time)
+		{
+			crossover = 0;
+		}
+		else if (crossover == 0)
+		{
+			crossover = enemies;
+		}
+		std::cout << std::setw(7) << enemies << std::fixed
+			<< std::setprecision(2) << std::setw(12) << brute_force_time
+			<< " us" << std::setw(9) << grid_time << " us\n"
+			<< std::defaultfloat;
+	}
+
+	if (crossover != 0)
+	{
+		std::cout << "The grid stays faster from " << crossover
+			<< " enemies\n";
+	}
+	else
+	{
+		std::cout << "The grid was never faster\n";
+	}
+
+	if (!agree)
+	{
+		std::cerr << "Brute force and the grid hit different enemies\n";
+	}
+	return agree;
+}
+
+/// <summary>
+/// Fetch the name of a collision kernel instruction set, for printing.
+/// </summary>
+/// <param name="instruction_set">The instruction set.</param>
+/// <returns>The name of the instruction set.</returns>
+static const char* instruction_set_name(
+	const CollisionKernel::InstructionSet instruction_set)
+{
+	switch (instruction_set)
+	{
+	case CollisionKernel::InstructionSet::AVX2:
+		return "AVX2";
+	case CollisionKernel::InstructionSet::SSE2:
+		return "SSE2";
+	default:
+		return "scalar";
+	}
+}
+
+/// <summary>
+/// Check that every instruction set the collision kernel can use on this
+/// processor gives exactly the same hits as CollisionKernel::within, and
+/// that releasing the enemy bullets that hit the player releases each of
+/// them once and leaves every other bullet alone.
+///
+/// Batches include points exactly on the radius and NaN coordinates, which
+/// the wider versions have to treat the same way as the scalar check.
+/// </summary>
+/// <param name="seed">The seed for the random batches.</param>
+/// <returns>Whether every instruction set matched.</returns>
+static bool run_collision_test(const uint64_t seed)
+{
+	using CollisionKernel::InstructionSet;
+
+	const float radius_squared =
+		GRID_COLLISION_RADIUS * GRID_COLLISION_RADIUS;
+	const InstructionSet original = CollisionKernel::get_instruction_set();
+	const InstructionSet supported =
+		CollisionKernel::supported_instruction_set();
+
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<uint8_t> hit_masks;
+	std::vector<Health> expected_survivors;
+	std::vector<Health> survivors;
+	BulletPool bullets(EntityHandler{}, "", COLLISION_TEST_MAX_POINTS);
+
+	bool success = true;
+	for (const InstructionSet instruction_set : { InstructionSet::SCALAR,
+		InstructionSet::SSE2, InstructionSet::AVX2 })
+	{
+		if (instruction_set > supported)
+		{
+			std::cout << instruction_set_name(instruction_set)
+				<< ": not supported\n";
+			continue;
+		}
+		CollisionKernel::set_instruction_set(instruction_set);
+
+		// Every instruction set sees the same batches
+		std::mt19937 random(static_cast<uint32_t>(seed));
+		std::uniform_real_distribution<float> center(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> offset(-COLLISION_TEST_SPREAD,
+			COLLISION_TEST_SPREAD);
+
+		size_t mask_mismatches = 0;
+		size_t first_mismatches = 0;
+		size_t release_mismatches = 0;
+		for (size_t batch = 0; batch < COLLISION_TEST_BATCHES; ++batch)
+		{
+			const size_t count = batch % (COLLISION_TEST_MAX_POINTS + 1);
+			const float center_x = center(random);
+			const float center_z = center(random);
+			x.resize(count);
+			z.resize(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				switch (random() % 16)
+				{
+				case 0:
+					x[i] = center_x + GRID_COLLISION_RADIUS;
+					z[i] = center_z;
+					break;
+				case 1:
+					x[i] = std::numeric_limits<float>::quiet_NaN();
+					z[i] = center_z;
+					break;
+				default:
+					x[i] = center_x + offset(random);
+					z[i] = center_z + offset(random);
+					break;
+				}
+			}
+
+			// One extra mask to catch writes past the end
+			const size_t mask_count = CollisionKernel::mask_count(count);
+			hit_masks.assign(mask_count + 1, uint8_t{ 0xA5 });
+			CollisionKernel::find_within(x.data(), z.data(), count, center_x,
+				center_z, radius_squared, hit_masks.data());
+			const size_t first = CollisionKernel::find_first_within(x.data(),
+				z.data(), count, center_x, center_z, radius_squared);
+
+			size_t expected_first = count;
+			bool masks_match = hit_masks[mask_count] == 0xA5;
+			for (size_t i = 0; i < mask_count * 8; ++i)
+			{
+				const bool hit = i < count && CollisionKernel::within(x[i],
+					z[i], center_x, center_z, radius_squared);
+				masks_match = masks_match
+					&& ((hit_masks[i / 8] >> (i % 8)) & 1u) == (hit ? 1u : 0u);
+				if (hit && expected_first == count)
+				{
+					expected_first = i;
+				}
+			}
+			mask_mismatches += masks_match ? 0 : 1;
+			first_mismatches += first == expected_first ? 0 : 1;
+
+			// Give each bullet its own damage, so we can tell which were
+			// released and how many times
+			bullets.clear();
+			Health expected_damage = 0;
+			expected_survivors.clear();
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Health damage = static_cast<Health>(i + 1);
+				bullets.spawn(glm::vec3(x[i], 0.0f, z[i]),
+					glm::vec2(1.0f, 0.0f), 0.0f, damage);
+				if (CollisionKernel::within(x[i], z[i], center_x, center_z,
+					radius_squared))
+				{
+					expected_damage += damage;
+				}
+				else
+				{
+					expected_survivors.push_back(damage);
+				}
+			}
+			hit_masks.resize(mask_count);
+			CollisionKernel::find_within(bullets.position_x.data(),
+				bullets.position_z.data(), bullets.size(), center_x,
+				center_z, radius_squared, hit_masks.data());
+			const Health damage = bullets.release_hits(hit_masks.data());
+
+			survivors = bullets.damage;
+			std::sort(survivors.begin(), survivors.end());
+			release_mismatches += damage == expected_damage
+				&& survivors == expected_survivors ? 0 : 1;
+		}
+
+		std::cout << instruction_set_name(instruction_set) << ": "
+			<< COLLISION_TEST_BATCHES << " batches, " << mask_mismatches
+			<< " hit mask, " << first_mismatches << " first hit and "
+			<< release_mismatches << " release mismatches\n";
+		success = success && mask_mismatches == 0 && first_mismatches == 0
+			&& release_mismatches == 0;
+	}
+	CollisionKernel::set_instruction_set(original);
+
+	if (!success)
+	{
+		std::cerr << "The collision kernel disagreed with the scalar check\n";
+	}
+	return success;
+}
+
+/// <summary>
+/// Gather the instances that each command draws after a cull, keyed by the
+/// first index of the command, with the instances sorted so that sets can
+/// be compared.
+/// </summary>
+/// <param name="commands">The culled draw commands.</param>
+/// <param name="draw_elements">The draw elements the commands refer to.
+/// </param>
+/// <returns>The model matrix index and material of every instance, for
+/// each command with any instances.</returns>
+static std::map<int, std::vector<std::pair<int, int>>> culled_instances(
+	const std::vector<int>& commands, const std::vector<int>& draw_elements)
+{
+	std::map<int, std::vector<std::pair<int, int>>> result;
+	for (size_t i = 0; i + DrawCuller::COMMAND_SIZE <= commands.size();
+		i += DrawCuller::COMMAND_SIZE)
+	{
+		const int instance_count = commands[i + 1];
+		if (instance_count == 0)
+		{
+			continue;
+		}
+		std::vector<std::pair<int, int>>& instances = result[commands[i + 2]];
+		for (int instance = 0; instance < instance_count; ++instance)
+		{
+			const size_t element = (commands[i + 4] + instance)
+				* DrawCuller::DRAW_ELEMENT_SIZE;
+			instances.emplace_back(draw_elements[element],
+				draw_elements[element + 1]);
+		}
+		std::sort(instances.begin(), instances.end());
+	}
+	return result;
+}
+
+/// <summary>
+/// Check that culling draw commands the way the compute shader does keeps
+/// exactly the same instances as the draw culler, for random models and
+/// views. The compute shader packs instances in whatever order its threads
+/// finish, so only the set of instances in each command is compared.
+///
+/// Entities go through the entity registry, a snapshot and the entity view,
+/// as they do when the game renders, with some destroyed along the way so
+/// that handles and model matrix indices don't line up.
+/// </summary>
+/// <param name="seed">The seed for the random models and views.</param>
+/// <returns>Whether every cull matched.</returns>
+static bool run_cull_test(const uint64_t seed)
+{
+	std::mt19937 random(static_cast<uint32_t>(seed));
+	std::uniform_real_distribution<float> coordinate(-CULL_TEST_AREA_SIZE,
+		CULL_TEST_AREA_SIZE);
+	std::uniform_real_distribution<float> extent(0.2f, 4.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 3.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+	EntityRegistry registry;
+	std::vector<std::shared_ptr<Model>> models;
+	std::vector<EntityHandle> destroyed;
+	for (size_t m = 0; m < CULL_TEST_MODELS; ++m)
+	{
+		const std::string model_ID = "cull_test_" + std::to_string(m);
+		auto model = std::make_shared<Model>(model_ID);
+		const size_t mesh_count = 1 + m % 3;
+		for (size_t mesh = 0; mesh < mesh_count; ++mesh)
+		{
+			MeshData& mesh_data = model->mesh_data_list.emplace_back();
+			mesh_data.aabb_min =
+				glm::vec3(-extent(random), 0.0f, -extent(random));
+			mesh_data.aabb_max =
+				glm::vec3(extent(random), extent(random), extent(random));
+		}
+
+		const uint32_t entity_count =
+			m % 7 == 5 ? 0 : random() % CULL_TEST_MAX_ENTITIES;
+		for (uint32_t e = 0; e < entity_count; ++e)
+		{
+			const EntityHandle entity = registry.create(model_ID);
+			registry.set_position(entity, coordinate(random),
+				coordinate(random) / 8.0f, coordinate(random));
+			registry.set_rotation(entity, 0.0f, 1.0f, 0.0f, angle(random));
+			registry.scale(entity) = scale(random);
+			if (random() % 8 == 0)
+			{
+				destroyed.push_back(entity);
+			}
+			else
+			{
+				model->entity_list.push_back(entity);
+			}
+		}
+		models.push_back(model);
+	}
+	for (const EntityHandle entity : destroyed)
+	{
+		registry.destroy(entity);
+	}
+	registry.update_model_matrices();
+
+	auto snapshot = std::make_shared<EntitySnapshot>();
+	snapshot->capture(registry);
+	EntityView view;
+	view.update(snapshot, snapshot, 1.0f);
+	EntityView* const original_view = g_entity_view;
+	g_entity_view = &view;
+
+	// Laid out the same way as the static commands and the model matrix
+	// buffer when rendering
+	std::vector<int> commands;
+	std::vector<int> draw_elements;
+	std::vector<glm::mat4> model_matrices;
+	int first_index = 0;
+	int base_instance = 0;
+	int material = 0;
+	for (const auto& model : models)
+	{
+		const int first_matrix = static_cast<int>(model_matrices.size());
+		const int entity_count = static_cast<int>(model->entity_list.size());
+		for (size_t mesh = 0; mesh < model->mesh_data_list.size(); ++mesh)
+		{
+			commands.insert(commands.end(), { CULL_TEST_MESH_INDICES,
+				entity_count, first_index, 0, base_instance });
+			first_index += CULL_TEST_MESH_INDICES;
+			base_instance += entity_count;
+			for (int entity = 0; entity < entity_count; ++entity)
+			{
+				draw_elements.push_back(first_matrix + entity);
+				draw_elements.push_back(material);
+			}
+			++material;
+		}
+		for (const EntityHandle entity : model->entity_list)
+		{
+			model_matrices.push_back(g_entity_view->model_matrix(entity));
+		}
+	}
+
+	DrawCuller culler;
+	culler.gather(models, commands, draw_elements);
+	GpuCullPlan plan;
+	plan.build(models, commands, draw_elements);
+
+	std::vector<int> visible_commands;
+	std::vector<int> visible_draw_elements;
+	std::vector<int> culled_commands;
+	std::vector<int> culled_draw_elements;
+	size_t mismatches = 0;
+	size_t kept = 0;
+	for (size_t v = 0; v < CULL_TEST_FRUSTA; ++v)
+	{
+		const float field_of_view = 30.0f + static_cast<float>(v % 60);
+		const float far_plane = 50.0f + static_cast<float>(v % 50) * 5.0f;
+		const glm::mat4 projection = glm::perspective(
+			glm::radians(field_of_view), 16.0f / 9.0f, 0.1f, far_plane);
+		const glm::mat4 camera = glm::lookAt(
+			glm::vec3(coordinate(random), 60.0f, coordinate(random)),
+			glm::vec3(coordinate(random), 0.0f, coordinate(random)),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		const Frustum frustum(projection * camera);
+
+		culler.cull(frustum, visible_commands, visible_draw_elements);
+		plan.cull(frustum, model_matrices, culled_commands,
+			culled_draw_elements);
+
+		// Apart from the instance count, commands should come out of the
+		// plan just as they went in
+		bool match = culled_commands.size() == commands.size();
+		for (size_t i = 0; match && i < commands.size();
+			i += GpuCullPlan::COMMAND_SIZE)
+		{
+			match = culled_commands[i] == commands[i]
+				&& culled_commands[i + 2] == commands[i + 2]
+				&& culled_commands[i + 3] == commands[i + 3]
+				&& culled_commands[i + 4] == commands[i + 4];
+		}
+
+		const auto expected =
+			culled_instances(visible_commands, visible_draw_elements);
+		match = match && culled_instances(culled_commands,
+			culled_draw_elements) == expected;
+		mismatches += match ? 0 : 1;
+		for (const auto& [first, instances] : expected)
+		{
+			kept += instances.size();
+		}
+	}
+	g_entity_view = original_view;
+
+	std::cout << CULL_TEST_FRUSTA << " views of "
+		<< draw_elements.size() / DrawCuller::DRAW_ELEMENT_SIZE
+		<< " instances in " << commands.size() / DrawCuller::COMMAND_SIZE
+		<< " commands, " << kept << " instances kept in total, "
+		<< mismatches << " mismatches\n";
+
+	if (mismatches != 0)
+	{
+		std::cerr << "The GPU cull plan disagreed with the draw culler\n";
+	}
+	return mismatches == 0;
+}
+
+/// <summary>
+/// Runs the game logic headless, and reports how fast it went.
+///
+/// Usage: BulletHellSim [ticks] [enemies] [seed]
+///        BulletHellSim --replay recording
+///        BulletHellSim --separation [pawns]
+///        BulletHellSim --jobs [jobs] [workers]
+///        BulletHellSim --bullet-grid [bullets]
+///        BulletHellSim --collision [seed]
+///        BulletHellSim --cull [seed]
+/// </summary>
+/// <param name="argc">The number of command line arguments.</param>
+/// <param name="argv">The command line arguments.</param>
+/// <returns>The exit code for the program.</returns>
+int main(int argc, char* argv[])
+{
+	const bool replay = argc > 1 && std::string_view(argv[1]) == "--replay";
+	const bool separation =
+		argc > 1 && std::string_view(argv[1]) == "--separation";
+	const bool job_benchmark =
+		argc > 1 && std::string_view(argv[1]) == "--jobs";
+	const bool bullet_grid_benchmark =
+		argc > 1 && std::string_view(argv[1]) == "--bullet-grid";
+	const bool collision_test =
+		argc > 1 && std::string_view(argv[1]) == "--collision";
+	const bool cull_test =
+		argc > 1 && std::string_view(argv[1]) == "--cull";
+
+	uint64_t ticks = DEFAULT_TICKS;
+	uint64_t enemies = DEFAULT_ENEMIES;
+	uint64_t seed = DEFAULT_SEED;
+	uint64_t separation_points = DEFAULT_SEPARATION_POINTS;
+	uint64_t benchmark_jobs = DEFAULT_BENCHMARK_JOBS;
+	uint64_t grid_bullets = DEFAULT_GRID_BULLETS;
+	const unsigned int hardware_threads = std::thread::hardware_concurrency();
+	uint64_t benchmark_workers =
+		hardware_threads > 1 ? hardware_threads - 1 : 0;
+	const bool valid = replay ? argc == 3
+		: separation ? argc <= 2
+			|| (argc == 3 && parse_count(argv[2], separation_points))
+		: job_benchmark ? argc <= 4
+			&& (argc <= 2 || parse_count(argv[2], benchmark_jobs))
+			&& (argc <= 3 || parse_count(argv[3], benchmark_workers))
+		: bullet_grid_benchmark ? argc <= 2
+			|| (argc == 3 && parse_count(argv[2], grid_bullets))
+		: collision_test || cull_test ? argc <= 2
+			|| (argc == 3 && parse_count(argv[2], seed))
+		: argc <= 4
+		&& (argc <= 1 || parse_count(argv[1], ticks))
+		&& (argc <= 2 || parse_count(argv[2], enemies))
+		&& (argc <= 3 || parse_count(argv[3], seed));
+	if (!valid)
+	{
+		std::cerr << "Usage: " << argv[0] << " [ticks] [enemies] [seed]\n"
+			<< "       " << argv[0] << " --replay recording\n"
+			<< "       " << argv[0] << " --separation [pawns]\n"
+			<< "       " << argv[0] << " --jobs [jobs] [workers]\n"
+			<< "       " << argv[0] << " --bullet-grid [bullets]\n"
+			<< "       " << argv[0] << " --collision [seed]\n"
+			<< "       " << argv[0] << " --cull [seed]\n";
+		return EXIT_FAILURE;
+	}
+
+	Logger::init();
+
+	bool success = true;
+	if (replay)
+	{
+		success = run_replay(argv[2]);
+	}
+	else if (separation)
+	{
+		success = run_separation_benchmark(separation_points);
+	}
+	else if (job_benchmark)
+	{
+		success = run_job_benchmark(benchmark_jobs, benchmark_workers);
+	}
+	else if (bullet_grid_benchmark)
+	{
+		success = run_bullet_grid_benchmark(grid_bullets);
+	}
+	else if (collision_test)
+	{
+		success = run_collision_test(seed);
+	}
+	else if (cull_test)
+	{
+		success = run_cull_test(seed);
+	}
+	else
+	{
+		run_scripted(ticks, enemies, seed);
+	}
+
+	Logger::destroy();
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,361 @@
+#include "main/simulation_thread.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "debugging/logger.h"
+#include "entities/pawn.h"
+#include "entities/pawn_manager.h"
+#include "graphics/scene/entity_registry.h"
+
+/// <summary>
+/// The length of a tick, as a clock duration.
+/// </summary>
+constexpr auto TICK_DURATION =
+	std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(SIMULATION_TIMESTEP));
+
+/// <summary>
+/// How long to measure time dilation over.
+/// </summary>
+constexpr auto TIME_DILATION_WINDOW = std::chrono::seconds(1);
+
+/// <summary>
+/// How much each tick counts toward the moving average of tick times.
+/// </summary>
+constexpr double TICK_AVERAGE_WEIGHT = 0.05;
+
+/// <summary>
+/// Start shedding load once ticks take this much of a timestep to run, on
+/// average.
+/// </summary>
+constexpr double SHED_START_LOAD = 0.8;
+
+/// <summary>
+/// Stop shedding load once ticks are back down to this much of a timestep,
+/// on average. Lower than the start so that we don't flip back and forth.
+/// </summary>
+constexpr double SHED_STOP_LOAD = 0.5;
+
+SimulationThread::SimulationThread(const unsigned int max_catch_up_ticks,
+	const bool shed_load_when_behind)
+	: input_recording{}
+	, max_catch_up_ticks{ max_catch_up_ticks }
+	, shed_load_when_behind{ shed_load_when_behind }
+	, running{ false }
+	, restart_clock{ false }
+	, stopping{ false }
+	, actions{ 0 }
+	, player_died{ false }
+	, ticks{ 0 }
+	, load{}
+	, average_tick_seconds{ 0 }
+	, new_scene_entities{}
+	, map{}
+	, snapshot_pool{}
+	, previous_snapshot{}
+	, latest_snapshot{}
+	, thread{ &SimulationThread::run, this }
+{}
+
+SimulationThread::~SimulationThread()
+{
+	{
+		std::scoped_lock<std::mutex> lock(control_mutex);
+		stopping = true;
+	}
+	control_changed.notify_all();
+	thread.join();
+}
+
+void SimulationThread::get_snapshots(
+	std::shared_ptr<const SimulationSnapshot>& previous,
+	std::shared_ptr<const SimulationSnapshot>& latest)
+{
+	std::scoped_lock<std::mutex> lock(snapshot_mutex);
+	previous = previous_snapshot;
+	latest = latest_snapshot;
+}
+
+[[nodiscard]] std::unique_lock<std::mutex> SimulationThread::lock_state()
+{
+	return std::unique_lock<std::mutex>(state_mutex);
+}
+
+void SimulationThread::pause()
+{
+	{
+		std::scoped_lock<std::mutex> lock(control_mutex);
+		running = false;
+	}
+	control_changed.notify_all();
+}
+
+void SimulationThread::publish_now(const bool blend)
+{
+	Instant time = std::chrono::steady_clock::now();
+	if (blend)
+	{
+		// Still the same tick, so keep blending as if nothing happened
+		std::scoped_lock<std::mutex> lock(snapshot_mutex);
+		if (latest_snapshot)
+		{
+			time = latest_snapshot->time;
+		}
+	}
+	publish(time, blend ? Replace::LATEST : Replace::BOTH);
+}
+
+void SimulationThread::queue_scene_entity(const EntityHandle entity)
+{
+	new_scene_entities.push_back(entity);
+}
+
+void SimulationThread::resume()
+{
+	{
+		std::scoped_lock<std::mutex> lock(control_mutex);
+		running = true;
+		restart_clock = true;
+	}
+	control_changed.notify_all();
+}
+
+void SimulationThread::set_map(std::shared_ptr<GameMap> map)
+{
+	this->map = std::move(map);
+}
+
+void SimulationThread::set_actions(const ActionBits actions) noexcept
+{
+	this->actions.store(actions, std::memory_order_relaxed);
+}
+
+[[nodiscard]] bool SimulationThread::take_player_died() noexcept
+{
+	return player_died.exchange(false);
+}
+
+void SimulationThread::take_scene_entities(
+	std::vector<EntityHandle>& entities)
+{
+	entities.insert(entities.end(), new_scene_entities.begin(),
+		new_scene_entities.end());
+	new_scene_entities.clear();
+}
+
+[[nodiscard]] std::shared_ptr<SimulationSnapshot>
+	SimulationThread::acquire_snapshot()
+{
+	std::scoped_lock<std::mutex> lock(snapshot_mutex);
+	for (const auto& snapshot : snapshot_pool)
+	{
+		// Only the pool refers to it, and nobody can pick it up again
+		// without going through the snapshot mutex
+		if (snapshot.use_count() == 1)
+		{
+			// Make sure the last reader is done before we overwrite it
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return snapshot;
+		}
+	}
+	snapshot_pool.push_back(std::make_shared<SimulationSnapshot>());
+	return snapshot_pool.back();
+}
+
+void SimulationThread::publish(const Instant time, const Replace replace)
+{
+	g_entity_registry->update_model_matrices();
+
+	std::shared_ptr<SimulationSnapshot> snapshot = acquire_snapshot();
+	snapshot->tick = ticks;
+	snapshot->time = time;
+	snapshot->entities.capture(*g_entity_registry);
+
+	const Pawn& player = *g_pawn_manager->player;
+	snapshot->player_entity = player.scene_entity;
+	snapshot->player_health = player.health;
+	snapshot->player_max_health = player.max_health;
+	snapshot->player_desired_facing = player.desired_facing;
+	snapshot->enemy_count = g_pawn_manager->enemies.size();
+	snapshot->enemy_bullet_count = g_pawn_manager->enemy_bullets.size();
+	snapshot->player_bullet_count = g_pawn_manager->player_bullets.size();
+	snapshot->load = load;
+
+	std::scoped_lock<std::mutex> lock(snapshot_mutex);
+	switch (replace)
+	{
+	case Replace::PREVIOUS:
+		previous_snapshot = std::move(latest_snapshot);
+		break;
+	case Replace::LATEST:
+		break;
+	case Replace::BOTH:
+		previous_snapshot = snapshot;
+		break;
+	}
+	if (!previous_snapshot)
+	{
+		previous_snapshot = snapshot;
+	}
+	latest_snapshot = std::move(snapshot);
+}
+
+void SimulationThread::run()
+{
+	LOG_ASSERT(max_catch_up_ticks > 0 && "Must be able to run ticks");
+
+	Instant next_tick = std::chrono::steady_clock::now();
+	Instant dilation_start = next_tick;
+	uint64_t dilation_ticks = 0;
+	std::unique_lock<std::mutex> control_lock(control_mutex);
+	while (true)
+	{
+		control_changed.wait(control_lock,
+			[this]() { return running || stopping; });
+		if (stopping)
+		{
+			return;
+		}
+		if (restart_clock)
+		{
+			restart_clock = false;
+			next_tick = std::chrono::steady_clock::now() + TICK_DURATION;
+			dilation_start = next_tick;
+			dilation_ticks = 0;
+		}
+		control_lock.unlock();
+
+		// Run the ticks that are due, so the simulation keeps pace with the
+		// clock no matter how often we get woken up, but only up to a limit
+		const Instant now = std::chrono::steady_clock::now();
+		uint64_t due = 0;
+		if (next_tick <= now)
+		{
+			due = (now - next_tick) / TICK_DURATION + 1;
+		}
+		const uint64_t allowed = std::min<uint64_t>(due, max_catch_up_ticks);
+		bool player_alive = true;
+		uint64_t ran = 0;
+		while (ran < allowed && player_alive)
+		{
+			player_alive = step(next_tick);
+			next_tick += TICK_DURATION;
+			++ran;
+		}
+		dilation_ticks += ran;
+
+		// Anything past the limit is skipped, since running it would only
+		// make the next batch later still
+		const uint64_t dropped = player_alive ? due - ran : 0;
+		next_tick += dropped * TICK_DURATION;
+
+		const bool dilation_measured = now - dilation_start
+			>= TIME_DILATION_WINDOW;
+		if (dropped > 0 || dilation_measured)
+		{
+			std::scoped_lock<std::mutex> state_lock(state_mutex);
+			if (dropped > 0)
+			{
+				++load.capped_catch_ups;
+				load.dropped_ticks += dropped;
+				update_shedding(true);
+			}
+			if (dilation_measured)
+			{
+				const double elapsed =
+					std::chrono::duration<double>(now - dilation_start).count();
+				load.time_dilation = static_cast<float>(
+					dilation_ticks * SIMULATION_TIMESTEP / elapsed);
+				dilation_start = now;
+				dilation_ticks = 0;
+			}
+		}
+
+		control_lock.lock();
+		control_changed.wait_until(control_lock, next_tick, [this]()
+			{
+				return !running || restart_clock || stopping;
+			});
+	}
+}
+
+bool SimulationThread::step(const Instant time)
+{
+	std::scoped_lock<std::mutex> lock(state_mutex);
+	const Instant start = std::chrono::steady_clock::now();
+
+	const ActionBits held_actions = actions.load(std::memory_order_relaxed);
+#if RECORD_INPUT
+	input_recording.record(held_actions, g_pawn_manager->shedding_load);
+#endif
+	apply_player_actions(*g_pawn_manager->player, held_actions);
+	g_pawn_manager->tick();
+	++ticks;
+	if (map)
+	{
+		// Chunks that this loads are queued as events, which the render
+		// thread handles while holding the state lock
+		g_pawn_manager->recenter_map_when_due(*map);
+	}
+
+	const auto tick_duration = std::chrono::steady_clock::now() - start;
+	if (tick_duration > TICK_DURATION)
+	{
+		++load.overrun_ticks;
+	}
+	average_tick_seconds += TICK_AVERAGE_WEIGHT
+		* (std::chrono::duration<double>(tick_duration).count()
+			- average_tick_seconds);
+	update_shedding(false);
+
+	publish(time, Replace::PREVIOUS);
+
+	if (g_pawn_manager->player->health > 0)
+	{
+		return true;
+	}
+
+	// Stop before anyone hears about it, so that a new game started in
+	// response isn't paused by us
+	{
+		std::scoped_lock<std::mutex> control_lock(control_mutex);
+		running = false;
+	}
+	player_died = true;
+	return false;
+}
+
+void SimulationThread::update_shedding(const bool fell_behind)
+{
+	if (!shed_load_when_behind)
+	{
+		return;
+	}
+
+	const double tick_load = average_tick_seconds / SIMULATION_TIMESTEP;
+	bool shedding = load.shedding;
+	if (fell_behind || tick_load >= SHED_START_LOAD)
+	{
+		shedding = true;
+	}
+	else if (tick_load <= SHED_STOP_LOAD)
+	{
+		shedding = false;
+	}
+	if (shedding == load.shedding)
+	{
+		return;
+	}
+
+	load.shedding = shedding;
+	g_pawn_manager->shedding_load = shedding;
+	if (shedding)
+	{
+		LOG_WARNING("Simulation is falling behind, shedding optional work");
+	}
+	else
+	{
+		LOG_INFO("Simulation caught up, no longer shedding work");
+	}
+}
@@ -1,10 +1,13 @@
 #include "map/game_map.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
 #include "debugging/logger.h"
 #include "event/event_manager.h"
 #include "event/map/chunk_loaded.h"
 #include "event/map/chunk_unloaded.h"
-#include "main/game_logic.h"
 #include "map/chunk.h"
 #include "map/map_generator.h"
 #include "memory/critical_section.h"
@@ -51,6 +54,22 @@ GameMap::~GameMap()
 	cold_cache.clear();
 }
 
+[[nodiscard]] ChunkCoordinates GameMap::chunk_at(const float x,
+	const float z) noexcept
+{
+	return ChunkCoordinates{
+		static_cast<int16_t>(std::floor(x / (CHUNK_WIDTH * TILE_SCALE * 2))),
+		static_cast<int16_t>(std::floor(z / (CHUNK_WIDTH * TILE_SCALE * 2)))
+	};
+}
+
+[[nodiscard]] int GameMap::chunk_distance(const ChunkCoordinates& first,
+	const ChunkCoordinates& second) noexcept
+{
+	return std::max(std::abs(first.x - second.x),
+		std::abs(first.z - second.z));
+}
+
 Chunk* GameMap::get_cached(const ChunkCoordinates& coordinates)
 {
 	ScopedCriticalSection lock(chunk_critical_section);
@@ -79,6 +98,14 @@ Chunk* GameMap::get_cached(const ChunkCoordinates& coordinates)
 	return fresh_result->second;
 }
 
+[[nodiscard]] const Chunk* GameMap::get_hot(
+	const ChunkCoordinates& coordinates) const
+{
+	ScopedCriticalSection lock(chunk_critical_section);
+	const auto result = hot_cache.find(coordinates.combined);
+	return result != hot_cache.end() ? result->second : nullptr;
+}
+
 bool GameMap::is_cold(const ChunkCoordinates& coordinates) const
 {
 	return cold_cache.find(coordinates.combined) != cold_cache.end();
@@ -261,6 +288,16 @@ void GameMap::recenter(const ChunkCoordinates& old_center,
 	center = new_center;
 }
 
+void GameMap::recenter_on(const float x, const float z)
+{
+	const ChunkCoordinates actual_coordinates = chunk_at(x, z);
+
+	if (center != actual_coordinates)
+	{
+		recenter(center, actual_coordinates);
+	}
+}
+
 void GameMap::reset()
 {
 	ScopedCriticalSection lock(chunk_critical_section);
@@ -0,0 +1,353 @@
+#include "memory/job_system.h"
+
+#include <utility>
+
+JobSystem* g_job_system = nullptr;
+
+/// <summary>
+/// How many jobs each thread can have queued or running at once. Ranges are
+/// split in half each time, so this only runs out when something queues up
+/// thousands of separate jobs before waiting.
+/// </summary>
+constexpr size_t JOB_CAPACITY = 4096;
+
+/// <summary>
+/// How many jobs to check before giving up and helping run the ones that
+/// are in use, so that a full ring isn't searched end to end every time.
+/// Jobs are handed out in order around the ring and stolen oldest first,
+/// so the next few are the ones most likely to have finished.
+/// </summary>
+constexpr size_t ALLOCATE_ATTEMPTS = 8;
+
+/// <summary>
+/// One thread still wrapping up the last job of a counter, in the state of
+/// the counter.
+/// </summary>
+constexpr uint64_t ONE_FINISHING = uint64_t{ 1 } << 32;
+
+/// <summary>
+/// The bits of the state of a counter that hold the number of unfinished
+/// jobs.
+/// </summary>
+constexpr uint64_t PENDING_MASK = ONE_FINISHING - 1;
+
+/// <summary>
+/// How many times an idle worker looks for work before going to sleep.
+/// Sleeping and waking both take a trip through the kernel, which would
+/// cost more than the jobs themselves if we did it between every frame.
+/// </summary>
+constexpr uint32_t IDLE_ATTEMPTS = 64;
+
+/// <summary>
+/// The job system that the current thread works for, if any.
+/// </summary>
+thread_local const JobSystem* current_system = nullptr;
+
+/// <summary>
+/// The index of the queue that the current thread owns in its job system.
+/// </summary>
+thread_local size_t current_index = 0;
+
+JobCounter::JobCounter()
+	: state{ 0 }
+{}
+
+[[nodiscard]] bool JobCounter::done() const noexcept
+{
+	return state.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::ThreadQueue::ThreadQueue(const size_t capacity,
+	const uint32_t seed)
+	: queue{ capacity }
+	, jobs(capacity)
+	, next_job{ 0 }
+	, random{ seed }
+{}
+
+JobSystem::JobSystem(const size_t worker_count)
+	: sleeping_workers{ 0 }
+	, wake_signal{ 0 }
+	, steals{ 0 }
+	, stopping{ false }
+{
+	queues.reserve(worker_count + 1);
+	for (size_t i = 0; i <= worker_count; ++i)
+	{
+		// Xorshift needs a seed that isn't 0
+		const uint32_t seed = static_cast<uint32_t>(i + 1) * 0x9E3779B9u;
+		queues.push_back(std::make_unique<ThreadQueue>(JOB_CAPACITY, seed));
+	}
+
+	workers.reserve(worker_count);
+	for (size_t i = 0; i < worker_count; ++i)
+	{
+		workers.emplace_back(&JobSystem::worker_loop, this, i + 1);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	stopping.store(true);
+	wake_signal.fetch_add(1);
+	wake_signal.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	const size_t queue = current_queue();
+	while (!counter.done())
+	{
+		Job* job = find_job(queue);
+		if (job != nullptr)
+		{
+			execute(queue, job);
+		}
+		else
+		{
+			// Whatever is left is running on other threads
+			std::this_thread::yield();
+		}
+	}
+}
+
+[[nodiscard]] size_t JobSystem::thread_count() const noexcept
+{
+	return workers.size() + 1;
+}
+
+[[nodiscard]] uint64_t JobSystem::steal_count() const noexcept
+{
+	return steals.load(std::memory_order_relaxed);
+}
+
+[[nodiscard]] Job* JobSystem::allocate(const size_t queue)
+{
+	ThreadQueue& owner = *queues[queue];
+	while (true)
+	{
+		for (size_t i = 0; i < ALLOCATE_ATTEMPTS; ++i)
+		{
+			Job& job = owner.jobs[owner.next_job];
+			owner.next_job = (owner.next_job + 1) % owner.jobs.size();
+			// Only the owner hands out jobs, so nobody else can claim it
+			if (!job.in_use.load(std::memory_order_acquire))
+			{
+				job.in_use.store(true, std::memory_order_relaxed);
+				return &job;
+			}
+		}
+
+		// Jobs are mostly still queued or running, so help get through them
+		Job* other = find_job(queue);
+		if (other == nullptr)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		execute(queue, other);
+
+		// Most likely it was one of ours, which saves looking for it
+		const Job* first = owner.jobs.data();
+		if (other >= first && other < first + owner.jobs.size())
+		{
+			owner.next_job = static_cast<size_t>(other - first);
+		}
+	}
+}
+
+[[nodiscard]] size_t JobSystem::current_queue() const noexcept
+{
+	return current_system == this ? current_index : 0;
+}
+
+void JobSystem::execute(const size_t queue, Job* job)
+{
+	// Keep the first half and leave the rest for other threads, until
+	// what's left is a single chunk
+	while (job->end - job->begin > job->chunk_size)
+	{
+		const size_t chunks = (job->end - job->begin + job->chunk_size - 1)
+			/ job->chunk_size;
+		const size_t middle = job->begin + chunks / 2 * job->chunk_size;
+
+		Job* half = allocate(queue);
+		half->invoker = job->invoker;
+		half->function = job->function;
+		half->begin = middle;
+		half->end = job->end;
+		half->chunk_size = job->chunk_size;
+		half->counter = job->counter;
+		job->counter->state.fetch_add(1, std::memory_order_relaxed);
+		push(queue, half);
+
+		job->end = middle;
+	}
+
+	job->invoker(job->function, job->begin, job->end);
+
+	JobCounter& counter = *job->counter;
+	job->in_use.store(false, std::memory_order_release);
+	finish(queue, counter);
+}
+
+[[nodiscard]] Job* JobSystem::find_job(const size_t queue)
+{
+	ThreadQueue& owner = *queues[queue];
+	Job* job = owner.queue.pop();
+	if (job != nullptr)
+	{
+		return job;
+	}
+
+	// Start somewhere different each time, so thieves spread out
+	owner.random ^= owner.random << 13;
+	owner.random ^= owner.random >> 17;
+	owner.random ^= owner.random << 5;
+	const size_t count = queues.size();
+	const size_t start = owner.random % count;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const size_t victim = (start + i) % count;
+		if (victim == queue)
+		{
+			continue;
+		}
+		job = queues[victim]->queue.steal();
+		if (job != nullptr)
+		{
+			steals.fetch_add(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::finish(const size_t queue, JobCounter& counter)
+{
+	// The last job moves itself over to finishing, so that the counter can't
+	// be considered done until the dependents have been handed off
+	uint64_t state = counter.state.load(std::memory_order_relaxed);
+	uint64_t next = 0;
+	do
+	{
+		next = (state & PENDING_MASK) == 1
+			? state - 1 + ONE_FINISHING
+			: state - 1;
+	} while (!counter.state.compare_exchange_weak(state, next,
+		std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	if ((state & PENDING_MASK) != 1)
+	{
+		return;
+	}
+
+	std::vector<Job*> released;
+	{
+		std::scoped_lock<std::mutex> lock(counter.mutex);
+		released.swap(counter.dependents);
+	}
+	counter.state.fetch_sub(ONE_FINISHING, std::memory_order_release);
+
+	// The counter might be gone by now, but the jobs belong to their own
+	for (Job* job : released)
+	{
+		push(queue, job);
+	}
+}
+
+void JobSystem::push(const size_t queue, Job* job)
+{
+	if (!queues[queue]->queue.push(job))
+	{
+		execute(queue, job);
+		return;
+	}
+
+	// Pairs with the fence in the worker loop, so that either the worker
+	// sees the job or we see that it's going to sleep
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping_workers.load(std::memory_order_relaxed) > 0)
+	{
+		wake_signal.fetch_add(1, std::memory_order_release);
+		wake_signal.notify_one();
+	}
+}
+
+void JobSystem::submit(JobCounter* dependency, JobCounter& counter,
+	void* function, JobInvoker invoker, const size_t count,
+	const size_t chunk_size)
+{
+	const size_t queue = current_queue();
+	Job* job = allocate(queue);
+	job->invoker = invoker;
+	job->function = function;
+	job->begin = 0;
+	job->end = count;
+	job->chunk_size = chunk_size;
+	job->counter = &counter;
+	counter.state.fetch_add(1, std::memory_order_relaxed);
+
+	if (dependency != nullptr)
+	{
+		// Whoever finishes the last job of the dependency takes the lock
+		// before handing off the dependents, so we can't miss them
+		std::scoped_lock<std::mutex> lock(dependency->mutex);
+		if ((dependency->state.load(std::memory_order_acquire)
+			& PENDING_MASK) != 0)
+		{
+			dependency->dependents.push_back(job);
+			return;
+		}
+	}
+	push(queue, job);
+}
+
+void JobSystem::worker_loop(const size_t queue)
+{
+	current_system = this;
+	current_index = queue;
+
+	uint32_t idle_attempts = 0;
+	while (true)
+	{
+		Job* job = find_job(queue);
+		if (job != nullptr)
+		{
+			execute(queue, job);
+			idle_attempts = 0;
+			continue;
+		}
+		if (stopping.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		if (++idle_attempts < IDLE_ATTEMPTS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		idle_attempts = 0;
+
+		// Announce that we're going to sleep before the last look around,
+		// so that anything pushed after it will wake us up
+		const uint32_t signal = wake_signal.load(std::memory_order_acquire);
+		sleeping_workers.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		job = find_job(queue);
+		if (job == nullptr && !stopping.load(std::memory_order_acquire))
+		{
+			wake_signal.wait(signal, std::memory_order_acquire);
+		}
+		sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+
+		if (job != nullptr)
+		{
+			execute(queue, job);
+		}
+	}
+}
@@ -1,39 +1,25 @@
 #pragma once
 
-#include <windows.h>
+#include <mutex>
 
 /// <summary>
-/// Makes use of the windows critical section to ensure thread safety. This
-/// version must be manually locked and unlocked.
+/// A recursive lock to ensure thread safety, which the same thread can lock
+/// multiple times. This version must be manually locked and unlocked.
 /// </summary>
 class CriticalSection
 {
 public:
-	/// <summary>
-	/// Initialize the critical section.
-	/// </summary>
-	CriticalSection()
-	{
-		InitializeCriticalSection(&critical_section);
-	}
-
+	CriticalSection() = default;
 	CriticalSection(const CriticalSection&) = delete;
 	CriticalSection& operator=(const CriticalSection&) = delete;
-
-	/// <summary>
-	/// Delete the critical section.
-	/// </summary>
-	~CriticalSection()
-	{
-		DeleteCriticalSection(&critical_section);
-	}
+	~CriticalSection() = default;
 
 	/// <summary>
 	/// Lock the critical section.
 	/// </summary>
 	void lock()
 	{
-		EnterCriticalSection(&critical_section);
+		critical_section.lock();
 	}
 
 	/// <summary>
@@ -41,14 +27,14 @@ public:
 	/// </summary>
 	void unlock()
 	{
-		LeaveCriticalSection(&critical_section);
+		critical_section.unlock();
 	}
 	
 protected:
 	/// <summary>
 	/// The actual critical section that we are using.
 	/// </summary>
-	mutable CRITICAL_SECTION critical_section;
+	mutable std::recursive_mutex critical_section;
 };
 
 /// <summary>
@@ -1,9 +1,13 @@
 #include "debugging/logger.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <list>
 #include <map>
 #include <mutex>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 static const char* ERROR_LOG_FILENAME = "log.txt";
 
@@ -254,6 +258,7 @@ LogManager::ErrorDialogResult LogManager::error(
 		}
 	}
 
+#ifdef _WIN32
 	// Show a dialog box, with an error icon, defaulting to abort
 	int response = MessageBoxA(nullptr, buffer.c_str(), tag.c_str(),
 		MB_ABORTRETRYIGNORE | MB_ICONERROR | MB_DEFBUTTON1);
@@ -269,6 +274,16 @@ LogManager::ErrorDialogResult LogManager::error(
 	default:
 		return LogManager::LOG_MANAGER_ERROR_RETRY;
 	}
+#else
+	//NOTE(ches) there is nobody to ask without a dialog, so we keep going
+	// unless the error is fatal
+	fputs(buffer.c_str(), stderr);
+	if (fatal)
+	{
+		std::abort();
+	}
+	return LogManager::LOG_MANAGER_ERROR_IGNORE;
+#endif
 }
 
 void LogManager::output_buffer_to_logs(std::string_view final_buffer,
@@ -276,7 +291,11 @@ void LogManager::output_buffer_to_logs(std::string_view final_buffer,
 {
 	if ((flags & FLAG_WRITE_TO_DEBUGGER) != FLAG_WRITE_NOWHERE)
 	{
+#ifdef _WIN32
 		OutputDebugStringA(final_buffer.data());
+#else
+		fputs(final_buffer.data(), stderr);
+#endif
 	}
 	if ((flags & FLAG_WRITE_TO_LOG_FILE) != FLAG_WRITE_NOWHERE)
 	{